@@ -0,0 +1,470 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+
+//////////////////////////////////////////////////////////////////////
+///
+/// NAME:    bfs
+///
+/// PURPOSE: This program tests the efficiency with which a breadth-first
+///          search traverses the graph of the sparse kernel, i.e. a 2D
+///          torus whose vertices are connected to the points of a star
+///          stencil, stored in compressed sparse row (CSR) form.
+///
+/// USAGE:   The program takes as input the number of searches, the 2log
+///          of the linear size of the 2D grid, the radius of the stencil
+///          and optionally the search direction.
+///
+///          <progname> <# iterations> <2log grid size> <radius>
+///                     [<top-down|bottom-up|hybrid|all>]
+///
+///          The output consists of diagnostics to make sure the
+///          algorithm worked, and of timing statistics.
+///
+/// NOTES:   Every search is run on the canonical ordering of the vertices
+///          and on the ordering scrambled by bit reversal, as in the
+///          sparse kernel with SCRAMBLE, from the same physical sources.
+///
+///          Top-down steps expand a queue of frontier vertices and claim
+///          their neighbors with compare-and-swap on the parent array.
+///          Bottom-up steps let every unvisited vertex look for a parent
+///          in a bitmap of the frontier; each thread owns whole words of
+///          the next bitmap, so no atomics are needed.  The hybrid
+///          (direction-optimizing) search switches to bottom-up when the
+///          edges leaving the frontier exceed 1/alpha of the unexplored
+///          edges and back when the frontier shrinks below 1/beta of the
+///          vertices, with alpha=14 and beta=24.
+///
+///          The depth of every vertex must equal its analytic distance on
+///          the torus, ceil(dx/r)+ceil(dy/r), and its parent must be a
+///          neighbor one level up.  Traversed edges are counted as the
+///          undirected edges of the graph, as in Graph500.  The rate
+///          reported last is that of the last search direction on the
+///          scrambled ordering.
+///
+/// HISTORY: Graph generator based on the sparse kernel.
+///
+//////////////////////////////////////////////////////////////////////
+
+#include "prk_util.h"
+#include "prk_energy.h"
+#include "prk_openmp.h"
+
+#include <atomic>
+
+static inline size_t offset(size_t i, size_t j, size_t lsize)
+{
+    return (i+(j<<lsize));
+}
+
+// see sparse.cc
+static inline uint64_t reverse(uint64_t x, int shift_in_bits)
+{
+  x = ((x >> 1)  & 0x5555555555555555) | ((x << 1)  & 0xaaaaaaaaaaaaaaaa);
+  x = ((x >> 2)  & 0x3333333333333333) | ((x << 2)  & 0xcccccccccccccccc);
+  x = ((x >> 4)  & 0x0f0f0f0f0f0f0f0f) | ((x << 4)  & 0xf0f0f0f0f0f0f0f0);
+  x = ((x >> 8)  & 0x00ff00ff00ff00ff) | ((x << 8)  & 0xff00ff00ff00ff00);
+  x = ((x >> 16) & 0x0000ffff0000ffff) | ((x << 16) & 0xffff0000ffff0000);
+  x = ((x >> 32) & 0x00000000ffffffff) | ((x << 32) & 0xffffffff00000000);
+  return ( x >> (8*sizeof(uint64_t)-shift_in_bits) );
+}
+
+typedef struct {
+    size_t lsize;
+    bool scramble;
+    size_t n;                       // number of vertices
+    std::vector<size_t> row;        // n+1 row offsets
+    std::vector<uint32_t> col;      // neighbors, sorted per row
+
+    // label <-> position on the grid; bit reversal is an involution
+    size_t label(size_t p) const { return scramble ? reverse(p,2*lsize) : p; }
+    size_t position(size_t v) const { return label(v); }
+} csr;
+
+static void build_graph(csr & g, size_t lsize, size_t radius, bool scramble)
+{
+    const size_t size = 1UL << lsize;
+    const size_t degree = 4*radius;
+    g.lsize = lsize;
+    g.scramble = scramble;
+    g.n = size*size;
+    g.row.resize(g.n+1);
+    g.col.resize(g.n*degree);
+
+    OMP_PARALLEL()
+    {
+      OMP_FOR()
+      for (size_t v=0; v<=g.n; v++) {
+          g.row[v] = v*degree;
+      }
+      OMP_FOR()
+      for (size_t v=0; v<g.n; v++) {
+          const size_t p = g.position(v);
+          const size_t i = p % size;
+          const size_t j = p / size;
+          uint32_t * adj = &(g.col[v*degree]);
+          for (size_t r=1; r<=radius; r++, adj+=4) {
+              adj[0] = g.label(offset((i+r)%size,j,lsize));
+              adj[1] = g.label(offset((i-r+size)%size,j,lsize));
+              adj[2] = g.label(offset(i,(j+r)%size,lsize));
+              adj[3] = g.label(offset(i,(j-r+size)%size,lsize));
+          }
+          std::sort(&(g.col[v*degree]), &(g.col[(v+1)*degree]));
+      }
+    }
+}
+
+enum direction { top_down, bottom_up, hybrid };
+
+static const char * direction_name[] = { "top-down", "bottom-up", "hybrid" };
+
+typedef struct {
+    std::vector<std::atomic<int32_t>> parent;
+    std::vector<int32_t> depth;
+    std::vector<uint32_t> queue, next_queue;        // top-down frontier
+    std::vector<uint64_t> bitmap, next_bitmap;      // bottom-up frontier
+    std::vector<size_t> found, found_edges, start;  // per thread
+} workspace;
+
+static inline bool test_bit(const std::vector<uint64_t> & b, size_t v)
+{
+    return (b[v>>6] >> (v&63)) & 1;
+}
+
+// Returns the number of levels searched bottom-up.
+static int bfs(const csr & g, uint32_t source, direction mode, workspace & w)
+{
+    const int64_t alpha(14), beta(24);
+    const size_t n = g.n;
+    const size_t nwords = (n+63)/64;
+    const int nthreads = omp_get_max_threads();
+
+    w.found.resize(nthreads);
+    w.found_edges.resize(nthreads);
+    w.start.resize(nthreads+1);
+
+    // shared search state, updated by the master between levels
+    bool done(false), up(mode==bottom_up);
+    int32_t level(0);
+    int bottom_up_levels(0);
+    size_t frontier(1), queued(1);
+    int64_t unexplored = g.row[n];
+    int64_t scout = g.row[source+1] - g.row[source];
+
+    OMP_PARALLEL()
+    {
+      const int me = omp_get_thread_num();
+      std::vector<uint32_t> local;
+
+      OMP_FOR()
+      for (size_t v=0; v<n; v++) {
+          w.parent[v].store(-1,std::memory_order_relaxed);
+          w.depth[v] = -1;
+      }
+      OMP_MASTER
+      {
+          w.parent[source].store(source,std::memory_order_relaxed);
+          w.depth[source] = 0;
+          w.queue[0] = source;
+          std::fill(w.bitmap.begin(), w.bitmap.end(), 0);
+          w.bitmap[source>>6] |= uint64_t(1) << (source&63);
+      }
+      OMP_BARRIER
+
+      while (!done) {
+
+        size_t found(0), found_edges(0);
+
+        if (!up) {
+          local.clear();
+          OMP_FOR(schedule(dynamic,64) nowait)
+          for (size_t k=0; k<queued; k++) {
+              const uint32_t u = w.queue[k];
+              for (size_t e=g.row[u]; e<g.row[u+1]; e++) {
+                  const uint32_t v = g.col[e];
+                  int32_t unvisited(-1);
+                  if (w.parent[v].load(std::memory_order_relaxed) < 0 &&
+                      w.parent[v].compare_exchange_strong(unvisited,u,std::memory_order_relaxed)) {
+                      w.depth[v] = level+1;
+                      local.push_back(v);
+                      found_edges += g.row[v+1]-g.row[v];
+                  }
+              }
+          }
+          found = local.size();
+          w.found[me] = found;
+          OMP_BARRIER
+          OMP_MASTER
+          {
+              w.start[0] = 0;
+              for (int t=0; t<nthreads; t++) w.start[t+1] = w.start[t] + w.found[t];
+          }
+          OMP_BARRIER
+          std::copy(local.begin(), local.end(), w.next_queue.begin() + w.start[me]);
+        } else {
+          OMP_FOR(schedule(static) nowait)
+          for (size_t word=0; word<nwords; word++) {
+              uint64_t bits(0);
+              const size_t last = std::min(64UL, n-64*word);
+              for (size_t b=0; b<last; b++) {
+                  const size_t v = 64*word+b;
+                  if (w.parent[v].load(std::memory_order_relaxed) >= 0) continue;
+                  for (size_t e=g.row[v]; e<g.row[v+1]; e++) {
+                      const uint32_t u = g.col[e];
+                      if (test_bit(w.bitmap,u)) {
+                          w.parent[v].store(u,std::memory_order_relaxed);
+                          w.depth[v] = level+1;
+                          bits |= uint64_t(1) << b;
+                          found++;
+                          found_edges += g.row[v+1]-g.row[v];
+                          break;
+                      }
+                  }
+              }
+              w.next_bitmap[word] = bits;
+          }
+        }
+        w.found[me] = found;
+        w.found_edges[me] = found_edges;
+        OMP_BARRIER
+
+        OMP_MASTER
+        {
+          const size_t previous = frontier;
+          frontier = 0;
+          scout = 0;
+          for (int t=0; t<nthreads; t++) {
+              frontier += w.found[t];
+              scout += w.found_edges[t];
+          }
+          unexplored -= scout;
+          if (up) bottom_up_levels++;
+          level++;
+
+          if (up) std::swap(w.bitmap, w.next_bitmap);
+          else    std::swap(w.queue, w.next_queue);
+
+          if (frontier == 0) {
+              done = true;
+          } else if (mode == hybrid && !up && scout > unexplored/alpha) {
+              std::fill(w.bitmap.begin(), w.bitmap.end(), 0);
+              for (size_t k=0; k<frontier; k++) {
+                  const uint32_t v = w.queue[k];
+                  w.bitmap[v>>6] |= uint64_t(1) << (v&63);
+              }
+              up = true;
+          } else if (mode == hybrid && up && frontier < previous
+                                          && static_cast<int64_t>(frontier) < static_cast<int64_t>(n)/beta) {
+              size_t k(0);
+              for (size_t word=0; word<nwords; word++) {
+                  for (uint64_t bits=w.bitmap[word]; bits; bits &= bits-1) {
+                      w.queue[k++] = 64*word + __builtin_ctzll(bits);
+                  }
+              }
+              up = false;
+          }
+          queued = frontier;
+        }
+        OMP_BARRIER
+      }
+    }
+    return bottom_up_levels;
+}
+
+// Checks depths against the torus distance and parents against the graph.
+static size_t verify(const csr & g, size_t radius, uint32_t source, const workspace & w)
+{
+    const size_t size = 1UL << g.lsize;
+    const size_t s = g.position(source);
+    const size_t si = s % size, sj = s / size;
+    size_t errors(0);
+
+    OMP_PARALLEL_FOR_REDUCE(+:errors)
+    for (size_t v=0; v<g.n; v++) {
+        const size_t p = g.position(v);
+        const size_t i = p % size, j = p / size;
+        size_t dx = (i > si) ? i-si : si-i;
+        size_t dy = (j > sj) ? j-sj : sj-j;
+        dx = std::min(dx, size-dx);
+        dy = std::min(dy, size-dy);
+        const int32_t expect = (dx+radius-1)/radius + (dy+radius-1)/radius;
+        if (w.depth[v] != expect) {
+            errors++;
+            continue;
+        }
+        const int32_t u = w.parent[v].load(std::memory_order_relaxed);
+        if (v == source) {
+            if (u != static_cast<int32_t>(source)) errors++;
+            continue;
+        }
+        if (u < 0 || w.depth[u] != expect-1 ||
+            !std::binary_search(&(g.col[g.row[v]]), &(g.col[g.row[v+1]]), static_cast<uint32_t>(u))) {
+            errors++;
+        }
+    }
+    return errors;
+}
+
+int main(int argc, char * argv[])
+{
+  std::cout << "Parallel Research Kernels version " << PRKVERSION << std::endl;
+  std::cout << "C++11/OpenMP breadth-first search" << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  /// Read and test input parameters
+  //////////////////////////////////////////////////////////////////////
+
+  int iterations;
+  size_t lsize, radius;
+  std::vector<direction> modes;
+  try {
+      if (argc < 4) {
+        throw "Usage: <# iterations> <2log grid size> <radius> [<top-down|bottom-up|hybrid|all>]";
+      }
+
+      iterations = std::atoi(argv[1]);
+      if (iterations < 1) {
+        throw "ERROR: iterations must be >= 1";
+      }
+
+      lsize = std::atol(argv[2]);
+      if (lsize < 1) {
+        throw "ERROR: grid size must be at least 2";
+      } else if (2*lsize > 30) {
+        throw "ERROR: vertex labels must fit in 31 bits";
+      }
+
+      radius = std::atol(argv[3]);
+      if (radius < 1) {
+        throw "ERROR: stencil radius must be positive";
+      } else if (2*radius+1 > (1UL << lsize)) {
+        throw "ERROR: stencil wraps onto itself";
+      }
+
+      const std::string m = (argc > 4) ? argv[4] : "all";
+      if      (m == "top-down")  modes = { top_down };
+      else if (m == "bottom-up") modes = { bottom_up };
+      else if (m == "hybrid")    modes = { hybrid };
+      else if (m == "all")       modes = { top_down, bottom_up, hybrid };
+      else throw "ERROR: direction must be top-down, bottom-up, hybrid or all";
+  }
+  catch (const char * e) {
+    std::cout << e << std::endl;
+    return 1;
+  }
+
+  const size_t size = 1UL << lsize;
+  const size_t n = size*size;
+  const size_t edges = n*2*radius;
+
+  std::cout << "Number of threads    = " << omp_get_max_threads() << std::endl;
+  std::cout << "Number of searches   = " << iterations << std::endl;
+  std::cout << "Grid size            = " << size << std::endl;
+  std::cout << "Number of vertices   = " << n << std::endl;
+  std::cout << "Undirected edges     = " << edges << std::endl;
+  std::cout << "Stencil radius       = " << radius << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Allocate space and perform the computation
+  //////////////////////////////////////////////////////////////////////
+
+  workspace w;
+  w.parent = std::vector<std::atomic<int32_t>>(n);
+  w.depth.resize(n);
+  w.queue.resize(n);
+  w.next_queue.resize(n);
+  w.bitmap.resize((n+63)/64);
+  w.next_bitmap.resize((n+63)/64);
+
+  std::cout << std::setw(12) << "Ordering"
+            << std::setw(12) << "Direction"
+            << std::setw(12) << "BU levels"
+            << std::setw(14) << "Rate (MTEPS)"
+            << std::setw(16) << "Avg time (s)" << std::endl;
+
+  double teps(0), avgtime(0);
+  prk::energy::meter energy;    // keeps the last case, as does the summary
+
+  for (bool scramble : { false, true }) {
+
+    csr g;
+    build_graph(g, lsize, radius, scramble);
+
+    for (auto mode : modes) {
+
+      double bfs_time{0};
+      int levels{0};
+      energy.start();
+
+      for (int iter = 0; iter<=iterations; iter++) {
+
+        // the same physical sources for both orderings
+        const size_t p = (2654435761UL*iter + 12345) % n;
+        const uint32_t source = g.label(p);
+
+        if (iter>0) energy.skip();
+        const double t0 = prk::wtime();
+        levels = bfs(g, source, mode, w);
+        if (iter>0) {
+          bfs_time += prk::wtime() - t0;
+          energy.sample();
+        }
+
+        const size_t errors = verify(g, radius, source, w);
+        if (errors > 0) {
+          std::cout << "ERROR: " << errors << " vertices have a wrong depth or parent ("
+                    << (scramble ? "scrambled" : "canonical") << ", "
+                    << direction_name[mode] << ", source " << source << ")" << std::endl;
+          return 1;
+        }
+      }
+
+      avgtime = bfs_time/iterations;
+      teps = edges/avgtime;
+      std::cout << std::setw(12) << (scramble ? "scrambled" : "canonical")
+                << std::setw(12) << direction_name[mode]
+                << std::setw(12) << levels
+                << std::setw(14) << 1.e-6*teps
+                << std::setw(16) << avgtime << std::endl;
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // Analyze and output results.
+  //////////////////////////////////////////////////////////////////////
+
+  std::cout << "Solution validates" << std::endl;
+  std::cout << "Rate (MTEPS): " << 1.e-6*teps
+            << " Avg time (s): " << avgtime << std::endl;
+  energy.report(iterations, avgtime*iterations, 1.e-6*edges, "MTE");
+
+  return 0;
+}
@@ -0,0 +1,581 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+//////////////////////////////////////////////////////////////////////
+///
+/// NAME:    cg
+///
+/// PURPOSE: This program tests the efficiency with which the conjugate
+///          gradient method solves a sparse linear system, i.e. how well
+///          sparse matrix-vector products, vector updates and the global
+///          reductions between them compose.
+///
+/// USAGE:   The program takes as input the number of CG iterations, the
+///          2log of the linear size of the 2D grid (equalling the 2log of
+///          the square root of the order of the sparse matrix) and the
+///          radius of the difference stencil.
+///
+///          <progname> <# iterations> <2log root-of-matrix-order> <radius>
+///
+///          The output consists of diagnostics to make sure the
+///          algorithm worked, and of timing statistics.
+///
+/// NOTES:   The matrix has the star-stencil pattern of the sparse kernel
+///          (canonical indexing) with 4r+1 on the diagonal and -1 off it.
+///          It is symmetric positive definite with eigenvalues in [1,8r+1].
+///          The right-hand side is A*x for a known x.  Three variants run
+///          the same number of iterations from x=0:
+///            naive     - one loop per vector operation, two reductions
+///            fused     - SpMV fused with p.Ap and the x/r updates fused
+///                        with r.r; still two reductions
+///            pipelined - Ghysels and Vanroose (2014): both dot products
+///                        in one reduction, whose combination is deferred
+///                        until after the next SpMV
+///          Reductions use per-thread partial sums combined in thread order,
+///          so all threads see the same value.  The error of each solution
+///          is checked against the CG convergence bound.
+///
+/// HISTORY: Matrix setup follows the sparse kernel written by
+///          Rob Van der Wijngaart, August 2009.
+///
+//////////////////////////////////////////////////////////////////////
+
+#include "prk_util.h"
+#include "prk_energy.h"
+#include "prk_openmp.h"
+
+static inline size_t offset(size_t i, size_t j, size_t lsize)
+{
+    return (i+(j<<lsize));
+}
+
+// per-thread partial sums are padded to a cache line
+static const int PAD = 8;
+
+struct cg_stats {
+    double time;
+    long   reductions;
+    long   barriers;
+    prk::energy::meter energy;
+};
+
+class cg_matrix {
+
+    public:
+
+        size_t n;
+        size_t stencil_size;
+        prk::vector<double> values;
+        prk::vector<size_t> colIndex;
+
+        cg_matrix(int lsize, int radius) : n(size_t(1)<<(2*lsize)), stencil_size(4*radius+1),
+                                           values(n*stencil_size), colIndex(n*stencil_size)
+        {
+            const size_t size = size_t(1)<<lsize;
+            for (size_t row=0; row<n; row++) {
+                size_t i = row % size;
+                size_t j = row / size;
+                size_t elm = row*stencil_size;
+                colIndex[elm] = offset(i,j,lsize);
+                for (int r=1; r<=radius; r++, elm+=4) {
+                    colIndex[elm+1] = offset((i+r)%size,j,lsize);
+                    colIndex[elm+2] = offset((i-r+size)%size,j,lsize);
+                    colIndex[elm+3] = offset(i,(j+r)%size,lsize);
+                    colIndex[elm+4] = offset(i,(j-r+size)%size,lsize);
+                }
+                std::sort(&(colIndex[row*stencil_size]), &(colIndex[(row+1)*stencil_size]));
+                for (size_t elm=row*stencil_size; elm<(row+1)*stencil_size; elm++) {
+                    values[elm] = (colIndex[elm] == row) ? static_cast<double>(stencil_size) : -1.0;
+                }
+            }
+        }
+
+        double row_times(size_t row, const double * RESTRICT x) const
+        {
+            double temp(0);
+            PRAGMA_SIMD
+            for (size_t col=stencil_size*row; col<stencil_size*(row+1); col++) {
+                temp += values[col]*x[colIndex[col]];
+            }
+            return temp;
+        }
+};
+
+// Combines the partial sums of all threads in thread order.  Consecutive
+// reductions alternate between two buffers, so a buffer is never rewritten
+// before every thread has read it.
+class reducer {
+
+    private:
+        std::vector<double> & buf_;
+        int nt_;
+        int me_;
+        long count_;
+
+    public:
+
+        reducer(std::vector<double> & buf, int nt, int me) : buf_(buf), nt_(nt), me_(me), count_(0) {}
+
+        double * partial() { return &buf_[((count_%2)*nt_ + me_)*PAD]; }
+
+        // all threads must have published their partials (i.e. passed a barrier)
+        void combine(double * sum, int m)
+        {
+            const double * b = &buf_[(count_%2)*nt_*PAD];
+            for (int k=0; k<m; k++) sum[k] = 0.0;
+            for (int t=0; t<nt_; t++) {
+                for (int k=0; k<m; k++) sum[k] += b[t*PAD+k];
+            }
+            count_++;
+        }
+
+        long count() const { return count_; }
+};
+
+static void cg_naive(const cg_matrix & A, const double * b, double * x, int iterations, cg_stats & stats)
+{
+    const size_t n = A.n;
+    prk::vector<double> r(n), p(n), q(n);
+    std::vector<double> buf(2*omp_get_max_threads()*PAD);
+    long barriers = 0;
+
+    OMP_PARALLEL()
+    {
+        reducer red(buf, omp_get_num_threads(), omp_get_thread_num());
+        long red0 = 0;
+        double rr, pq, rr_new;
+
+        OMP_FOR( schedule(static) nowait )
+        for (size_t i=0; i<n; i++) {
+            x[i] = 0.0;
+            r[i] = b[i];
+            p[i] = b[i];
+        }
+        {
+            double * s = red.partial();
+            s[0] = 0.0;
+            OMP_FOR( schedule(static) nowait )
+            for (size_t i=0; i<n; i++) s[0] += r[i]*r[i];
+        }
+        OMP_BARRIER
+        red.combine(&rr, 1);
+
+        for (int iter=0; iter<=iterations; iter++) {
+
+            if (iter==1) {
+                OMP_BARRIER
+                OMP_MASTER
+                {
+                    stats.time = prk::wtime();
+                    stats.energy.start();
+                    barriers = 0;
+                }
+                red0 = red.count();
+            }
+
+            // q = A p
+            OMP_FOR( schedule(static) )
+            for (size_t i=0; i<n; i++) q[i] = A.row_times(i, p.data());
+
+            // pq = p.q
+            {
+                double * s = red.partial();
+                s[0] = 0.0;
+                OMP_FOR( schedule(static) nowait )
+                for (size_t i=0; i<n; i++) s[0] += p[i]*q[i];
+            }
+            OMP_BARRIER
+            red.combine(&pq, 1);
+            const double alpha = rr/pq;
+
+            // x += alpha p
+            OMP_FOR( schedule(static) )
+            for (size_t i=0; i<n; i++) x[i] += alpha*p[i];
+
+            // r -= alpha q
+            OMP_FOR( schedule(static) )
+            for (size_t i=0; i<n; i++) r[i] -= alpha*q[i];
+
+            // rr = r.r
+            {
+                double * s = red.partial();
+                s[0] = 0.0;
+                OMP_FOR( schedule(static) nowait )
+                for (size_t i=0; i<n; i++) s[0] += r[i]*r[i];
+            }
+            OMP_BARRIER
+            red.combine(&rr_new, 1);
+            const double beta = rr_new/rr;
+            rr = rr_new;
+
+            // p = r + beta p
+            OMP_FOR( schedule(static) )
+            for (size_t i=0; i<n; i++) p[i] = r[i] + beta*p[i];
+
+            OMP_MASTER
+            barriers += 6;
+        }
+        OMP_BARRIER
+        OMP_MASTER
+        {
+            stats.time = prk::wtime() - stats.time;
+            stats.energy.stop();
+            stats.reductions = red.count() - red0;
+            stats.barriers = barriers;
+        }
+    }
+}
+
+static void cg_fused(const cg_matrix & A, const double * b, double * x, int iterations, cg_stats & stats)
+{
+    const size_t n = A.n;
+    prk::vector<double> r(n), p(n), q(n);
+    std::vector<double> buf(2*omp_get_max_threads()*PAD);
+    long barriers = 0;
+
+    OMP_PARALLEL()
+    {
+        reducer red(buf, omp_get_num_threads(), omp_get_thread_num());
+        long red0 = 0;
+        double rr, pq, rr_new;
+
+        {
+            double * s = red.partial();
+            s[0] = 0.0;
+            OMP_FOR( schedule(static) nowait )
+            for (size_t i=0; i<n; i++) {
+                x[i] = 0.0;
+                r[i] = b[i];
+                p[i] = b[i];
+                s[0] += r[i]*r[i];
+            }
+        }
+        OMP_BARRIER
+        red.combine(&rr, 1);
+
+        for (int iter=0; iter<=iterations; iter++) {
+
+            if (iter==1) {
+                OMP_BARRIER
+                OMP_MASTER
+                {
+                    stats.time = prk::wtime();
+                    stats.energy.start();
+                    barriers = 0;
+                }
+                red0 = red.count();
+            }
+
+            // q = A p and pq = p.q in one pass
+            {
+                double * s = red.partial();
+                s[0] = 0.0;
+                OMP_FOR( schedule(static) nowait )
+                for (size_t i=0; i<n; i++) {
+                    const double qi = A.row_times(i, p.data());
+                    q[i] = qi;
+                    s[0] += p[i]*qi;
+                }
+            }
+            OMP_BARRIER
+            red.combine(&pq, 1);
+            const double alpha = rr/pq;
+
+            // x += alpha p, r -= alpha q and rr = r.r in one pass
+            {
+                double * s = red.partial();
+                s[0] = 0.0;
+                OMP_FOR( schedule(static) nowait )
+                for (size_t i=0; i<n; i++) {
+                    x[i] += alpha*p[i];
+                    const double ri = r[i] - alpha*q[i];
+                    r[i] = ri;
+                    s[0] += ri*ri;
+                }
+            }
+            OMP_BARRIER
+            red.combine(&rr_new, 1);
+            const double beta = rr_new/rr;
+            rr = rr_new;
+
+            // p = r + beta p; the next SpMV reads other threads' rows
+            OMP_FOR( schedule(static) )
+            for (size_t i=0; i<n; i++) p[i] = r[i] + beta*p[i];
+
+            OMP_MASTER
+            barriers += 3;
+        }
+        OMP_BARRIER
+        OMP_MASTER
+        {
+            stats.time = prk::wtime() - stats.time;
+            stats.energy.stop();
+            stats.reductions = red.count() - red0;
+            stats.barriers = barriers;
+        }
+    }
+}
+
+static void cg_pipelined(const cg_matrix & A, const double * b, double * x, int iterations, cg_stats & stats)
+{
+    const size_t n = A.n;
+    // w is double buffered so the SpMV of one iteration and the updates
+    // of the same rows need no barrier in between
+    prk::vector<double> r(n), w0(n), w1(n), z(n), s(n), p(n), m(n);
+    std::vector<double> buf(2*omp_get_max_threads()*PAD);
+    long barriers = 0;
+
+    OMP_PARALLEL()
+    {
+        reducer red(buf, omp_get_num_threads(), omp_get_thread_num());
+        long red0 = 0;
+        double * w  = w0.data();
+        double * wn = w1.data();
+        double gamma_old{0}, alpha_old{0};
+
+        // x = 0, r = b
+        OMP_FOR( schedule(static) )
+        for (size_t i=0; i<n; i++) {
+            x[i] = 0.0;
+            r[i] = b[i];
+            z[i] = s[i] = p[i] = 0.0;
+        }
+        // w = A r, gamma = r.r, delta = w.r
+        {
+            double * part = red.partial();
+            part[0] = part[1] = 0.0;
+            OMP_FOR( schedule(static) nowait )
+            for (size_t i=0; i<n; i++) {
+                w[i] = A.row_times(i, r.data());
+                part[0] += r[i]*r[i];
+                part[1] += w[i]*r[i];
+            }
+        }
+        OMP_BARRIER
+
+        for (int iter=0; iter<=iterations; iter++) {
+
+            if (iter==1) {
+                OMP_MASTER
+                {
+                    stats.time = prk::wtime();
+                    stats.energy.start();
+                    barriers = 0;
+                }
+                red0 = red.count();
+            }
+
+            // m = A w, overlapping the combination of the partial sums
+            OMP_FOR( schedule(static) nowait )
+            for (size_t i=0; i<n; i++) m[i] = A.row_times(i, w);
+
+            double gd[2];
+            red.combine(gd, 2);
+            const double gamma = gd[0];
+            const double delta = gd[1];
+            double alpha, beta;
+            if (iter == 0) {
+                beta  = 0.0;
+                alpha = gamma/delta;
+            } else {
+                beta  = gamma/gamma_old;
+                alpha = gamma/(delta - beta*gamma/alpha_old);
+            }
+            gamma_old = gamma;
+            alpha_old = alpha;
+
+            // all vector updates and both dot products in one pass over own rows
+            {
+                double * part = red.partial();
+                double g(0), d(0);
+                OMP_FOR( schedule(static) nowait )
+                for (size_t i=0; i<n; i++) {
+                    const double zi = m[i] + beta*z[i];
+                    const double si = w[i] + beta*s[i];
+                    const double pi = r[i] + beta*p[i];
+                    z[i] = zi;
+                    s[i] = si;
+                    p[i] = pi;
+                    x[i] += alpha*pi;
+                    const double ri = r[i] - alpha*si;
+                    const double wi = w[i] - alpha*zi;
+                    r[i]  = ri;
+                    wn[i] = wi;
+                    g += ri*ri;
+                    d += wi*ri;
+                }
+                part[0] = g;
+                part[1] = d;
+            }
+            std::swap(w, wn);
+            // publishes the partials and the new w for the next SpMV
+            OMP_BARRIER
+            OMP_MASTER
+            barriers += 1;
+        }
+        OMP_MASTER
+        {
+            stats.time = prk::wtime() - stats.time;
+            stats.energy.stop();
+            stats.reductions = red.count() - red0;
+            stats.barriers = barriers;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+  std::cout << "Parallel Research Kernels version " << PRKVERSION << std::endl;
+  std::cout << "C++11/OpenMP Conjugate gradient" << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Process and test input parameters
+  //////////////////////////////////////////////////////////////////////
+
+  int iterations, lsize, radius;
+  size_t size, size2, nent;
+  try {
+      if (argc < 4) {
+        throw "Usage: <# iterations> <2log grid size> <stencil radius>";
+      }
+
+      // number of CG iterations
+      iterations  = std::atoi(argv[1]);
+      if (iterations < 1) {
+        throw "ERROR: iterations must be >= 1";
+      }
+
+      // linear grid dimension
+      lsize  = std::atoi(argv[2]);
+      if (lsize < 1) {
+        throw "ERROR: grid dimension must be positive";
+      }
+      size = 1L<<lsize;
+      size2 = size*size;
+
+      // stencil radius
+      radius = std::atoi(argv[3]);
+      if (radius < 1 || static_cast<size_t>(2*radius+1) > size) {
+        throw "ERROR: Stencil radius must be positive and smaller than the grid";
+      }
+
+      nent = size2 * (4*radius+1);
+  }
+  catch (const char * e) {
+    std::cout << e << std::endl;
+    return 1;
+  }
+
+  std::cout << "Number of threads    = " << omp_get_max_threads() << std::endl;
+  std::cout << "Number of iterations = " << iterations << std::endl;
+  std::cout << "Matrix order         = " << size2 << std::endl;
+  std::cout << "Stencil diameter     = " << 2*radius+1 << std::endl;
+  std::cout << "Condition number     = " << 8*radius+1 << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Allocate space and perform the computation
+  //////////////////////////////////////////////////////////////////////
+
+  cg_matrix A(lsize, radius);
+
+  prk::vector<double> xref(size2), b(size2), x(size2);
+  for (size_t i=0; i<size2; i++) {
+      xref[i] = 1.0 + static_cast<double>(i%23)/23.0;
+  }
+  for (size_t i=0; i<size2; i++) {
+      b[i] = A.row_times(i, xref.data());
+  }
+  double xnorm(0);
+  for (size_t i=0; i<size2; i++) {
+      xnorm += xref[i]*xref[i];
+  }
+  xnorm = std::sqrt(xnorm);
+
+  // ||x_k - x|| <= 2 sqrt(kappa) ((sqrt(kappa)-1)/(sqrt(kappa)+1))^k ||x||,
+  // plus room for rounding, which the pipelined recurrences amplify
+  const double kappa = 8.0*radius+1.0;
+  const double rate  = (std::sqrt(kappa)-1.0)/(std::sqrt(kappa)+1.0);
+  const double bound = 2.0*std::sqrt(kappa)*std::pow(rate,iterations+1) + 1.e-8;
+
+  const char * names[3] = { "naive", "fused", "pipelined" };
+  // vector flops per iteration besides the SpMV
+  const double vector_flops[3] = { 10.0, 10.0, 16.0 };
+  cg_stats stats[3];
+  bool valid = true;
+
+  for (int v=0; v<3; v++) {
+      switch (v) {
+          case 0: cg_naive(A, b.data(), x.data(), iterations, stats[v]); break;
+          case 1: cg_fused(A, b.data(), x.data(), iterations, stats[v]); break;
+          case 2: cg_pipelined(A, b.data(), x.data(), iterations, stats[v]); break;
+      }
+      double error(0);
+      for (size_t i=0; i<size2; i++) {
+          error += (x[i]-xref[i])*(x[i]-xref[i]);
+      }
+      error = std::sqrt(error)/xnorm;
+      if (error > bound) {
+          std::cout << "ERROR: " << names[v] << " relative error = " << error
+                    << " bound = " << bound << std::endl;
+          valid = false;
+      }
+#ifdef VERBOSE
+      std::cout << names[v] << " relative error = " << error << std::endl;
+#endif
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // Analyze and output results.
+  //////////////////////////////////////////////////////////////////////
+
+  if (!valid) {
+    return 1;
+  } else {
+    std::cout << "Solution validates" << std::endl;
+    std::cout << "Variant    Reductions/iter  Barriers/iter  Rate (MFlops/s)  Time/iter (s)" << std::endl;
+    for (int v=0; v<3; v++) {
+      double avgtime = stats[v].time/iterations;
+      double flops = 2.0*nent + vector_flops[v]*size2;
+      std::cout << std::left << std::setw(11) << names[v] << std::right
+                << std::setw(15) << static_cast<double>(stats[v].reductions)/iterations
+                << std::setw(15) << static_cast<double>(stats[v].barriers)/iterations
+                << std::setw(17) << 1.0e-6 * flops/avgtime
+                << std::setw(15) << avgtime << std::endl;
+    }
+    for (int v=0; v<3; v++) {
+      if (!stats[v].energy.available()) continue;
+      std::cout << std::left << std::setw(11) << names[v] << std::right;
+      stats[v].energy.report(iterations, stats[v].time, 1.0e-6 * (2.0*nent + vector_flops[v]*size2), "MFlop");
+    }
+  }
+
+  return 0;
+}
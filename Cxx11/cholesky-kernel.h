@@ -0,0 +1,140 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CHOLESKY_KERNEL_H
+#define CHOLESKY_KERNEL_H
+
+// Tile kernels and setup shared by the tiled Cholesky factorizations.
+// The matrix is stored by tiles: tile (i,j) of an nt x nt grid of nb x nb
+// tiles is contiguous and row-major.  Only the lower triangle is used.
+
+// A = L L^T for a diagonal tile
+inline void potrf_tile(const int nb, double * RESTRICT A)
+{
+    for (int j=0; j<nb; ++j) {
+        double d = A[j*nb+j];
+        for (int k=0; k<j; ++k) d -= A[j*nb+k]*A[j*nb+k];
+        d = std::sqrt(d);
+        A[j*nb+j] = d;
+        for (int i=j+1; i<nb; ++i) {
+            double s = A[i*nb+j];
+            PRAGMA_SIMD
+            for (int k=0; k<j; ++k) s -= A[i*nb+k]*A[j*nb+k];
+            A[i*nb+j] = s/d;
+        }
+    }
+}
+
+// B = B L^-T, with L the factored diagonal tile
+inline void trsm_tile(const int nb, const double * RESTRICT L, double * RESTRICT B)
+{
+    for (int i=0; i<nb; ++i) {
+        for (int j=0; j<nb; ++j) {
+            double s = B[i*nb+j];
+            PRAGMA_SIMD
+            for (int k=0; k<j; ++k) s -= B[i*nb+k]*L[j*nb+k];
+            B[i*nb+j] = s/L[j*nb+j];
+        }
+    }
+}
+
+// C = C - A B^T, i.e. the dgemm tile kernel with B transposed, so that
+// both operands are read along rows
+inline void gemm_tile(const int nb, const double * RESTRICT A, const double * RESTRICT B, double * RESTRICT C)
+{
+    for (int i=0; i<nb; ++i) {
+        for (int j=0; j<nb; ++j) {
+            double s(0);
+            PRAGMA_SIMD
+            for (int k=0; k<nb; ++k) s += A[i*nb+k]*B[j*nb+k];
+            C[i*nb+j] -= s;
+        }
+    }
+}
+
+// C = C - A A^T, lower triangle of a diagonal tile
+inline void syrk_tile(const int nb, const double * RESTRICT A, double * RESTRICT C)
+{
+    for (int i=0; i<nb; ++i) {
+        for (int j=0; j<=i; ++j) {
+            double s(0);
+            PRAGMA_SIMD
+            for (int k=0; k<nb; ++k) s += A[i*nb+k]*A[j*nb+k];
+            C[i*nb+j] -= s;
+        }
+    }
+}
+
+// Symmetric, strictly diagonally dominant, hence positive definite:
+// a(i,j) = 1/(1+|i-j|) + n delta(i,j)
+inline double cholesky_matrix(const int n, const int i, const int j)
+{
+    return 1.0/(1.0+std::abs(i-j)) + ((i==j) ? n : 0.0);
+}
+
+inline void cholesky_init(const int nt, const int nb, double * RESTRICT T)
+{
+    const int n = nt*nb;
+    for (int it=0; it<nt; ++it) {
+      for (int jt=0; jt<=it; ++jt) {
+        double * tile = &T[(static_cast<size_t>(it)*nt+jt)*nb*nb];
+        for (int i=0; i<nb; ++i) {
+          for (int j=0; j<nb; ++j) {
+            tile[i*nb+j] = cholesky_matrix(n, it*nb+i, jt*nb+j);
+          }
+        }
+      }
+    }
+}
+
+// ||A - L L^T||_F / ||A||_F over the lower triangle
+inline double cholesky_residual(const int nt, const int nb, const double * RESTRICT T)
+{
+    const int n = nt*nb;
+    auto L = [&](int i, int j) {
+        return (j>i) ? 0.0 : T[((static_cast<size_t>(i/nb))*nt+(j/nb))*nb*nb + (i%nb)*nb + (j%nb)];
+    };
+    std::vector<double> row(n);
+    double rnorm(0), anorm(0);
+    for (int i=0; i<n; ++i) {
+        for (int k=0; k<=i; ++k) row[k] = L(i,k);
+        for (int j=0; j<=i; ++j) {
+            double s(0);
+            for (int k=0; k<=j; ++k) s += row[k]*L(j,k);
+            const double a = cholesky_matrix(n,i,j);
+            rnorm += (a-s)*(a-s);
+            anorm += a*a;
+        }
+    }
+    return std::sqrt(rnorm/anorm);
+}
+
+#endif /* CHOLESKY_KERNEL_H */
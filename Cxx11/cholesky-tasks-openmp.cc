@@ -0,0 +1,229 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+//////////////////////////////////////////////////////////////////////
+///
+/// NAME:    cholesky
+///
+/// PURPOSE: This program measures the rate at which a tiled Cholesky
+///          factorization A = L L^T runs as a graph of tile tasks, whose
+///          trailing updates are the dgemm tile kernel.
+///
+/// USAGE:   The program takes as input the matrix order, the number of
+///          times the factorization is repeated, and optionally the tile
+///          size and the lookahead depth.
+///
+///          <progname> <# iterations> <matrix order> [<tile size> <lookahead>]
+///
+///          The output consists of diagnostics to make sure the
+///          algorithm worked, and of timing statistics.
+///
+/// NOTES:   Step k runs POTRF on tile (k,k), TRSM on tiles (i,k), SYRK on
+///          (i,i) and GEMM on (i,j) for i>j>k.  Panel tasks have the highest
+///          priority, updates of the next <lookahead> columns the next, and
+///          the rest of the trailing matrix the lowest.  The result is
+///          checked with ||A - L L^T||_F / ||A||_F and the rate is compared
+///          with that of the GEMM tiles of the first trailing update, run on
+///          their own with the same tile kernel and tile size.
+///
+///          Tasks are OpenMP tasks with depend clauses on the tiles; the
+///          priority clause only has an effect when OMP_MAX_TASK_PRIORITY
+///          is set to at least 2.
+///
+/// HISTORY: Tile kernels follow the dgemm kernel by Rob Van der Wijngaart.
+///
+//////////////////////////////////////////////////////////////////////
+
+#include "prk_util.h"
+#include "prk_energy.h"
+#include "prk_openmp.h"
+#include "cholesky-kernel.h"
+
+int main(int argc, char * argv[])
+{
+  //////////////////////////////////////////////////////////////////////
+  /// Read and test input parameters
+  //////////////////////////////////////////////////////////////////////
+
+  std::cout << "Parallel Research Kernels version " << PRKVERSION << std::endl;
+  std::cout << "C++11/OpenMP TASKS tiled Cholesky factorization: A = L L^T" << std::endl;
+
+  int iterations;
+  int order;
+  int tile_size;
+  int lookahead;
+  try {
+      if (argc < 3) {
+        throw "Usage: <# iterations> <matrix order> [<tile size> <lookahead>]";
+      }
+
+      iterations  = std::atoi(argv[1]);
+      if (iterations < 1) {
+        throw "ERROR: iterations must be >= 1";
+      }
+
+      order = std::atoi(argv[2]);
+      if (order <= 0) {
+        throw "ERROR: Matrix Order must be greater than 0";
+      } else if (order > prk::get_max_matrix_size()) {
+        throw "ERROR: matrix dimension too large - overflow risk";
+      }
+
+      tile_size = (argc>3) ? std::atoi(argv[3]) : 64;
+      if (tile_size <= 0) tile_size = order;
+      if (order % tile_size != 0) {
+        throw "ERROR: matrix order must be a multiple of the tile size";
+      }
+
+      lookahead = (argc>4) ? std::atoi(argv[4]) : 1;
+      if (lookahead < 0) {
+        throw "ERROR: lookahead must be non-negative";
+      }
+  }
+  catch (const char * e) {
+    std::cout << e << std::endl;
+    return 1;
+  }
+
+  std::cout << "Number of threads     = " << omp_get_max_threads() << std::endl;
+  std::cout << "Number of iterations  = " << iterations << std::endl;
+  std::cout << "Matrix order          = " << order << std::endl;
+  std::cout << "Tile size             = " << tile_size << std::endl;
+  std::cout << "Lookahead             = " << lookahead << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Allocate space for the matrix
+  //////////////////////////////////////////////////////////////////////
+
+  const int nb = tile_size;
+  const int nt = order / nb;
+  const size_t tile_words = static_cast<size_t>(nb)*nb;
+
+  prk::vector<double> T(static_cast<size_t>(nt)*nt*tile_words, 0.0);
+  auto tile = [&](int i, int j) { return &T[(static_cast<size_t>(i)*nt+j)*tile_words]; };
+
+  double chol_time{0};
+  prk::energy::meter energy;
+  energy.start();
+
+  for (int iter = 0; iter<=iterations; iter++) {
+
+    cholesky_init(nt, nb, T.data());
+
+    if (iter>0) energy.skip();
+    double t0 = prk::wtime();
+
+    OMP_PARALLEL()
+    OMP_MASTER
+    {
+      for (int k=0; k<nt; ++k) {
+        double * Akk = tile(k,k);
+        OMP_TASK( depend(inout: Akk[0]) priority(2) )
+        potrf_tile(nb, Akk);
+
+        for (int i=k+1; i<nt; ++i) {
+          double * Aik = tile(i,k);
+          OMP_TASK( depend(in: Akk[0]) depend(inout: Aik[0]) priority(2) )
+          trsm_tile(nb, Akk, Aik);
+        }
+
+        for (int i=k+1; i<nt; ++i) {
+          const double * Aik = tile(i,k);
+          const int near = (i-k <= lookahead) ? 1 : 0;
+          for (int j=k+1; j<i; ++j) {
+            const double * Ajk = tile(j,k);
+            double * Aij = tile(i,j);
+            const int prio = (j-k <= lookahead) ? 1 : 0;
+            OMP_TASK( depend(in: Aik[0], Ajk[0]) depend(inout: Aij[0]) priority(prio) )
+            gemm_tile(nb, Aik, Ajk, Aij);
+          }
+          double * Aii = tile(i,i);
+          OMP_TASK( depend(in: Aik[0]) depend(inout: Aii[0]) priority(near) )
+          syrk_tile(nb, Aik, Aii);
+        }
+      }
+      OMP_TASKWAIT
+    }
+
+    if (iter>0) {
+      chol_time += prk::wtime() - t0;
+      energy.sample();
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  /// Analyze and output results
+  //////////////////////////////////////////////////////////////////////
+
+  const double residual = cholesky_residual(nt, nb, T.data());
+  const double epsilon = 1.0e-12;
+  if (residual > epsilon) {
+    std::cout << "ERROR: ||A - L L^T|| / ||A|| = " << residual
+              << " exceeds threshold " << epsilon << std::endl;
+    return 1;
+  } else {
+    std::cout << "Solution validates" << std::endl;
+#ifdef VERBOSE
+    std::cout << "||A - L L^T|| / ||A|| = " << residual << std::endl;
+#endif
+    const double avgtime = chol_time/iterations;
+    const double nflops = static_cast<double>(order)*order*order/3.0;
+
+    std::cout << "Rate (MF/s): " << 1.0e-6 * nflops/avgtime
+              << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, chol_time, 1.0e-6 * nflops, "MFlop");
+
+    // GEMM tiles of the first trailing update alone, best of <iterations>
+    const double ntiles = 0.5*(nt-1.0)*(nt-2.0);
+    if (ntiles > 0) {
+      prk::vector<double> C(T.size(), 0.0);
+      double update_time{1.e30};
+      for (int r=0; r<iterations; r++) {
+        double t = prk::wtime();
+        OMP_PARALLEL()
+        {
+          OMP_FOR( schedule(dynamic) )
+          for (int i=1; i<nt; ++i) {
+            for (int j=1; j<i; ++j) {
+              gemm_tile(nb, tile(i,0), tile(j,0), &C[(static_cast<size_t>(i)*nt+j)*tile_words]);
+            }
+          }
+        }
+        update_time = std::min(update_time, prk::wtime() - t);
+      }
+      const double update_rate = 1.0e-9 * ntiles * 2.0*nb*nb*nb/update_time;
+      std::cout << "Trailing update rate (GF/s): " << update_rate
+                << " Fraction of update rate: " << 1.0e-9 * nflops/avgtime/update_rate << std::endl;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,254 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+//////////////////////////////////////////////////////////////////////
+///
+/// NAME:    cholesky
+///
+/// PURPOSE: This program measures the rate at which a tiled Cholesky
+///          factorization A = L L^T runs as a graph of tile tasks, whose
+///          trailing updates are the dgemm tile kernel.
+///
+/// USAGE:   The program takes as input the matrix order, the number of
+///          times the factorization is repeated, and optionally the tile
+///          size and the lookahead depth.
+///
+///          <progname> <# iterations> <matrix order> [<tile size> <lookahead>]
+///
+///          The output consists of diagnostics to make sure the
+///          algorithm worked, and of timing statistics.
+///
+/// NOTES:   Step k runs POTRF on tile (k,k), TRSM on tiles (i,k), SYRK on
+///          (i,i) and GEMM on (i,j) for i>j>k.  Panel tasks have the highest
+///          priority, updates of the next <lookahead> columns the next, and
+///          the rest of the trailing matrix the lowest.  The result is
+///          checked with ||A - L L^T||_F / ||A||_F and the rate is compared
+///          with that of the GEMM tiles of the first trailing update, run on
+///          their own with the same tile kernel and tile size.
+///
+///          Tasks are continue_nodes of a TBB flow graph with an edge for
+///          every tile dependency; the graph is built once and reused.
+///          Node priorities require oneTBB 2021 or later.
+///
+/// HISTORY: Tile kernels follow the dgemm kernel by Rob Van der Wijngaart.
+///
+//////////////////////////////////////////////////////////////////////
+
+#include "prk_util.h"
+#include "prk_energy.h"
+#include "prk_tbb.h"
+#include "cholesky-kernel.h"
+
+#include <memory>
+
+typedef tbb::flow::continue_node< tbb::flow::continue_msg > task_node_t;
+
+#if defined(TBB_VERSION_MAJOR) && (TBB_VERSION_MAJOR >= 2021)
+# define PRK_NODE(g, prio, body) std::make_unique<task_node_t>(g, body, tbb::flow::node_priority_t(prio))
+#else
+# define PRK_NODE(g, prio, body) std::make_unique<task_node_t>(g, body)
+#endif
+
+int main(int argc, char * argv[])
+{
+  //////////////////////////////////////////////////////////////////////
+  /// Read and test input parameters
+  //////////////////////////////////////////////////////////////////////
+
+  std::cout << "Parallel Research Kernels version " << PRKVERSION << std::endl;
+  std::cout << "C++11/TBB Flow Graph tiled Cholesky factorization: A = L L^T" << std::endl;
+
+  int iterations;
+  int order;
+  int tile_size;
+  int lookahead;
+  try {
+      if (argc < 3) {
+        throw "Usage: <# iterations> <matrix order> [<tile size> <lookahead>]";
+      }
+
+      iterations  = std::atoi(argv[1]);
+      if (iterations < 1) {
+        throw "ERROR: iterations must be >= 1";
+      }
+
+      order = std::atoi(argv[2]);
+      if (order <= 0) {
+        throw "ERROR: Matrix Order must be greater than 0";
+      } else if (order > prk::get_max_matrix_size()) {
+        throw "ERROR: matrix dimension too large - overflow risk";
+      }
+
+      tile_size = (argc>3) ? std::atoi(argv[3]) : 64;
+      if (tile_size <= 0) tile_size = order;
+      if (order % tile_size != 0) {
+        throw "ERROR: matrix order must be a multiple of the tile size";
+      }
+
+      lookahead = (argc>4) ? std::atoi(argv[4]) : 1;
+      if (lookahead < 0) {
+        throw "ERROR: lookahead must be non-negative";
+      }
+  }
+  catch (const char * e) {
+    std::cout << e << std::endl;
+    return 1;
+  }
+
+  const char* envvar = std::getenv("TBB_NUM_THREADS");
+  int num_threads = (envvar!=NULL) ? std::atoi(envvar) : prk::get_num_cores();
+  tbb::global_control c(tbb::global_control::max_allowed_parallelism, num_threads);
+
+  std::cout << "Number of threads     = " << num_threads << std::endl;
+  std::cout << "Number of iterations  = " << iterations << std::endl;
+  std::cout << "Matrix order          = " << order << std::endl;
+  std::cout << "Tile size             = " << tile_size << std::endl;
+  std::cout << "Lookahead             = " << lookahead << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Allocate space for the matrix and build the task graph
+  //////////////////////////////////////////////////////////////////////
+
+  const int nb = tile_size;
+  const int nt = order / nb;
+  const size_t tile_words = static_cast<size_t>(nb)*nb;
+
+  prk::vector<double> T(static_cast<size_t>(nt)*nt*tile_words, 0.0);
+  double * Tp = T.data();
+  auto tile = [=](int i, int j) { return &Tp[(static_cast<size_t>(i)*nt+j)*tile_words]; };
+
+  tbb::flow::graph g;
+  std::vector<std::unique_ptr<task_node_t>> potrf(nt);
+  std::vector<std::unique_ptr<task_node_t>> trsm(nt*nt);                  // (i,k)
+  std::vector<std::unique_ptr<task_node_t>> syrk(nt*nt);                  // (i,k)
+  std::vector<std::unique_ptr<task_node_t>> gemm(static_cast<size_t>(nt)*nt*nt); // (i,j,k)
+  auto ik  = [=](int i, int k) { return static_cast<size_t>(i)*nt+k; };
+  auto ijk = [=](int i, int j, int k) { return (static_cast<size_t>(i)*nt+j)*nt+k; };
+
+  for (int k=0; k<nt; ++k) {
+    potrf[k] = PRK_NODE(g, 2, [=](const tbb::flow::continue_msg &) {
+        potrf_tile(nb, tile(k,k));
+    });
+    if (k>0) make_edge(*syrk[ik(k,k-1)], *potrf[k]);
+
+    for (int i=k+1; i<nt; ++i) {
+      trsm[ik(i,k)] = PRK_NODE(g, 2, [=](const tbb::flow::continue_msg &) {
+          trsm_tile(nb, tile(k,k), tile(i,k));
+      });
+      make_edge(*potrf[k], *trsm[ik(i,k)]);
+      if (k>0) make_edge(*gemm[ijk(i,k,k-1)], *trsm[ik(i,k)]);
+    }
+
+    for (int i=k+1; i<nt; ++i) {
+      for (int j=k+1; j<i; ++j) {
+        gemm[ijk(i,j,k)] = PRK_NODE(g, (j-k <= lookahead) ? 1 : 0, [=](const tbb::flow::continue_msg &) {
+            gemm_tile(nb, tile(i,k), tile(j,k), tile(i,j));
+        });
+        make_edge(*trsm[ik(i,k)], *gemm[ijk(i,j,k)]);
+        make_edge(*trsm[ik(j,k)], *gemm[ijk(i,j,k)]);
+        if (k>0) make_edge(*gemm[ijk(i,j,k-1)], *gemm[ijk(i,j,k)]);
+      }
+      syrk[ik(i,k)] = PRK_NODE(g, (i-k <= lookahead) ? 1 : 0, [=](const tbb::flow::continue_msg &) {
+          syrk_tile(nb, tile(i,k), tile(i,i));
+      });
+      make_edge(*trsm[ik(i,k)], *syrk[ik(i,k)]);
+      if (k>0) make_edge(*syrk[ik(i,k-1)], *syrk[ik(i,k)]);
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // Perform the computation
+  //////////////////////////////////////////////////////////////////////
+
+  double chol_time{0};
+  prk::energy::meter energy;
+  energy.start();
+
+  for (int iter = 0; iter<=iterations; iter++) {
+
+    cholesky_init(nt, nb, T.data());
+
+    if (iter>0) energy.skip();
+    double t0 = prk::wtime();
+
+    potrf[0]->try_put(tbb::flow::continue_msg());
+    g.wait_for_all();
+
+    if (iter>0) {
+      chol_time += prk::wtime() - t0;
+      energy.sample();
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  /// Analyze and output results
+  //////////////////////////////////////////////////////////////////////
+
+  const double residual = cholesky_residual(nt, nb, T.data());
+  const double epsilon = 1.0e-12;
+  if (residual > epsilon) {
+    std::cout << "ERROR: ||A - L L^T|| / ||A|| = " << residual
+              << " exceeds threshold " << epsilon << std::endl;
+    return 1;
+  } else {
+    std::cout << "Solution validates" << std::endl;
+#ifdef VERBOSE
+    std::cout << "||A - L L^T|| / ||A|| = " << residual << std::endl;
+#endif
+    const double avgtime = chol_time/iterations;
+    const double nflops = static_cast<double>(order)*order*order/3.0;
+
+    std::cout << "Rate (MF/s): " << 1.0e-6 * nflops/avgtime
+              << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, chol_time, 1.0e-6 * nflops, "MFlop");
+
+    // GEMM tiles of the first trailing update alone, best of <iterations>
+    const double ntiles = 0.5*(nt-1.0)*(nt-2.0);
+    if (ntiles > 0) {
+      prk::vector<double> C(T.size(), 0.0);
+      double update_time{1.e30};
+      for (int r=0; r<iterations; r++) {
+        double t = prk::wtime();
+        tbb::parallel_for(1, nt, [&](int i) {
+          for (int j=1; j<i; ++j) {
+            gemm_tile(nb, tile(i,0), tile(j,0), &C[(static_cast<size_t>(i)*nt+j)*tile_words]);
+          }
+        });
+        update_time = std::min(update_time, prk::wtime() - t);
+      }
+      const double update_rate = 1.0e-9 * ntiles * 2.0*nb*nb*nb/update_time;
+      std::cout << "Trailing update rate (GF/s): " << update_rate
+                << " Fraction of update rate: " << 1.0e-9 * nflops/avgtime/update_rate << std::endl;
+    }
+  }
+
+  return 0;
+}
@@ -60,6 +60,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 
 #if defined(MKL)
 #include <mkl.h>
@@ -253,6 +254,7 @@ int main(int argc, char * argv[])
   //////////////////////////////////////////////////////////////////////
 
   double dgemm_time{0};
+  prk::energy::meter energy;
 
   const int matrices = (batches==0 ? 1 : abs(batches));
 
@@ -283,7 +285,10 @@ int main(int argc, char * argv[])
   {
     for (int iter = 0; iter<=iterations; iter++) {
 
-      if (iter==1) dgemm_time = prk::wtime();
+      if (iter==1) {
+          dgemm_time = prk::wtime();
+          energy.start();
+      }
 
       if (batches == 0) {
           prk_dgemm(order, A[0], B[0], C[0]);
@@ -294,6 +299,7 @@ int main(int argc, char * argv[])
       }
     }
     dgemm_time = prk::wtime() - dgemm_time;
+    energy.stop();
   }
 
   //////////////////////////////////////////////////////////////////////
@@ -320,6 +326,7 @@ int main(int argc, char * argv[])
     auto nflops = 2.0 * prk::pow(forder,3);
     std::cout << "Rate (MF/s): " << 1.0e-6 * nflops/avgtime
               << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, dgemm_time, 1.0e-6 * nflops * matrices, "MFlop");
   } else {
     std::cout << "Reference checksum = " << reference << "\n"
               << "Residuum           = " << residuum << std::endl;
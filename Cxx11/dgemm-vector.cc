@@ -59,6 +59,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 
 void prk_dgemm(const int order,
                const std::vector<double> & A,
@@ -155,6 +156,7 @@ int main(int argc, char * argv[])
   //////////////////////////////////////////////////////////////////////
 
   double dgemm_time{0};
+  prk::energy::meter energy;
 
   std::vector<double> A(order*order);
   std::vector<double> B(order*order);
@@ -169,7 +171,10 @@ int main(int argc, char * argv[])
   {
     for (int iter = 0; iter<=iterations; iter++) {
 
-      if (iter==1) dgemm_time = prk::wtime();
+      if (iter==1) {
+          dgemm_time = prk::wtime();
+          energy.start();
+      }
 
       if (tile_size < order) {
           prk_dgemm(order, tile_size, A, B, C);
@@ -178,6 +183,7 @@ int main(int argc, char * argv[])
       }
     }
     dgemm_time = prk::wtime() - dgemm_time;
+    energy.stop();
   }
 
   //////////////////////////////////////////////////////////////////////
@@ -200,6 +206,7 @@ int main(int argc, char * argv[])
     auto nflops = 2.0 * prk::pow(forder,3);
     std::cout << "Rate (MF/s): " << 1.0e-6 * nflops/avgtime
               << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, dgemm_time, 1.0e-6 * nflops, "MFlop");
   } else {
     std::cout << "Reference checksum = " << reference << "\n"
               << "Actual checksum = " << checksum << std::endl;
@@ -0,0 +1,424 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+//////////////////////////////////////////////////////////////////////
+///
+/// NAME:    fft2d
+///
+/// PURPOSE: This program measures the time for a distributed 2D complex
+///          FFT, i.e. the computation that the distributed transpose
+///          kernels are a proxy for.
+///
+/// USAGE:   Program input is the number of iterations, the base-2 log of
+///          the grid dimension and optionally the number of slabs in which
+///          the first set of row FFTs is overlapped with the transpose.
+///
+///          <progname> <# iterations> <log2 grid size> [<# slabs>]
+///
+///          The output consists of diagnostics to make sure the
+///          algorithm worked, and of timing statistics.
+///
+/// NOTES:   The n x n grid is distributed by rows.  A forward transform is
+///            1D FFT of the local rows,
+///            all-to-all transpose (local transpose in the pack step),
+///            1D FFT of the local rows,
+///          which leaves the spectrum in transposed order.  The inverse
+///          transform runs the same steps backwards and restores the
+///          original layout, so each iteration is a round trip.
+///
+///          The 1D FFT is a radix-4 Stockham autosort FFT with one radix-2
+///          stage when log2(n) is odd.  It works on a batch of rows that is
+///          interleaved so that the innermost loop runs across the rows
+///          (and across the butterflies of later stages) with a scalar
+///          twiddle factor, which vectorizes without shuffles.
+///
+///          With more than one slab, the rows are transformed slab by slab
+///          and each slab is sent with MPI_Ialltoall as soon as it is done,
+///          so that the FFT of the next slab hides the communication.
+///
+///          The transform is checked once against the analytic spectrum of
+///          a plane wave; the round trip is checked at the end.
+///
+/// HISTORY: The transpose follows the MPI1 Transpose kernel written by
+///          Rob Van der Wijngaart, February 2009.
+///
+//////////////////////////////////////////////////////////////////////
+
+#include "prk_util.h"
+#include "prk_mpi.h"
+
+#include <complex>
+
+using complex = std::complex<double>;
+
+// rows transformed together by one call of the batched 1D FFT
+static const size_t FFT_BATCH = 8;
+
+class fft_rows {
+
+  private:
+    size_t n_;
+    std::vector<double> cos_, sin_;      // exp(2 pi i k/n)
+    std::vector<double> xr_, xi_, yr_, yi_;
+
+    // Stockham autosort FFT of nb interleaved rows: element k of row r is
+    // at [k*nb+r].  sign is -1 for the forward and +1 for the inverse.
+    // Returns the buffer pair that holds the result.
+    std::pair<double*,double*> batch(size_t nb, double sign)
+    {
+        double * RESTRICT ar = xr_.data();
+        double * RESTRICT ai = xi_.data();
+        double * RESTRICT br = yr_.data();
+        double * RESTRICT bi = yi_.data();
+
+        size_t s = 1;       // butterflies per twiddle factor
+        size_t len = n_;    // length of the remaining subtransforms
+        while (len >= 4) {
+            const size_t l1 = len/4;
+            const size_t ws = n_/len;
+            const size_t L = s*nb;
+            for (size_t p=0; p<l1; p++) {
+                const double w1r = cos_[p*ws],   w1i = sign*sin_[p*ws];
+                const double w2r = cos_[2*p*ws], w2i = sign*sin_[2*p*ws];
+                const double w3r = cos_[3*p*ws], w3i = sign*sin_[3*p*ws];
+                const double * RESTRICT ar0 = ar + (p     )*L, * RESTRICT ai0 = ai + (p     )*L;
+                const double * RESTRICT ar1 = ar + (p+  l1)*L, * RESTRICT ai1 = ai + (p+  l1)*L;
+                const double * RESTRICT ar2 = ar + (p+2*l1)*L, * RESTRICT ai2 = ai + (p+2*l1)*L;
+                const double * RESTRICT ar3 = ar + (p+3*l1)*L, * RESTRICT ai3 = ai + (p+3*l1)*L;
+                double * RESTRICT br0 = br + (4*p  )*L, * RESTRICT bi0 = bi + (4*p  )*L;
+                double * RESTRICT br1 = br + (4*p+1)*L, * RESTRICT bi1 = bi + (4*p+1)*L;
+                double * RESTRICT br2 = br + (4*p+2)*L, * RESTRICT bi2 = bi + (4*p+2)*L;
+                double * RESTRICT br3 = br + (4*p+3)*L, * RESTRICT bi3 = bi + (4*p+3)*L;
+                PRAGMA_SIMD
+                for (size_t t=0; t<L; t++) {
+                    const double apcr = ar0[t] + ar2[t], apci = ai0[t] + ai2[t];
+                    const double amcr = ar0[t] - ar2[t], amci = ai0[t] - ai2[t];
+                    const double bpdr = ar1[t] + ar3[t], bpdi = ai1[t] + ai3[t];
+                    // sign * i * (b-d)
+                    const double jr = -sign*(ai1[t] - ai3[t]);
+                    const double ji =  sign*(ar1[t] - ar3[t]);
+                    br0[t] = apcr + bpdr;
+                    bi0[t] = apci + bpdi;
+                    const double y1r = amcr + jr, y1i = amci + ji;
+                    br1[t] = y1r*w1r - y1i*w1i;
+                    bi1[t] = y1r*w1i + y1i*w1r;
+                    const double y2r = apcr - bpdr, y2i = apci - bpdi;
+                    br2[t] = y2r*w2r - y2i*w2i;
+                    bi2[t] = y2r*w2i + y2i*w2r;
+                    const double y3r = amcr - jr, y3i = amci - ji;
+                    br3[t] = y3r*w3r - y3i*w3i;
+                    bi3[t] = y3r*w3i + y3i*w3r;
+                }
+            }
+            std::swap(ar,br);
+            std::swap(ai,bi);
+            s *= 4;
+            len /= 4;
+        }
+        if (len == 2) {
+            const size_t L = s*nb;
+            PRAGMA_SIMD
+            for (size_t t=0; t<L; t++) {
+                const double a_r = ar[t], a_i = ai[t];
+                const double b_r = ar[L+t], b_i = ai[L+t];
+                br[t]   = a_r + b_r;
+                bi[t]   = a_i + b_i;
+                br[L+t] = a_r - b_r;
+                bi[L+t] = a_i - b_i;
+            }
+            std::swap(ar,br);
+            std::swap(ai,bi);
+        }
+        return {ar,ai};
+    }
+
+  public:
+    fft_rows(size_t n) : n_(n), cos_(n), sin_(n),
+                         xr_(n*FFT_BATCH), xi_(n*FFT_BATCH), yr_(n*FFT_BATCH), yi_(n*FFT_BATCH)
+    {
+        for (size_t k=0; k<n; k++) {
+            cos_[k] = std::cos(2.0*prk::constants::pi()*k/n);
+            sin_[k] = std::sin(2.0*prk::constants::pi()*k/n);
+        }
+    }
+
+    // in-place FFT of rows [first,last) of the row-major array A
+    void operator()(complex * A, size_t first, size_t last, double sign)
+    {
+        const size_t n = n_;
+        for (size_t r0=first; r0<last; r0+=FFT_BATCH) {
+            const size_t nb = std::min(FFT_BATCH, last-r0);
+            for (size_t r=0; r<nb; r++) {
+                const complex * RESTRICT row = &A[(r0+r)*n];
+                for (size_t k=0; k<n; k++) {
+                    xr_[k*nb+r] = row[k].real();
+                    xi_[k*nb+r] = row[k].imag();
+                }
+            }
+            auto [zr,zi] = batch(nb, sign);
+            for (size_t r=0; r<nb; r++) {
+                complex * RESTRICT row = &A[(r0+r)*n];
+                for (size_t k=0; k<n; k++) {
+                    row[k] = complex(zr[k*nb+r], zi[k*nb+r]);
+                }
+            }
+        }
+    }
+};
+
+int main(int argc, char* argv[])
+{
+  {
+    prk::MPI::state mpi(&argc,&argv);
+
+    int np = prk::MPI::size();
+    int me = prk::MPI::rank();
+
+    if (me == 0) {
+      std::cout << "Parallel Research Kernels version " << PRKVERSION << std::endl;
+      std::cout << "MPI/C++11 2D FFT" << std::endl;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // Process and test input parameters
+    //////////////////////////////////////////////////////////////////////
+
+    int iterations;
+    int log2n;
+    size_t n, m, slabs;
+    try {
+        if (argc < 3) {
+          throw "Usage: <# iterations> <log2 grid size> [<# slabs>]";
+        }
+
+        iterations  = std::atoi(argv[1]);
+        if (iterations < 1) {
+          throw "ERROR: iterations must be >= 1";
+        }
+
+        log2n = std::atoi(argv[2]);
+        if (log2n < 1 || log2n > 15) {
+          throw "ERROR: log2 grid size must be between 1 and 15";
+        }
+        n = size_t(1) << log2n;
+        if (n % np != 0) {
+          throw "ERROR: grid size must be a multiple of the number of processes";
+        }
+        m = n / np;
+
+        slabs = (argc > 3) ? std::atoi(argv[3]) : 1;
+        if (slabs < 1 || m % slabs != 0) {
+          throw "ERROR: # slabs must divide the number of local rows";
+        }
+    }
+    catch (const char * e) {
+      if (me == 0) std::cout << e << std::endl;
+      prk::MPI::abort();
+    }
+
+    if (me == 0) {
+      std::cout << "Number of processes  = " << np << std::endl;
+      std::cout << "Number of iterations = " << iterations << std::endl;
+      std::cout << "Grid size            = " << n << std::endl;
+      std::cout << "Rows per process     = " << m << std::endl;
+      std::cout << "Number of slabs      = " << slabs
+                << (slabs > 1 ? " (overlapped)" : " (blocking)") << std::endl;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // Allocate space and define the transform
+    //////////////////////////////////////////////////////////////////////
+
+    std::vector<complex> A(m*n), B(m*n), send(m*n), recv(m*n);
+    fft_rows fft(n);
+
+    const size_t ms = m / slabs;      // local rows per slab
+    const size_t block = m * ms;      // elements per peer per slab
+    std::vector<MPI_Request> req(slabs);
+
+    double fft_time{0}, trans_time{0};
+
+    // row FFT of X, transpose into Y, row FFT of Y
+    auto fft2d = [&](complex * X, complex * Y, double sign) {
+        for (size_t k=0; k<slabs; k++) {
+            const size_t r0 = k*ms;
+            double t0 = prk::MPI::wtime();
+            fft(X, r0, r0+ms, sign);
+            double t1 = prk::MPI::wtime();
+            complex * RESTRICT sk = &send[k*np*block];
+            for (int d=0; d<np; d++) {
+                for (size_t c=0; c<m; c++) {
+                    for (size_t rr=0; rr<ms; rr++) {
+                        sk[(d*m+c)*ms+rr] = X[(r0+rr)*n + d*m + c];
+                    }
+                }
+            }
+            if (slabs > 1) {
+                prk::MPI::check( MPI_Ialltoall(sk, 2*block, MPI_DOUBLE,
+                                               &recv[k*np*block], 2*block, MPI_DOUBLE,
+                                               MPI_COMM_WORLD, &req[k]) );
+            } else {
+                prk::MPI::check( MPI_Alltoall(sk, 2*block, MPI_DOUBLE,
+                                              recv.data(), 2*block, MPI_DOUBLE, MPI_COMM_WORLD) );
+            }
+            fft_time   += t1-t0;
+            trans_time += prk::MPI::wtime()-t1;
+        }
+        double t1 = prk::MPI::wtime();
+        for (size_t k=0; k<slabs; k++) {
+            if (slabs > 1) {
+                prk::MPI::check( MPI_Wait(&req[k], MPI_STATUS_IGNORE) );
+            }
+            const size_t r0 = k*ms;
+            const complex * RESTRICT rk = &recv[k*np*block];
+            for (int s=0; s<np; s++) {
+                for (size_t c=0; c<m; c++) {
+                    for (size_t rr=0; rr<ms; rr++) {
+                        Y[c*n + s*m + r0 + rr] = rk[(s*m+c)*ms+rr];
+                    }
+                }
+            }
+        }
+        double t2 = prk::MPI::wtime();
+        fft(Y, 0, m, sign);
+        fft_time   += prk::MPI::wtime()-t2;
+        trans_time += t2-t1;
+    };
+
+    //////////////////////////////////////////////////////////////////////
+    // Check the forward transform against the spectrum of a plane wave
+    //////////////////////////////////////////////////////////////////////
+
+    const double epsilon = 1.0e-8;
+    {
+        const size_t a = 1 % n, b = 3 % n;
+        for (size_t i=0; i<m; i++) {
+          for (size_t j=0; j<n; j++) {
+            const double phase = 2.0*prk::constants::pi()*((a*(me*m+i) + b*j) % n)/n;
+            A[i*n+j] = complex(std::cos(phase), std::sin(phase));
+          }
+        }
+        fft2d(A.data(), B.data(), -1.0);
+        // B holds the spectrum transposed: row k2, column k1
+        double error(0);
+        for (size_t c=0; c<m; c++) {
+          for (size_t k=0; k<n; k++) {
+            const complex ref = (me*m+c == b && k == a) ? complex(double(n)*double(n),0) : complex(0,0);
+            error = std::max(error, std::abs(B[c*n+k]-ref));
+          }
+        }
+        error = prk::MPI::max(error) / (double(n)*double(n));
+        if (error > epsilon) {
+          if (me == 0) {
+            std::cout << "ERROR: plane wave spectrum error = " << error << std::endl;
+          }
+          prk::MPI::abort();
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // Perform the computation
+    //////////////////////////////////////////////////////////////////////
+
+    auto initial = [&](size_t i, size_t j) {
+        const size_t g = (me*m+i)*n+j;
+        return complex(static_cast<double>(g%17)/17.0, static_cast<double>(g%13)/13.0 - 0.5);
+    };
+    for (size_t i=0; i<m; i++) {
+      for (size_t j=0; j<n; j++) {
+        A[i*n+j] = initial(i,j);
+      }
+    }
+
+    double fft2d_time{0};
+    const double scale = 1.0/(double(n)*double(n));
+
+    for (int iter = 0; iter<=iterations; iter++) {
+
+      if (iter==1) {
+          prk::MPI::barrier();
+          fft2d_time = prk::MPI::wtime();
+          fft_time = trans_time = 0;
+      }
+
+      fft2d(A.data(), B.data(), -1.0);
+      fft2d(B.data(), A.data(),  1.0);
+      for (size_t i=0; i<m*n; i++) {
+        A[i] *= scale;
+      }
+    }
+    prk::MPI::barrier();
+    fft2d_time = prk::MPI::wtime() - fft2d_time;
+
+    //////////////////////////////////////////////////////////////////////
+    // Analyze and output results.
+    //////////////////////////////////////////////////////////////////////
+
+    double error(0);
+    for (size_t i=0; i<m; i++) {
+      for (size_t j=0; j<n; j++) {
+        error = std::max(error, std::abs(A[i*n+j] - initial(i,j)));
+      }
+    }
+    error = prk::MPI::max(error);
+    fft_time   = prk::MPI::max(fft_time);
+    trans_time = prk::MPI::max(trans_time);
+
+    if (error > epsilon) {
+      if (me == 0) {
+        std::cout << "ERROR: round trip error = " << error << std::endl;
+      }
+      return 1;
+    } else {
+      if (me == 0) {
+        std::cout << "Solution validates" << std::endl;
+#ifdef VERBOSE
+        std::cout << "Round trip error = " << error << std::endl;
+#endif
+        // two transforms per iteration, 5 N log2(N) flops each with N = n^2
+        const double nn = double(n)*double(n);
+        const double flops = 2.0 * 5.0 * nn * 2.0 * log2n;
+        // one transpose per transform, so two per iteration, each
+        // sending and receiving the whole grid
+        const double bytes = 2.0 * 2.0 * sizeof(complex) * nn;
+        const double avgtime = fft2d_time/iterations;
+        std::cout << "FFT time fraction    = " << fft_time/fft2d_time << std::endl;
+        std::cout << "Transpose fraction   = " << trans_time/fft2d_time << std::endl;
+        std::cout << "Transpose rate (MB/s): " << 1.0e-6 * bytes * iterations/trans_time << std::endl;
+        std::cout << "Rate (MFlops/s): " << 1.0e-6 * flops/avgtime
+                  << " Avg time (s): " << avgtime << std::endl;
+      }
+    }
+
+  } // prk::MPI:state goes out of scope here
+
+  return 0;
+}
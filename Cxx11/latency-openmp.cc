@@ -0,0 +1,441 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+//////////////////////////////////////////////////////////////////////
+///
+/// NAME:    latency
+///
+/// PURPOSE: To measure memory latency under load: one thread chases
+///          pointers through a random cyclic permutation while the other
+///          threads run the STREAM triad at a controlled injection rate.
+///
+/// USAGE:   The program takes as input the number of dependent loads per
+///          measurement, a list of footprints of the pointer chase and
+///          optionally a list of pauses between triad chunks and the
+///          length of the triad vectors of each loading thread.
+///
+///          <progname> <# loads> <footprints> [<pauses> <triad length>]
+///
+///          e.g. <progname> 1000000 32K,1M,64M off,10000,1000,0 2000000
+///
+///          Footprints take K, M and G suffixes.  A pause is given in ns;
+///          "off" means the other threads do not run the triad at all.
+///
+///          The output is a table of latency versus load bandwidth for
+///          every footprint and every NUMA node that has memory.
+///
+/// NOTES:   Thread 0 chases, threads 1..T-1 load.  The chase walks one
+///          pointer per 64-byte line in an order given by Sattolo's
+///          algorithm, so every line is visited once per cycle and the
+///          hardware prefetchers cannot follow.
+///
+///          Each loading thread runs A[i] = B[i] + scalar * C[i] on its own
+///          vectors in chunks of 4096 elements and spins for the pause
+///          after every chunk, which sets its injection rate.
+///
+///          On Linux, the nodes are those listed in
+///          /sys/devices/system/node/has_memory, which includes CPU-less
+///          memory nodes such as CXL or HBM expanders.  The threads are
+///          pinned to the CPUs of these nodes in order, the chasing thread
+///          first, and for each node all vectors are bound to it with
+///          mbind before they are touched, so the curve for node k is the
+///          latency of the chasing thread's node to the memory of node k.
+///          Elsewhere, there is a single node and no pinning.
+///
+/// HISTORY: Triad based on the nstream kernel.
+///
+//////////////////////////////////////////////////////////////////////
+
+#include "prk_util.h"
+#include "prk_openmp.h"
+#include "prk_tiering.h"
+#include "prk_energy.h"
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+static const size_t cache_line = 64;
+static const size_t triad_chunk = 4096;
+
+struct alignas(64) line_t {
+    size_t next;
+    char   pad[cache_line - sizeof(size_t)];
+};
+
+struct numa_node {
+    int id;
+    std::vector<int> cpus;
+};
+
+// parse a Linux cpulist such as "0-3,8-11"
+static std::vector<int> parse_cpulist(const std::string & s)
+{
+    std::vector<int> cpus;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        auto dash = item.find('-');
+        int lo = std::atoi(item.substr(0,dash).c_str());
+        int hi = (dash == std::string::npos) ? lo : std::atoi(item.substr(dash+1).c_str());
+        for (int c=lo; c<=hi; c++) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+// every node with memory, with its CPUs (none for a memory-only node)
+static std::vector<numa_node> find_nodes(void)
+{
+    std::vector<numa_node> nodes;
+#ifdef __linux__
+    std::ifstream f("/sys/devices/system/node/has_memory");
+    if (!f) return nodes;
+    std::string s;
+    std::getline(f, s);
+    for (auto id : parse_cpulist(s)) {
+        std::ifstream g("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+        std::string c;
+        if (g) std::getline(g, c);
+        nodes.push_back({id, parse_cpulist(c)});
+    }
+#endif
+    return nodes;
+}
+
+static bool pin(int cpu)
+{
+#ifdef __linux__
+    if (cpu < 0) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return (sched_setaffinity(0, sizeof(set), &set) == 0);
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+static size_t parse_size(const std::string & s)
+{
+    size_t v = std::atol(s.c_str());
+    switch (s.empty() ? ' ' : s.back()) {
+        case 'k': case 'K': v <<= 10; break;
+        case 'm': case 'M': v <<= 20; break;
+        case 'g': case 'G': v <<= 30; break;
+    }
+    return v;
+}
+
+static void spin(double seconds)
+{
+    const double t0 = prk::wtime();
+    while (prk::wtime() - t0 < seconds) { }
+}
+
+int main(int argc, char * argv[])
+{
+  std::cout << "Parallel Research Kernels version " << PRKVERSION << std::endl;
+  std::cout << "C++11/OpenMP loaded latency: pointer chase vs. STREAM triad" << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  /// Read and test input parameters
+  //////////////////////////////////////////////////////////////////////
+
+  size_t loads;
+  std::vector<size_t> footprints;
+  std::vector<double> pauses;       // seconds; negative means no load
+  size_t length;
+  try {
+      if (argc < 3) {
+        throw "Usage: <# loads> <footprints, e.g. 32K,1M,64M> [<pauses in ns, e.g. off,1000,0> <triad length>]";
+      }
+
+      loads = std::atol(argv[1]);
+      if (loads < 1) {
+        throw "ERROR: # loads must be >= 1";
+      }
+
+      {
+        std::stringstream ss(argv[2]);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+          const size_t f = parse_size(item);
+          if (f < cache_line) {
+            throw "ERROR: footprints must be at least one cache line";
+          }
+          footprints.push_back(f);
+        }
+      }
+
+      {
+        std::stringstream ss( (argc > 3) ? argv[3] : "off,10000,1000,100,0" );
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+          pauses.push_back( (item == "off") ? -1.0 : 1.e-9 * std::atof(item.c_str()) );
+        }
+      }
+
+      length = (argc > 4) ? std::atol(argv[4]) : 2000000;
+      if (length < triad_chunk) {
+        throw "ERROR: triad length must be at least 4096";
+      }
+  }
+  catch (const char * e) {
+    std::cout << e << std::endl;
+    return 1;
+  }
+
+  const int nthreads = omp_get_max_threads();
+  auto nodes = find_nodes();
+  const bool bound = !nodes.empty();
+  if (!bound) {
+      nodes.push_back({0, {}});
+  }
+
+  std::vector<int> cpus;        // CPU of each thread, chaser first
+  for (auto & n : nodes) {
+      for (auto c : n.cpus) cpus.push_back(c);
+  }
+  const bool pinned = !cpus.empty();
+
+  std::cout << "Number of threads    = " << nthreads << " (1 chasing, " << nthreads-1 << " loading)" << std::endl;
+  std::cout << "Number of loads      = " << loads << std::endl;
+  std::cout << "Footprints           = " << argv[2] << std::endl;
+  std::cout << "Triad length         = " << length << std::endl;
+  std::cout << "NUMA nodes           = " << nodes.size() << (bound ? " (bound" : " (not bound") << (pinned ? ", pinned)" : ", not pinned)") << std::endl;
+  if (pinned && static_cast<size_t>(nthreads) > cpus.size()) {
+      std::cout << "WARNING: more threads than CPUs" << std::endl;
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // Allocate space and perform the computation
+  //////////////////////////////////////////////////////////////////////
+
+  const size_t max_lines = *std::max_element(footprints.begin(), footprints.end()) / cache_line;
+  const double scalar(3);
+
+  using tvector = prk::tiering::vector<double>;
+  std::unique_ptr<prk::tiering::vector<line_t>> chase_v;
+  std::vector<std::unique_ptr<tvector>> A_v(nthreads), B_v(nthreads), C_v(nthreads);
+  line_t * chase = nullptr;
+  std::vector<double*> A(nthreads), B(nthreads), C(nthreads);
+
+  // results, indexed [node][footprint][pause]
+  const size_t npoints = nodes.size() * footprints.size() * pauses.size();
+  std::vector<double> latency(npoints), bandwidth(npoints), power(npoints), chase_time(npoints);
+  prk::energy::meter energy;
+  std::vector<double> thread_rate(nthreads);
+
+  std::atomic<bool> stop{false};
+  bool cycle_ok{true}, triad_ok{true};
+  size_t sink{0};
+
+  OMP_PARALLEL()
+  {
+    const int me = omp_get_thread_num();
+    const int mycpu = pinned ? cpus[me % cpus.size()] : -1;
+    pin(mycpu);
+
+    for (size_t k=0; k<nodes.size(); k++) {
+
+      // bind all vectors to node k before they are touched
+      OMP_MASTER
+      {
+        prk::tiering::tier t_k;
+        if (bound) {
+          t_k.type = prk::tiering::kind::numa;
+          t_k.node = nodes[k].id;
+        }
+        chase_v.reset(new prk::tiering::vector<line_t>(max_lines));
+        chase_v->place(0, max_lines, t_k);
+        chase = chase_v->data();
+        for (size_t i=0; i<max_lines; i++) chase[i].next = 0;
+        for (int t=1; t<nthreads; t++) {
+          A_v[t].reset(new tvector(length));
+          B_v[t].reset(new tvector(length));
+          C_v[t].reset(new tvector(length));
+          A_v[t]->place(0, length, t_k);
+          B_v[t]->place(0, length, t_k);
+          C_v[t]->place(0, length, t_k);
+          A[t] = A_v[t]->data();
+          B[t] = B_v[t]->data();
+          C[t] = C_v[t]->data();
+          for (size_t i=0; i<length; i++) {
+            A[t][i] = 0.0;
+            B[t][i] = 2.0;
+            C[t][i] = 2.0;
+          }
+        }
+      }
+      OMP_BARRIER
+
+      for (size_t f=0; f<footprints.size(); f++) {
+
+        const size_t nlines = footprints[f] / cache_line;
+
+        // random cyclic permutation of the lines (Sattolo)
+        OMP_MASTER
+        {
+          std::vector<size_t> order(nlines);
+          std::iota(order.begin(), order.end(), 0);
+          std::mt19937_64 gen(f+1);
+          for (size_t i=nlines-1; i>0; i--) {
+            std::uniform_int_distribution<size_t> pick(0, i-1);
+            std::swap(order[i], order[pick(gen)]);
+          }
+          for (size_t i=0; i<nlines; i++) {
+            chase[order[i]].next = order[(i+1)%nlines];
+          }
+          // one full cycle must visit every line and come back
+          size_t p = 0, steps = 0;
+          do { p = chase[p].next; steps++; } while (p != 0 && steps <= nlines);
+          if (steps != nlines) cycle_ok = false;
+        }
+        OMP_BARRIER
+
+        for (size_t l=0; l<pauses.size(); l++) {
+
+          const double pause = pauses[l];
+          const size_t point = (k*footprints.size() + f)*pauses.size() + l;
+
+          if (me == 0) {
+            // warm up the caches and let the load ramp up
+            size_t p = 0;
+            for (size_t i=0; i<std::min(loads,nlines); i++) p = chase[p].next;
+            energy.start();
+            const double t0 = prk::wtime();
+            for (size_t i=0; i<loads; i++) p = chase[p].next;
+            const double t1 = prk::wtime();
+            energy.stop();
+            sink += p;
+            chase_time[point] = t1-t0;
+            latency[point] = (t1-t0)/loads;
+            power[point] = energy.joules()/(t1-t0);
+            stop = true;
+          } else if (pause >= 0.0) {
+            double * RESTRICT a = A[me];
+            const double * RESTRICT b = B[me];
+            const double * RESTRICT c = C[me];
+            size_t chunks = 0, i0 = 0;
+            const double t0 = prk::wtime();
+            while (!stop.load(std::memory_order_relaxed)) {
+              PRAGMA_SIMD
+              for (size_t i=i0; i<i0+triad_chunk; i++) {
+                a[i] = b[i] + scalar * c[i];
+              }
+              chunks++;
+              i0 += triad_chunk;
+              if (i0+triad_chunk > length) i0 = 0;
+              if (pause > 0.0) spin(pause);
+            }
+            const double t1 = prk::wtime();
+            thread_rate[me] = (chunks > 0) ? 3.0 * sizeof(double) * triad_chunk * chunks / (t1-t0) : 0.0;
+          } else {
+            thread_rate[me] = 0.0;
+          }
+          OMP_BARRIER
+          OMP_MASTER
+          {
+            double bw(0);
+            for (int t=1; t<nthreads; t++) bw += thread_rate[t];
+            bandwidth[point] = bw;
+            stop = false;
+          }
+          OMP_BARRIER
+        }
+      }
+    }
+
+    OMP_MASTER
+    {
+      for (int t=1; t<nthreads; t++) {
+        for (size_t i=0; i<length; i++) {
+          if (A[t][i] != 0.0 && A[t][i] != B[t][i] + scalar * C[t][i]) triad_ok = false;
+        }
+      }
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  /// Analyze and output results
+  //////////////////////////////////////////////////////////////////////
+
+  if (!cycle_ok || !triad_ok) {
+      std::cout << "ERROR: " << (cycle_ok ? "triad results are wrong" : "pointer chase is not a single cycle")
+                << std::endl;
+      return 1;
+  }
+
+  std::cout << std::setw(6)  << "Node"
+            << std::setw(14) << "Footprint"
+            << std::setw(12) << "Pause (ns)"
+            << std::setw(16) << "Load (MB/s)"
+            << std::setw(16) << "Latency (ns)"
+            << (energy.available() ? "       Power (W)" : "") << std::endl;
+  double best_bw(0), worst_latency(0), total_time(0);
+  for (size_t k=0; k<nodes.size(); k++) {
+    for (size_t f=0; f<footprints.size(); f++) {
+      for (size_t l=0; l<pauses.size(); l++) {
+        const size_t point = (k*footprints.size() + f)*pauses.size() + l;
+        std::cout << std::setw(6)  << nodes[k].id
+                  << std::setw(14) << footprints[f]
+                  << std::setw(12);
+        if (pauses[l] < 0.0) std::cout << "off";
+        else                 std::cout << 1.e9*pauses[l];
+        std::cout << std::setw(16) << 1.e-6*bandwidth[point]
+                  << std::setw(16) << 1.e9*latency[point];
+        if (energy.available()) std::cout << std::setw(16) << power[point];
+        std::cout << std::endl;
+        best_bw = std::max(best_bw, bandwidth[point]);
+        worst_latency = std::max(worst_latency, latency[point]);
+        total_time += chase_time[point];
+      }
+    }
+  }
+
+  std::cout << "Solution validates" << std::endl;
+#ifdef VERBOSE
+  std::cout << "Chase checksum = " << sink << std::endl;
+#endif
+  std::cout << "Rate (MB/s): " << 1.e-6*best_bw
+            << " Avg time (s): " << total_time/npoints << std::endl;
+  std::cout << "Worst latency (ns): " << 1.e9*worst_latency << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,461 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+
+//////////////////////////////////////////////////////////////////////
+///
+/// NAME:    multigrid
+///
+/// PURPOSE: This program tests the efficiency with which a geometric
+///          multigrid V-cycle applies star stencils, restriction and
+///          prolongation across a hierarchy of grids, from bandwidth-bound
+///          fine levels to latency-bound coarse ones.
+///
+/// USAGE:   The program takes as input the number of V-cycles, the 2log
+///          of the number of cells in each direction of the finest grid,
+///          and optionally the number of levels, the number of smoothing
+///          steps before and after the coarse-grid correction, and the
+///          minimum number of points per thread.
+///
+///          <progname> <# cycles> <2log grid cells> [<levels> <smoothing steps>
+///                                                   <points per thread>]
+///
+///          The output consists of diagnostics to make sure the
+///          algorithm worked, and of timing statistics.
+///
+/// NOTES:   The problem is the Poisson equation -u''=f on the unit square
+///          with zero Dirichlet boundaries, discretized with the radius-1
+///          star stencil (4u - neighbors)/h^2.  The star weights of the
+///          stencil kernel are antisymmetric, so they cannot smooth; the
+///          smoother is weighted Jacobi (omega=4/5) on the same star.
+///          Residuals are restricted by full weighting and corrections are
+///          prolongated bilinearly.  The coarsest level is solved by
+///          conjugate gradients to a relative residual of 1.e-12, so the
+///          number of levels does not change the convergence.
+///
+///          f is the discrete operator applied to sin(pi x)sin(pi y), so the
+///          discrete solution is known exactly.  The solution validates if
+///          the error has been reduced by at least 1/4 per V-cycle (1/2 with
+///          a single smoothing step), which textbook V-cycles beat by a
+///          wide margin, or if it has reached the roundoff floor of the
+///          discrete operator, about n^2 times machine epsilon, after which
+///          more cycles no longer reduce it.
+///
+///          Each level runs with at most (interior points)/(points per
+///          thread) threads, so coarse levels do not pay for waking up and
+///          synchronizing the whole team; 0 uses all threads everywhere.
+///          Time is reported per level, for the operations on the grid of
+///          that level.
+///
+/// HISTORY: Star stencil based on the stencil kernel.
+///
+//////////////////////////////////////////////////////////////////////
+
+#include "prk_util.h"
+#include "prk_energy.h"
+#include "prk_openmp.h"
+
+typedef struct {
+    int n;                      // points in each direction, including boundary
+    double h;                   // grid spacing
+    int threads;                // threads used on this level
+    std::vector<double> u, f, tmp;
+    std::vector<double> r, p, q;  // conjugate gradients, coarsest level only
+    double time;
+} level_t;
+
+// One weighted Jacobi step: tmp = u + omega*h^2/4*(f - A u).
+static void smooth(level_t & L, int steps)
+{
+    const double omega = 0.8;
+    const int n = L.n;
+    const double h2 = L.h*L.h;
+    for (int s=0; s<steps; s++) {
+      const double * RESTRICT u = L.u.data();
+      const double * RESTRICT f = L.f.data();
+      double * RESTRICT t = L.tmp.data();
+      OMP_PARALLEL(num_threads(L.threads))
+      {
+        OMP_FOR()
+        for (int i=1; i<n-1; i++) {
+          PRAGMA_SIMD
+          for (int j=1; j<n-1; j++) {
+            const double Au = (4.0*u[i*n+j] - u[(i-1)*n+j] - u[(i+1)*n+j]
+                                            - u[i*n+j-1]   - u[i*n+j+1]) / h2;
+            t[i*n+j] = u[i*n+j] + omega*0.25*h2*(f[i*n+j] - Au);
+          }
+        }
+      }
+      std::swap(L.u, L.tmp);
+    }
+}
+
+// Computes the residual f - A u of the fine level into tmp and restricts
+// it by full weighting to the right-hand side of the coarse level.
+static void restrict_residual(level_t & F, level_t & C)
+{
+    const int n = F.n;
+    const int nc = C.n;
+    const double h2 = F.h*F.h;
+    const double * RESTRICT u = F.u.data();
+    const double * RESTRICT f = F.f.data();
+    double * RESTRICT r = F.tmp.data();
+    double * RESTRICT fc = C.f.data();
+    double * RESTRICT uc = C.u.data();
+    OMP_PARALLEL(num_threads(F.threads))
+    {
+      OMP_FOR()
+      for (int i=1; i<n-1; i++) {
+        PRAGMA_SIMD
+        for (int j=1; j<n-1; j++) {
+          r[i*n+j] = f[i*n+j] - (4.0*u[i*n+j] - u[(i-1)*n+j] - u[(i+1)*n+j]
+                                              - u[i*n+j-1]   - u[i*n+j+1]) / h2;
+        }
+      }
+      OMP_FOR()
+      for (int I=1; I<nc-1; I++) {
+        for (int J=1; J<nc-1; J++) {
+          const int i = 2*I, j = 2*J;
+          fc[I*nc+J] = ( 4.0*r[i*n+j]
+                       + 2.0*(r[(i-1)*n+j] + r[(i+1)*n+j] + r[i*n+j-1] + r[i*n+j+1])
+                       + r[(i-1)*n+j-1] + r[(i-1)*n+j+1] + r[(i+1)*n+j-1] + r[(i+1)*n+j+1] ) / 16.0;
+          uc[I*nc+J] = 0.0;
+        }
+      }
+    }
+}
+
+// Adds the bilinear interpolation of the coarse solution to the fine one.
+static void prolongate(level_t & C, level_t & F)
+{
+    const int n = F.n;
+    const int nc = C.n;
+    const double * RESTRICT e = C.u.data();
+    double * RESTRICT u = F.u.data();
+    OMP_PARALLEL(num_threads(F.threads))
+    {
+      OMP_FOR()
+      for (int i=1; i<n-1; i++) {
+        const int I = i/2;
+        const int di = i%2;
+        for (int j=1; j<n-1; j++) {
+          const int J = j/2;
+          const int dj = j%2;
+          // odd indices lie between coarse points I and I+1
+          u[i*n+j] += 0.25 * ( e[I*nc+J] + e[(I+di)*nc+J] + e[I*nc+J+dj] + e[(I+di)*nc+J+dj] );
+        }
+      }
+    }
+}
+
+// Applies q = A p on the interior of the level.
+static void apply(const level_t & L, const double * RESTRICT p, double * RESTRICT q)
+{
+    const int n = L.n;
+    const double h2 = L.h*L.h;
+    OMP_FOR()
+    for (int i=1; i<n-1; i++) {
+      PRAGMA_SIMD
+      for (int j=1; j<n-1; j++) {
+        q[i*n+j] = (4.0*p[i*n+j] - p[(i-1)*n+j] - p[(i+1)*n+j]
+                                 - p[i*n+j-1]   - p[i*n+j+1]) / h2;
+      }
+    }
+}
+
+// Solves A u = f on the coarsest level by conjugate gradients.
+static void coarse_solve(level_t & L)
+{
+    const int n = L.n;
+    const int nn = n*n;
+    double * RESTRICT u = L.u.data();
+    double * RESTRICT r = L.r.data();
+    double * RESTRICT p = L.p.data();
+    double * RESTRICT q = L.q.data();
+    const double * RESTRICT f = L.f.data();
+    double rr(0), pq(0), rr0(0);
+    OMP_PARALLEL(num_threads(L.threads))
+    {
+      apply(L, u, q);
+      OMP_FOR_REDUCE(+:rr)
+      for (int k=0; k<nn; k++) {
+        r[k] = f[k] - q[k];   // zero on the boundary
+        p[k] = r[k];
+        rr += r[k]*r[k];
+      }
+      OMP_MASTER
+      {
+        rr0 = rr;
+      }
+      OMP_BARRIER
+      for (int it=0; it<nn && rr > 1.e-24*rr0; it++) {
+        apply(L, p, q);
+        OMP_MASTER
+        {
+          pq = 0.0;
+        }
+        OMP_BARRIER
+        OMP_FOR_REDUCE(+:pq)
+        for (int k=0; k<nn; k++) {
+          pq += p[k]*q[k];
+        }
+        const double alpha = rr/pq;
+        const double rr_old = rr;
+        OMP_BARRIER
+        OMP_MASTER
+        {
+          rr = 0.0;
+        }
+        OMP_BARRIER
+        OMP_FOR_REDUCE(+:rr)
+        for (int k=0; k<nn; k++) {
+          u[k] += alpha*p[k];
+          r[k] -= alpha*q[k];
+          rr += r[k]*r[k];
+        }
+        const double beta = rr/rr_old;
+        OMP_FOR()
+        for (int k=0; k<nn; k++) {
+          p[k] = r[k] + beta*p[k];
+        }
+      }
+    }
+}
+
+static void vcycle(std::vector<level_t> & levels, size_t l, int steps, bool timed)
+{
+    level_t & L = levels[l];
+    if (l+1 == levels.size()) {
+        const double t0 = prk::wtime();
+        coarse_solve(L);
+        if (timed) L.time += prk::wtime() - t0;
+        return;
+    }
+    double t0 = prk::wtime();
+    smooth(L, steps);
+    restrict_residual(L, levels[l+1]);
+    if (timed) L.time += prk::wtime() - t0;
+
+    vcycle(levels, l+1, steps, timed);
+
+    t0 = prk::wtime();
+    prolongate(levels[l+1], L);
+    smooth(L, steps);
+    if (timed) L.time += prk::wtime() - t0;
+}
+
+static double error_norm(const level_t & L, const std::vector<double> & exact)
+{
+    const int n = L.n;
+    double e(0);
+    for (int i=0; i<n; i++) {
+      for (int j=0; j<n; j++) {
+        e = std::max(e, prk::abs(L.u[i*n+j]-exact[i*n+j]));
+      }
+    }
+    return e;
+}
+
+int main(int argc, char * argv[])
+{
+  std::cout << "Parallel Research Kernels version " << PRKVERSION << std::endl;
+  std::cout << "C++11/OpenMP geometric multigrid V-cycle" << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  /// Read and test input parameters
+  //////////////////////////////////////////////////////////////////////
+
+  int cycles, lcells, nlevels, steps;
+  long grain;
+  try {
+      if (argc < 3) {
+        throw "Usage: <# cycles> <2log grid cells> [<levels> <smoothing steps> <points per thread>]";
+      }
+
+      cycles = std::atoi(argv[1]);
+      if (cycles < 1) {
+        throw "ERROR: cycles must be >= 1";
+      }
+
+      lcells = std::atoi(argv[2]);
+      if (lcells < 2 || lcells > 15) {
+        throw "ERROR: 2log grid cells must be in [2,15]";
+      }
+
+      nlevels = (argc > 3) ? std::atoi(argv[3]) : lcells;
+      if (nlevels < 1 || nlevels > lcells) {
+        throw "ERROR: levels must be in [1,2log grid cells]";
+      }
+
+      steps = (argc > 4) ? std::atoi(argv[4]) : 2;
+      if (steps < 1) {
+        throw "ERROR: smoothing steps must be >= 1";
+      }
+
+      grain = (argc > 5) ? std::atol(argv[5]) : 4096;
+      if (grain < 0) {
+        throw "ERROR: points per thread must be >= 0";
+      }
+  }
+  catch (const char * e) {
+    std::cout << e << std::endl;
+    return 1;
+  }
+
+  const int nthreads = omp_get_max_threads();
+
+  std::cout << "Number of threads    = " << nthreads << std::endl;
+  std::cout << "Number of cycles     = " << cycles << std::endl;
+  std::cout << "Grid size            = " << (1<<lcells)+1 << std::endl;
+  std::cout << "Number of levels     = " << nlevels << std::endl;
+  std::cout << "Smoothing steps      = " << steps << std::endl;
+  std::cout << "Points per thread    = " << grain << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Allocate space and perform the computation
+  //////////////////////////////////////////////////////////////////////
+
+  std::vector<level_t> levels(nlevels);
+  for (int l=0; l<nlevels; l++) {
+      level_t & L = levels[l];
+      L.n = (1 << (lcells-l)) + 1;
+      L.h = 1.0/(L.n-1);
+      const long interior = static_cast<long>(L.n-2)*static_cast<long>(L.n-2);
+      L.threads = (grain > 0) ? static_cast<int>(std::max(1L, std::min(static_cast<long>(nthreads), interior/grain)))
+                              : nthreads;
+      L.u.resize(L.n*L.n);
+      L.f.resize(L.n*L.n);
+      L.tmp.resize(L.n*L.n);
+      L.time = 0.0;
+      if (l+1 == nlevels) {
+          L.r.resize(L.n*L.n);
+          L.p.resize(L.n*L.n);
+          L.q.resize(L.n*L.n);
+      }
+      // first touch by the threads of the level
+      double * u = L.u.data();
+      double * f = L.f.data();
+      double * t = L.tmp.data();
+      const int n = L.n;
+      OMP_PARALLEL(num_threads(L.threads))
+      {
+        OMP_FOR()
+        for (int i=0; i<n; i++) {
+          for (int j=0; j<n; j++) {
+            u[i*n+j] = 0.0;
+            f[i*n+j] = 0.0;
+            t[i*n+j] = 0.0;
+          }
+        }
+      }
+  }
+
+  // f = A sin(pi x) sin(pi y), so the discrete solution is exact
+  level_t & fine = levels[0];
+  const int n = fine.n;
+  const double pi = prk::constants::pi();
+  std::vector<double> exact(n*n);
+  for (int i=0; i<n; i++) {
+    for (int j=0; j<n; j++) {
+      exact[i*n+j] = std::sin(pi*i*fine.h) * std::sin(pi*j*fine.h);
+    }
+  }
+  for (int i=1; i<n-1; i++) {
+    for (int j=1; j<n-1; j++) {
+      fine.f[i*n+j] = (4.0*exact[i*n+j] - exact[(i-1)*n+j] - exact[(i+1)*n+j]
+                                        - exact[i*n+j-1]   - exact[i*n+j+1]) / (fine.h*fine.h);
+    }
+  }
+
+  const double error0 = error_norm(fine, exact);
+  double error1(error0);
+  double mg_time{0};
+  prk::energy::meter energy;
+
+  for (int iter = 0; iter<=cycles; iter++) {
+
+    if (iter==1) {
+        error1 = error_norm(fine, exact);
+        mg_time = prk::wtime();
+        energy.start();
+    }
+
+    vcycle(levels, 0, steps, iter>0);
+
+  }
+  mg_time = prk::wtime() - mg_time;
+  energy.stop();
+
+  //////////////////////////////////////////////////////////////////////
+  // Analyze and output results.
+  //////////////////////////////////////////////////////////////////////
+
+  std::cout << std::setw(8)  << "Level"
+            << std::setw(10) << "Points"
+            << std::setw(10) << "Threads"
+            << std::setw(16) << "Time (s)"
+            << std::setw(12) << "Fraction" << std::endl;
+  double level_sum(0);
+  for (int l=0; l<nlevels; l++) {
+      level_sum += levels[l].time;
+  }
+  for (int l=0; l<nlevels; l++) {
+      std::cout << std::setw(8)  << l
+                << std::setw(10) << levels[l].n
+                << std::setw(10) << levels[l].threads
+                << std::setw(16) << levels[l].time/cycles
+                << std::setw(12) << levels[l].time/level_sum << std::endl;
+  }
+
+  const double error = error_norm(fine, exact);
+  const double factor = std::pow(error/error1, 1.0/cycles);
+  const double bound = (steps > 1) ? 0.25 : 0.5;
+  const double roundoff = static_cast<double>(n)*n*std::numeric_limits<double>::epsilon();
+  std::cout << "Initial error        = " << error0 << std::endl;
+  std::cout << "Final error          = " << error << std::endl;
+  std::cout << "Convergence factor   = " << factor << std::endl;
+
+  // with one level there is no coarse-grid correction, only the coarse solve
+  if (!(factor <= bound) && !(error <= roundoff)) {
+    std::cout << "ERROR: convergence factor " << factor << " exceeds " << bound << std::endl;
+    return 1;
+  }
+
+  std::cout << "Solution validates" << std::endl;
+  // fine-grid point updates per cycle: 2*steps smoothing steps plus the residual
+  const double updates = (2.0*steps+1.0) * static_cast<double>(n-2) * static_cast<double>(n-2);
+  auto avgtime = mg_time/cycles;
+  std::cout << "Rate (MUpdates/s): " << 1.0e-6 * updates/avgtime
+            << " Avg time (s): " << avgtime << std::endl;
+  energy.report(cycles, mg_time, 1.0e-6 * updates, "MUpdate");
+
+  return 0;
+}
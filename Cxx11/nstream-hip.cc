@@ -200,10 +200,7 @@ int main(int argc, char * argv[])
 
   ar *= length;
 
-  double asum(0);
-  for (int i=0; i<length; i++) {
-      asum += prk::abs(h_A[i]);
-  }
+  double asum = prk::transform_reduce(h_A, h_A+length, 0.0, [](prk_float a) { return prk::abs(a); });
 
   prk::HIP::check( hipHostFree(h_A) );
 
@@ -0,0 +1,310 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+//////////////////////////////////////////////////////////////////////
+///
+/// NAME:    nstream-indexed
+///
+/// PURPOSE: To compute memory bandwidth of the triad when one or both of
+///          the updated and the scaled vector are accessed indirectly:
+///
+///            gather:  A[i]      += B[i] + scalar * C[jdx[i]]
+///            scatter: A[idx[i]] += B[i] + scalar * C[i]
+///            both:    A[idx[i]] += B[i] + scalar * C[jdx[i]]
+///
+/// USAGE:   The program takes as input the number of iterations, the
+///          length of the vectors, the index pattern and the access form,
+///          and optionally the pattern parameter and a software prefetch
+///          distance.
+///
+///          <progname> <# iterations> <vector length> <pattern> <form>
+///                     [<pattern parameter> <prefetch distance>]
+///
+///          pattern = identity : idx[i] = i
+///                    stride   : every <parameter>-th element, then the
+///                               next residue (default 8)
+///                    block    : blocks of <parameter> elements in random
+///                               order, sequential inside (default 512)
+///                    window   : random permutation in which no element
+///                               moves out of its window of <parameter>
+///                               elements (default = vector length, i.e.
+///                               fully random)
+///          form    = gather, scatter or both
+///
+///          The output consists of diagnostics to make sure the
+///          algorithm worked, and of timing statistics.
+///
+/// NOTES:   Every index vector is a permutation, so each element of A is
+///          updated once per iteration and the scatter needs no atomics.
+///          The two index vectors of "both" use different random streams.
+///
+///          The rate counts the same 4 words per element as nstream
+///          ("useful" data).  Cache lines per element is a model: each
+///          unit-stride stream costs 1/8 of a line, each indirect one a new
+///          line whenever the index leaves the line of the previous one,
+///          and the index vectors themselves are streamed.  It ignores
+///          reuse, so it is an upper bound when a window fits in cache.
+///
+/// HISTORY: Based on the nstream kernel.
+///
+//////////////////////////////////////////////////////////////////////
+
+#include "prk_util.h"
+#include "prk_energy.h"
+
+#include <random>
+
+typedef std::uint32_t index_t;
+
+static const size_t cache_line = 64;
+
+static std::vector<index_t> make_index(size_t n, const std::string & pattern, size_t param, std::uint64_t seed)
+{
+    std::vector<index_t> idx(n);
+    std::mt19937_64 gen(seed);
+
+    if (pattern == "identity") {
+        std::iota(idx.begin(), idx.end(), 0);
+    } else if (pattern == "stride") {
+        size_t c = 0;
+        for (size_t k=0; k<param; k++) {
+            for (size_t j=k; j<n; j+=param) {
+                idx[c++] = j;
+            }
+        }
+    } else if (pattern == "block") {
+        const size_t nblocks = prk::divceil(n, param);
+        std::vector<size_t> order(nblocks);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), gen);
+        size_t c = 0;
+        for (auto b : order) {
+            for (size_t j=b*param; j<std::min(n,(b+1)*param); j++) {
+                idx[c++] = j;
+            }
+        }
+    } else if (pattern == "window") {
+        std::iota(idx.begin(), idx.end(), 0);
+        for (size_t w=0; w<n; w+=param) {
+            std::shuffle(idx.begin()+w, idx.begin()+std::min(n,w+param), gen);
+        }
+    }
+    return idx;
+}
+
+// cache lines touched per element by an indirect stream, without reuse
+static double lines_per_element(const std::vector<index_t> & idx)
+{
+    const size_t per_line = cache_line / sizeof(double);
+    size_t lines = 1;
+    for (size_t i=1; i<idx.size(); i++) {
+        if (idx[i]/per_line != idx[i-1]/per_line) lines++;
+    }
+    return static_cast<double>(lines) / idx.size();
+}
+
+template <bool gather, bool scatter>
+void triad(size_t length, size_t distance, double scalar,
+           double * RESTRICT A, const double * RESTRICT B, const double * RESTRICT C,
+           const index_t * RESTRICT idx, const index_t * RESTRICT jdx)
+{
+    size_t i = 0;
+    if (distance > 0 && length > distance) {
+        for ( ; i<length-distance; i++) {
+#if defined(__GNUC__) || defined(__clang__)
+            if (gather)  __builtin_prefetch(&C[jdx[i+distance]], 0);
+            if (scatter) __builtin_prefetch(&A[idx[i+distance]], 1);
+#endif
+            const size_t ia = scatter ? idx[i] : i;
+            const size_t ic = gather  ? jdx[i] : i;
+            A[ia] += B[i] + scalar * C[ic];
+        }
+    }
+    for ( ; i<length; i++) {
+        const size_t ia = scatter ? idx[i] : i;
+        const size_t ic = gather  ? jdx[i] : i;
+        A[ia] += B[i] + scalar * C[ic];
+    }
+}
+
+int main(int argc, char * argv[])
+{
+  std::cout << "Parallel Research Kernels version " << PRKVERSION << std::endl;
+  std::cout << "C++11 indexed STREAM triad: A[idx] += B + scalar * C[jdx]" << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  /// Read and test input parameters
+  //////////////////////////////////////////////////////////////////////
+
+  int iterations;
+  size_t length, param, distance;
+  std::string pattern, form;
+  try {
+      if (argc < 5) {
+        throw "Usage: <# iterations> <vector length> <identity|stride|block|window> <gather|scatter|both> "
+              "[<pattern parameter> <prefetch distance>]";
+      }
+
+      iterations  = std::atoi(argv[1]);
+      if (iterations < 1) {
+        throw "ERROR: iterations must be >= 1";
+      }
+
+      length = std::atol(argv[2]);
+      if (length <= 0) {
+        throw "ERROR: vector length must be positive";
+      } else if (length > std::numeric_limits<index_t>::max()) {
+        throw "ERROR: vector length must fit in 32 bits";
+      }
+
+      pattern = std::string(argv[3]);
+      if (pattern == "identity") {
+        param = 1;
+      } else if (pattern == "stride") {
+        param = 8;
+      } else if (pattern == "block") {
+        param = 512;
+      } else if (pattern == "window") {
+        param = length;
+      } else {
+        throw "ERROR: pattern must be identity, stride, block or window";
+      }
+
+      form = std::string(argv[4]);
+      if (form != "gather" && form != "scatter" && form != "both") {
+        throw "ERROR: form must be gather, scatter or both";
+      }
+
+      if (argc > 5) {
+        param = std::atol(argv[5]);
+      }
+      if (param < 1 || param > length) {
+        throw "ERROR: pattern parameter must be between 1 and the vector length";
+      }
+
+      distance = (argc > 6) ? std::atol(argv[6]) : 0;
+  }
+  catch (const char * e) {
+    std::cout << e << std::endl;
+    return 1;
+  }
+
+  const bool gather  = (form != "scatter");
+  const bool scatter = (form != "gather");
+
+  std::cout << "Number of iterations = " << iterations << std::endl;
+  std::cout << "Vector length        = " << length << std::endl;
+  std::cout << "Index pattern        = " << pattern << " (" << param << ")" << std::endl;
+  std::cout << "Access form          = " << form << std::endl;
+  std::cout << "Prefetch distance    = " << distance << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Allocate space and perform the computation
+  //////////////////////////////////////////////////////////////////////
+
+  double nstream_time{0};
+  prk::energy::meter energy;
+
+  prk::vector<double> A(length,0.0);
+  prk::vector<double> B(length);
+  prk::vector<double> C(length);
+  for (size_t i=0; i<length; i++) {
+      B[i] = static_cast<double>(i%7);
+      C[i] = static_cast<double>(i%5);
+  }
+
+  auto idx = make_index(length, pattern, param, 1);
+  auto jdx = make_index(length, pattern, param, 2);
+
+  double scalar(3);
+  {
+    for (int iter = 0; iter<=iterations; iter++) {
+
+      if (iter==1) {
+          nstream_time = prk::wtime();
+          energy.start();
+      }
+
+      if (gather && scatter) {
+          triad<true,true>(length, distance, scalar, A.data(), B.data(), C.data(), idx.data(), jdx.data());
+      } else if (gather) {
+          triad<true,false>(length, distance, scalar, A.data(), B.data(), C.data(), idx.data(), jdx.data());
+      } else {
+          triad<false,true>(length, distance, scalar, A.data(), B.data(), C.data(), idx.data(), jdx.data());
+      }
+    }
+    nstream_time = prk::wtime() - nstream_time;
+    energy.stop();
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  /// Analyze and output results
+  //////////////////////////////////////////////////////////////////////
+
+  size_t errors(0);
+  double ar(0), asum(0);
+  for (size_t i=0; i<length; i++) {
+      const size_t ia = scatter ? idx[i] : i;
+      const size_t ic = gather  ? jdx[i] : i;
+      const double ref = (iterations+1) * (B[i] + scalar * C[ic]);
+      if (A[ia] != ref) errors++;
+      ar   += ref;
+      asum += prk::abs(A[ia]);
+  }
+
+  if (errors > 0) {
+      std::cout << "Failed Validation on output array\n"
+                << std::setprecision(16)
+                << "       Expected checksum: " << ar << "\n"
+                << "       Observed checksum: " << asum << "\n"
+                << "       Wrong elements:    " << errors << std::endl;
+      std::cout << "ERROR: solution did not validate" << std::endl;
+      return 1;
+  } else {
+      std::cout << "Solution validates" << std::endl;
+      const double per_line = cache_line / sizeof(double);
+      const double index_lines = (gather + scatter) * sizeof(index_t) / static_cast<double>(cache_line);
+      const double lines = 1.0/per_line                                  // B
+                         + (scatter ? lines_per_element(idx) : 1.0/per_line)  // A
+                         + (gather  ? lines_per_element(jdx) : 1.0/per_line)  // C
+                         + index_lines;
+      double avgtime = nstream_time/iterations;
+      double nbytes = 4.0 * length * sizeof(double);
+      std::cout << "Cache lines/element  = " << lines
+                << " (unit stride = " << 3.0/per_line + index_lines << ")" << std::endl;
+      std::cout << "Line rate (MB/s)     = " << 1.e-6 * lines * cache_line * length / avgtime << std::endl;
+      std::cout << "Rate (MB/s): " << 1.e-6*nbytes/avgtime
+                << " Avg time (s): " << avgtime << std::endl;
+      energy.report(iterations, nstream_time, 1.e-6*nbytes, "MB");
+  }
+
+  return 0;
+}
@@ -188,10 +188,7 @@ int main(int argc, char * argv[])
   }
   ar *= length;
 
-  double asum(0);
-  for (int i=0; i<length; i++) {
-      asum += prk::abs(A[i]);
-  }
+  double asum = prk::transform_reduce(A, A+length, 0.0, [](prk_float a) { return prk::abs(a); });
 
   if (system_memory) {
       free(A);
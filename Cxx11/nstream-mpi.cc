@@ -170,10 +170,7 @@ int main(int argc, char * argv[])
 
     ar *= length;
 
-    double asum(0);
-    for (size_t i=0; i<local_length; i++) {
-        asum += prk::abs(A[i]);
-    }
+    double asum = prk::transform_reduce(A.data(), A.data()+local_length, 0.0, [](double a) { return prk::abs(a); });
 
     asum = prk::MPI::sum(asum);
 
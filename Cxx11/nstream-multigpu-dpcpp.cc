@@ -249,10 +249,7 @@ int main(int argc, char * argv[])
 
   ar *= length;
 
-  double asum(0);
-  for (int i=0; i<length; i++) {
-    asum += prk::abs(h_A[i]);
-  }
+  double asum = prk::transform_reduce(h_A.begin(), h_A.end(), 0.0, [](double a) { return prk::abs(a); });
 
   double epsilon=1.e-8;
   if (prk::abs(ar - asum) / asum > epsilon) {
@@ -127,10 +127,7 @@ void run(cl::Context context, int iterations, size_t length)
 
   ar *= length;
 
-  double asum(0);
-  for (size_t i=0; i<length; i++) {
-      asum += prk::abs(h_a[i]);
-  }
+  double asum = prk::transform_reduce(h_a.begin(), h_a.end(), 0.0, [](T a) { return prk::abs(a); });
 
   const double epsilon = (precision==64) ? 1.0e-8 : 1.0e-4;
   if (prk::abs(ar-asum)/asum > epsilon) {
@@ -62,6 +62,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "prk_openmp.h"
 
 int main(int argc, char * argv[])
@@ -110,6 +111,7 @@ int main(int argc, char * argv[])
   //////////////////////////////////////////////////////////////////////
 
   double nstream_time{0};
+  prk::energy::meter energy;
 
   double * RESTRICT A = new double[length];
   double * RESTRICT B = new double[length];
@@ -131,7 +133,10 @@ int main(int argc, char * argv[])
       if (iter==1) {
           OMP_BARRIER
           OMP_MASTER
-          nstream_time = prk::wtime();
+          {
+              nstream_time = prk::wtime();
+              energy.start();
+          }
       }
 
       OMP_FOR_SIMD
@@ -141,7 +146,10 @@ int main(int argc, char * argv[])
     }
     OMP_BARRIER
     OMP_MASTER
-    nstream_time = prk::wtime() - nstream_time;
+    {
+        nstream_time = prk::wtime() - nstream_time;
+        energy.stop();
+    }
   }
 
   //////////////////////////////////////////////////////////////////////
@@ -157,11 +165,7 @@ int main(int argc, char * argv[])
 
   ar *= length;
 
-  double asum(0);
-  OMP_PARALLEL_FOR_REDUCE( +:asum )
-  for (size_t i=0; i<length; i++) {
-      asum += prk::abs(A[i]);
-  }
+  double asum = prk::transform_reduce(A, A+length, 0.0, [](double a) { return prk::abs(a); });
 
   double epsilon=1.e-8;
   if (prk::abs(ar-asum)/asum > epsilon) {
@@ -177,6 +181,7 @@ int main(int argc, char * argv[])
       double nbytes = 4.0 * length * sizeof(double);
       std::cout << "Rate (MB/s): " << 1.e-6*nbytes/avgtime
                 << " Avg time (s): " << avgtime << std::endl;
+      energy.report(iterations, nstream_time, 1.e-6*nbytes, "MB");
   }
 
   return 0;
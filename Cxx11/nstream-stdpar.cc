@@ -166,10 +166,7 @@ int main(int argc, char * argv[])
   }
   ar *= length;
 
-  double asum(0);
-  for (size_t i=0; i<length; i++) {
-      asum += prk::abs(A[i]);
-  }
+  double asum = prk::transform_reduce(A.begin(), A.end(), 0.0, [](double a) { return prk::abs(a); });
 
   double epsilon(1.e-8);
   if (prk::abs(ar-asum)/asum > epsilon) {
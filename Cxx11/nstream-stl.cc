@@ -62,6 +62,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 
 #include "boost/iterator/zip_iterator.hpp"
 #include "boost/tuple/tuple.hpp"
@@ -106,6 +107,7 @@ int main(int argc, char * argv[])
   //////////////////////////////////////////////////////////////////////
 
   double nstream_time{0};
+  prk::energy::meter energy;
 
   std::vector<double> A(length);
   std::vector<double> B(length);
@@ -123,7 +125,10 @@ int main(int argc, char * argv[])
 
     for (int iter = 0; iter<=iterations; iter++) {
 
-      if (iter==1) nstream_time = prk::wtime();
+      if (iter==1) {
+          nstream_time = prk::wtime();
+          energy.start();
+      }
 
 #if 0
       // stupid version
@@ -148,6 +153,7 @@ int main(int argc, char * argv[])
 #endif
     }
     nstream_time = prk::wtime() - nstream_time;
+    energy.stop();
   }
 
   //////////////////////////////////////////////////////////////////////
@@ -163,10 +169,7 @@ int main(int argc, char * argv[])
 
   ar *= length;
 
-  double asum(0);
-  for (size_t i=0; i<length; i++) {
-      asum += prk::abs(A[i]);
-  }
+  double asum = prk::transform_reduce(A.begin(), A.end(), 0.0, [](double a) { return prk::abs(a); });
 
   double epsilon(1.e-8);
   if (prk::abs(ar-asum)/asum > epsilon) {
@@ -181,6 +184,7 @@ int main(int argc, char * argv[])
       double nbytes = 4.0 * length * sizeof(double);
       std::cout << "Rate (MB/s): " << 1.e-6*nbytes/avgtime
                 << " Avg time (s): " << avgtime << std::endl;
+      energy.report(iterations, nstream_time, 1.e-6*nbytes, "MB");
   }
 
   return 0;
@@ -201,10 +201,7 @@ void run(sycl::queue & q, int iterations, size_t length, size_t block_size)
 
   ar *= length;
 
-  double asum(0);
-  for (size_t i=0; i<length; ++i) {
-      asum += prk::abs(h_A[i]);
-  }
+  double asum = prk::transform_reduce(h_A, h_A+length, 0.0, [](T a) { return prk::abs(a); });
 
   sycl::free(h_A, q);
 
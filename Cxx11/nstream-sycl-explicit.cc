@@ -196,10 +196,7 @@ void run(sycl::queue & q, int iterations, size_t length, size_t block_size)
 
   ar *= length;
 
-  double asum(0);
-  for (size_t i=0; i<length; ++i) {
-      asum += prk::abs(h_A[i]);
-  }
+  double asum = prk::transform_reduce(h_A.begin(), h_A.end(), 0.0, [](T a) { return prk::abs(a); });
 
   const double epsilon(1.e-8);
   if (prk::abs(ar-asum)/asum > epsilon) {
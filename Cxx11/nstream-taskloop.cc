@@ -62,6 +62,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "prk_openmp.h"
 
 int main(int argc, char * argv[])
@@ -113,6 +114,7 @@ int main(int argc, char * argv[])
   //////////////////////////////////////////////////////////////////////
 
   double nstream_time{0};
+  prk::energy::meter energy;
 
   prk::vector<double> A(length);
   prk::vector<double> B(length);
@@ -133,7 +135,10 @@ int main(int argc, char * argv[])
 
     for (int iter = 0; iter<=iterations; iter++) {
 
-      if (iter==1) nstream_time = prk::wtime();
+      if (iter==1) {
+          nstream_time = prk::wtime();
+          energy.start();
+      }
 
       OMP_TASKLOOP( firstprivate(length) shared(A,B,C) grainsize(gs) )
       for (size_t i=0; i<length; i++) {
@@ -142,6 +147,7 @@ int main(int argc, char * argv[])
       OMP_TASKWAIT
     }
     nstream_time = prk::wtime() - nstream_time;
+    energy.stop();
   }
 
   //////////////////////////////////////////////////////////////////////
@@ -157,11 +163,7 @@ int main(int argc, char * argv[])
 
   ar *= length;
 
-  double asum(0);
-  OMP_PARALLEL_FOR_REDUCE( +:asum )
-  for (size_t i=0; i<length; i++) {
-      asum += prk::abs(A[i]);
-  }
+  double asum = prk::transform_reduce(A.begin(), A.end(), 0.0, [](double a) { return prk::abs(a); });
 
   double epsilon=1.e-8;
   if (prk::abs(ar-asum)/asum > epsilon) {
@@ -176,6 +178,7 @@ int main(int argc, char * argv[])
       double nbytes = 4.0 * length * sizeof(double);
       std::cout << "Rate (MB/s): " << 1.e-6*nbytes/avgtime
                 << " Avg time (s): " << avgtime << std::endl;
+      energy.report(iterations, nstream_time, 1.e-6*nbytes, "MB");
   }
 
   return 0;
@@ -62,6 +62,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "prk_tbb.h"
 
 int main(int argc, char* argv[])
@@ -109,6 +110,7 @@ int main(int argc, char* argv[])
   //////////////////////////////////////////////////////////////////////
 
   double nstream_time{0};
+  prk::energy::meter energy;
 
   prk::vector<double> A(length);
   prk::vector<double> B(length);
@@ -126,13 +128,17 @@ int main(int argc, char* argv[])
 
   for (int iter = 0; iter<=iterations; iter++) {
 
-    if (iter==1) nstream_time = prk::wtime();
+    if (iter==1) {
+        nstream_time = prk::wtime();
+        energy.start();
+    }
 
     tbb::parallel_for( std::begin(range), std::end(range), [&](size_t i) {
                            A[i] += B[i] + scalar * C[i];
                        }, tbb_partitioner);
   }
   nstream_time = prk::wtime() - nstream_time;
+  energy.stop();
 
   //////////////////////////////////////////////////////////////////////
   /// Analyze and output results
@@ -147,16 +153,7 @@ int main(int argc, char* argv[])
 
   ar *= length;
 
-  double asum(0);
-  asum = tbb::parallel_reduce( range, double(0),
-                               [&](decltype(range)& r, double temp) -> double {
-                                   for (size_t i=r.begin(); i!=r.end(); ++i ) {
-                                       temp += prk::abs(A[i]);
-                                   }
-                                   return temp;
-                               },
-                               [] (const double x1, const double x2) { return x1+x2; },
-                               tbb_partitioner );
+  double asum = prk::transform_reduce(A.begin(), A.end(), 0.0, [](double a) { return prk::abs(a); });
 
   double epsilon(1.e-8);
   if (prk::abs(ar-asum)/asum > epsilon) {
@@ -171,6 +168,7 @@ int main(int argc, char* argv[])
       double nbytes = 4.0 * length * sizeof(double);
       std::cout << "Rate (MB/s): " << 1.e-6*nbytes/avgtime
                 << " Avg time (s): " << avgtime << std::endl;
+      energy.report(iterations, nstream_time, 1.e-6*nbytes, "MB");
   }
 
   return 0;
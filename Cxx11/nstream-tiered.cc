@@ -0,0 +1,204 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+//////////////////////////////////////////////////////////////////////
+///
+/// NAME:    nstream
+///
+/// PURPOSE: To compute memory bandwidth when adding a vector of a given
+///          number of double precision values to the scalar multiple of
+///          another vector of the same length, and storing the result in
+///          a third vector.
+///
+/// USAGE:   The program takes as input the number
+///          of iterations to loop over the triad vectors, the length
+///          of the vectors, the slow memory tier and optionally the
+///          number of steps in the hot/cold sweep and the fast tier.
+///
+///          <progname> <# iterations> <vector length> <slow tier> [<# steps> <fast tier>]
+///
+///          Tiers are dram, numa:<node> or file:<directory>.
+///
+///          The output consists of diagnostics to make sure the
+///          algorithm worked, and of timing statistics for each
+///          fraction of A, B and C placed on the slow tier.
+///
+/// NOTES:   Bandwidth is determined as the number of words read, plus the
+///          number of words written, times the size of the words, divided
+///          by the execution time. For a vector length of N, the total
+///          number of words read and written is 4*N*sizeof(double).
+///
+/// HISTORY: This code is loosely based on the Stream benchmark by John
+///          McCalpin, but does not follow all the Stream rules. Hence,
+///          reported results should not be associated with Stream in
+///          external publications
+///
+///          Converted to C++11 by Jeff Hammond, November 2017.
+///
+//////////////////////////////////////////////////////////////////////
+
+#include "prk_util.h"
+#include "prk_energy.h"
+#include "prk_tiering.h"
+
+int main(int argc, char * argv[])
+{
+  std::cout << "Parallel Research Kernels version " << PRKVERSION << std::endl;
+  std::cout << "C++11 STREAM triad: A = B + scalar * C (tiered memory)" << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  /// Read and test input parameters
+  //////////////////////////////////////////////////////////////////////
+
+  int iterations, steps;
+  size_t length;
+  prk::tiering::tier fast, slow;
+  try {
+      if (argc < 4) {
+        throw "Usage: <# iterations> <vector length> <slow tier> [<# steps> <fast tier>]";
+      }
+
+      iterations  = std::atoi(argv[1]);
+      if (iterations < 1) {
+        throw "ERROR: iterations must be >= 1";
+      }
+
+      length = std::atol(argv[2]);
+      if (length <= 0) {
+        throw "ERROR: vector length must be positive";
+      }
+
+      slow = prk::tiering::tier::parse(argv[3]);
+
+      steps = (argc>4) ? std::atoi(argv[4]) : 4;
+      if (steps < 1) {
+        throw "ERROR: number of steps must be >= 1";
+      }
+
+      if (argc>5) fast = prk::tiering::tier::parse(argv[5]);
+  }
+  catch (const char * e) {
+    std::cout << e << std::endl;
+    return 1;
+  }
+
+  std::cout << "Number of iterations = " << iterations << std::endl;
+  std::cout << "Vector length        = " << length << std::endl;
+  std::cout << "Fast tier            = " << fast.name() << std::endl;
+  std::cout << "Slow tier            = " << slow.name() << std::endl;
+  std::cout << "Sweep steps          = " << steps << std::endl;
+
+  prk::energy::meter energy;
+  std::cout << "Cold fraction  Rate (MB/s)  Avg time (s)"
+            << (energy.available() ? "  Energy (J/iter)" : "") << std::endl;
+
+  const double scalar(3);
+
+  for (int s=0; s<=steps; s++) {
+
+    const double cold = static_cast<double>(s)/steps;
+
+    //////////////////////////////////////////////////////////////////////
+    // Allocate space and perform the computation
+    //////////////////////////////////////////////////////////////////////
+
+    double nstream_time{0};
+
+    prk::tiering::vector<double> A(length);
+    prk::tiering::vector<double> B(length);
+    prk::tiering::vector<double> C(length);
+
+    A.split(cold, fast, slow);
+    B.split(cold, fast, slow);
+    C.split(cold, fast, slow);
+
+    for (size_t i=0; i<length; i++) {
+        A[i] = 0.0;
+        B[i] = 2.0;
+        C[i] = 2.0;
+    }
+
+    {
+      for (int iter = 0; iter<=iterations; iter++) {
+
+        if (iter==1) {
+            nstream_time = prk::wtime();
+            energy.start();
+        }
+
+        for (size_t i=0; i<length; i++) {
+            A[i] += B[i] + scalar * C[i];
+        }
+      }
+      nstream_time = prk::wtime() - nstream_time;
+      energy.stop();
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    /// Analyze and output results
+    //////////////////////////////////////////////////////////////////////
+
+    double ar(0);
+    double br(2);
+    double cr(2);
+    for (int i=0; i<=iterations; i++) {
+        ar += br + scalar * cr;
+    }
+
+    ar *= length;
+
+    double asum = prk::transform_reduce(A.begin(), A.end(), 0.0, [](double a) { return prk::abs(a); });
+
+    double epsilon(1.e-8);
+    if (prk::abs(ar-asum)/asum > epsilon) {
+        std::cout << "Failed Validation on output array\n"
+                  << std::setprecision(16)
+                  << "       Expected checksum: " << ar << "\n"
+                  << "       Observed checksum: " << asum << std::endl;
+        std::cout << "ERROR: solution did not validate" << std::endl;
+        return 1;
+    }
+
+    double avgtime = nstream_time/iterations;
+    double nbytes = 4.0 * length * sizeof(double);
+    std::cout << std::setw(13) << cold << "  "
+              << std::setw(11) << 1.e-6*nbytes/avgtime << "  "
+              << std::setw(12) << avgtime;
+    if (energy.available()) {
+      std::cout << "  " << std::setw(15) << energy.joules()/iterations;
+    }
+    std::cout << std::endl;
+  }
+
+  std::cout << "Solution validates" << std::endl;
+
+  return 0;
+}
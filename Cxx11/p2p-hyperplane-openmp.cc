@@ -60,6 +60,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "prk_openmp.h"
 #include "p2p-kernel.h"
 
@@ -126,6 +127,7 @@ int main(int argc, char* argv[])
   //////////////////////////////////////////////////////////////////////
 
   double pipeline_time{0}; // silence compiler warning
+  prk::energy::meter energy;
 
   double * RESTRICT grid = new double[n*n];
 
@@ -156,7 +158,10 @@ int main(int argc, char* argv[])
       if (iter==1) {
           OMP_BARRIER
           OMP_MASTER
-          pipeline_time = prk::wtime();
+          {
+              pipeline_time = prk::wtime();
+              energy.start();
+          }
       }
 
       if (nc==1) {
@@ -183,7 +188,10 @@ int main(int argc, char* argv[])
     }
     OMP_BARRIER
     OMP_MASTER
-    pipeline_time = prk::wtime() - pipeline_time;
+    {
+        pipeline_time = prk::wtime() - pipeline_time;
+        energy.stop();
+    }
   }
 
   //////////////////////////////////////////////////////////////////////
@@ -207,6 +215,7 @@ int main(int argc, char* argv[])
   std::cout << "Rate (MFlops/s): "
             << 2.0e-6 * ( (n-1.)*(n-1.) )/avgtime
             << " Avg time (s): " << avgtime << std::endl;
+  energy.report(iterations, pipeline_time, 2.0e-6 * ( (n-1.)*(n-1.) ), "MFlop");
 
   return 0;
 }
@@ -60,6 +60,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "prk_pstl.h"
 #include "p2p-kernel.h"
 
@@ -116,6 +117,7 @@ int main(int argc, char* argv[])
   //////////////////////////////////////////////////////////////////////
 
   double pipeline_time{0};
+  prk::energy::meter energy;
 
   std::vector<double> grid(n*n,0.0);
 
@@ -127,7 +129,10 @@ int main(int argc, char* argv[])
 
   for (int iter = 0; iter<=iterations; iter++) {
 
-    if (iter==1) pipeline_time = prk::wtime();
+    if (iter==1) {
+        pipeline_time = prk::wtime();
+        energy.start();
+    }
 
     if (nc==1) {
       for (int i=2; i<=2*n-2; i++) {
@@ -156,6 +161,7 @@ int main(int argc, char* argv[])
   }
 
   pipeline_time = prk::wtime() - pipeline_time;
+  energy.stop();
 
   //////////////////////////////////////////////////////////////////////
   // Analyze and output results.
@@ -178,6 +184,7 @@ int main(int argc, char* argv[])
   std::cout << "Rate (MFlops/s): "
             << 2.0e-6 * ( (n-1.)*(n-1.) )/avgtime
             << " Avg time (s): " << avgtime << std::endl;
+  energy.report(iterations, pipeline_time, 2.0e-6 * ( (n-1.)*(n-1.) ), "MFlop");
 
   return 0;
 }
@@ -60,6 +60,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "p2p-kernel.h"
 
 int main(int argc, char* argv[])
@@ -115,6 +116,7 @@ int main(int argc, char* argv[])
   //////////////////////////////////////////////////////////////////////
 
   double pipeline_time{0};
+  prk::energy::meter energy;
 
   std::vector<double> grid(n*n,0.0);
 
@@ -126,7 +128,10 @@ int main(int argc, char* argv[])
 
   for (int iter = 0; iter<=iterations; iter++) {
 
-    if (iter==1) pipeline_time = prk::wtime();
+    if (iter==1) {
+        pipeline_time = prk::wtime();
+        energy.start();
+    }
 
     if (nc==1) {
       for (auto i=2; i<=2*n-2; i++) {
@@ -155,6 +160,7 @@ int main(int argc, char* argv[])
   }
 
   pipeline_time = prk::wtime() - pipeline_time;
+  energy.stop();
 
   //////////////////////////////////////////////////////////////////////
   // Analyze and output results.
@@ -177,6 +183,7 @@ int main(int argc, char* argv[])
   std::cout << "Rate (MFlops/s): "
             << 2.0e-6 * ( (n-1.)*(n-1.) )/avgtime
             << " Avg time (s): " << avgtime << std::endl;
+  energy.report(iterations, pipeline_time, 2.0e-6 * ( (n-1.)*(n-1.) ), "MFlop");
 
   return 0;
 }
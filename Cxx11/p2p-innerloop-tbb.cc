@@ -60,6 +60,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "prk_tbb.h"
 
 int main(int argc, char* argv[])
@@ -111,6 +112,7 @@ int main(int argc, char* argv[])
   //////////////////////////////////////////////////////////////////////
 
   double pipeline_time{0}; // silence compiler warning
+  prk::energy::meter energy;
 
   prk::vector<double> grid(n*n,0.0);
 
@@ -122,7 +124,10 @@ int main(int argc, char* argv[])
 
   for (int iter = 0; iter<=iterations; iter++){
 
-    if (iter == 1) pipeline_time = prk::wtime();
+    if (iter==1) {
+        pipeline_time = prk::wtime();
+        energy.start();
+    }
 
     for (int i=2; i<=2*n-2; i++) {
       tbb::parallel_for( std::max(2,i-n+2), std::min(i,n)+1, [=,&grid](int j) {
@@ -135,6 +140,7 @@ int main(int argc, char* argv[])
   }
 
   pipeline_time = prk::wtime() - pipeline_time;
+  energy.stop();
 
   //////////////////////////////////////////////////////////////////////
   // Analyze and output results.
@@ -157,6 +163,7 @@ int main(int argc, char* argv[])
   std::cout << "Rate (MFlops/s): "
             << 2.0e-6 * ( (n-1.)*(n-1.) )/avgtime
             << " Avg time (s): " << avgtime << std::endl;
+  energy.report(iterations, pipeline_time, 2.0e-6 * ( (n-1.)*(n-1.) ), "MFlop");
 
   return 0;
 }
@@ -60,6 +60,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "prk_openmp.h"
 #include "p2p-kernel.h"
 
@@ -125,6 +126,7 @@ int main(int argc, char* argv[])
   //////////////////////////////////////////////////////////////////////
 
   double pipeline_time{0}; // silence compiler warning
+  prk::energy::meter energy;
 
   double * RESTRICT grid = new double[m*n];
 
@@ -148,7 +150,10 @@ int main(int argc, char* argv[])
 
     for (int iter = 0; iter<=iterations; iter++) {
 
-      if (iter==1) pipeline_time = prk::wtime();
+      if (iter==1) {
+          pipeline_time = prk::wtime();
+          energy.start();
+      }
 
       for (int i=1; i<m; i+=mc) {
         for (int j=1; j<n; j+=nc) {
@@ -160,6 +165,7 @@ int main(int argc, char* argv[])
       grid[0*n+0] = -grid[(m-1)*n+(n-1)];
     }
     pipeline_time = prk::wtime() - pipeline_time;
+    energy.stop();
   }
 
   //////////////////////////////////////////////////////////////////////
@@ -183,6 +189,7 @@ int main(int argc, char* argv[])
   std::cout << "Rate (MFlops/s): "
             << 2.0e-6 * ( (m-1.)*(n-1.) )/avgtime
             << " Avg time (s): " << avgtime << std::endl;
+  energy.report(iterations, pipeline_time, 2.0e-6 * ( (m-1.)*(n-1.) ), "MFlop");
 
   return 0;
 }
@@ -61,6 +61,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "prk_tbb.h"
 #include "p2p-kernel.h"
 
@@ -131,6 +132,7 @@ int main(int argc, char* argv[])
   if(m%mc != 0) num_blocks_m++;
 
   double pipeline_time{0}; // silence compiler warning
+  prk::energy::meter energy;
 
   double * grid = new double[m*n];
 
@@ -148,7 +150,10 @@ int main(int argc, char* argv[])
   bool first_iter=true;
   block_node_t b(g, [&](const tbb::flow::continue_msg &){
     grid[0*n+0] = -grid[(m-1)*n+(n-1)];
-    if(first_iter) pipeline_time = prk::wtime();
+    if(first_iter) {
+      pipeline_time = prk::wtime();
+      energy.start();
+    }
       first_iter = false;
   });
   for (int i=0; i<num_blocks_m; i+=1) {
@@ -207,6 +212,7 @@ int main(int argc, char* argv[])
     g.wait_for_all();
     
     pipeline_time = prk::wtime() - pipeline_time;
+    energy.stop();
 
   }
 
@@ -241,6 +247,7 @@ int main(int argc, char* argv[])
   std::cout << "Rate (MFlops/s): "
             << 2.0e-6 * ( (m-1.)*(n-1.) )/avgtime
             << " Avg time (s): " << avgtime << std::endl;
+  energy.report(iterations, pipeline_time, 2.0e-6 * ( (m-1.)*(n-1.) ), "MFlop");
 
   return 0;
 }
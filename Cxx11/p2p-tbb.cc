@@ -60,6 +60,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "prk_tbb.h"
 
 void SequentialSweep(int m, int n, prk::vector<double> & grid)
@@ -180,6 +181,7 @@ int main(int argc, char* argv[])
   //////////////////////////////////////////////////////////////////////
 
   double pipeline_time{0}; // silence compiler warning
+  prk::energy::meter energy;
 
   prk::vector<double> grid(m*n,0.0);
 
@@ -192,12 +194,16 @@ int main(int argc, char* argv[])
   }
 
   for (int iter = 0; iter<=iterations; iter++){
-    if (iter == 1) pipeline_time = prk::wtime();
+    if (iter==1) {
+        pipeline_time = prk::wtime();
+        energy.start();
+    }
     SequentialSweep(m, n, grid);
     grid[0*n+0] = -grid[(m-1)*n+(n-1)];
   }
 
   pipeline_time = prk::wtime() - pipeline_time;
+  energy.stop();
 
   //////////////////////////////////////////////////////////////////////
   // Analyze and output results.
@@ -220,6 +226,7 @@ int main(int argc, char* argv[])
   std::cout << "Rate (MFlops/s): "
             << 2.0e-6 * ( (m-1.)*(n-1.) )/avgtime
             << " Avg time (s): " << avgtime << std::endl;
+  energy.report(iterations, pipeline_time, 2.0e-6 * ( (m-1.)*(n-1.) ), "MFlop");
 
   return 0;
 }
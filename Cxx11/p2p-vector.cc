@@ -60,6 +60,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "p2p-kernel.h"
 
 int main(int argc, char* argv[])
@@ -117,6 +118,7 @@ int main(int argc, char* argv[])
   //////////////////////////////////////////////////////////////////////
 
   double pipeline_time{0}; // silence compiler warning
+  prk::energy::meter energy;
 
   std::vector<double> grid(m*n,0.0);;
 
@@ -131,7 +133,10 @@ int main(int argc, char* argv[])
 
     for (int iter = 0; iter<=iterations; iter++) {
 
-      if (iter==1) pipeline_time = prk::wtime();
+      if (iter==1) {
+          pipeline_time = prk::wtime();
+          energy.start();
+      }
 
       double * RESTRICT pgrid = grid.data();
 
@@ -157,6 +162,7 @@ int main(int argc, char* argv[])
       pgrid[0*n+0] = -pgrid[(m-1)*n+(n-1)];
     }
     pipeline_time = prk::wtime() - pipeline_time;
+    energy.stop();
   }
 
   //////////////////////////////////////////////////////////////////////
@@ -180,6 +186,7 @@ int main(int argc, char* argv[])
   std::cout << "Rate (MFlops/s): "
             << 2.0e-6 * ( (m-1.)*(n-1.) )/avgtime
             << " Avg time (s): " << avgtime << std::endl;
+  energy.report(iterations, pipeline_time, 2.0e-6 * ( (m-1.)*(n-1.) ), "MFlop");
 
   return 0;
 }
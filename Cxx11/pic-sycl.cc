@@ -634,10 +634,11 @@ int main(int argc, char ** argv) {
   pic_time = prk::wtime() - pic_time;
 
   /* Run the verification test */
-  int correct = true;
-  for (uint64_t i=0; i<n; i++) {
-    correct &= verifyParticle(particles[i], iterations, Qgrid, L);
-  }
+  const uint64_t failures = prk::transform_reduce(particles, particles+n, uint64_t(0),
+                                                  [=](const particle_t & p) {
+                                                      return verifyParticle(p, iterations, Qgrid, L) ? 0 : 1;
+                                                  });
+  int correct = (failures == 0);
 
   if (correct) {
       std::cout << "Solution validates" << std::endl;
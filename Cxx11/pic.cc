@@ -42,11 +42,24 @@
 ///
 ///USAGE:   <progname> <#simulation steps> <grid size> <#particles> \
 ///                    <horizontal velocity> <vertical velocity>    \
-///                    <init mode> <init parameters>
+///                    <init mode> <init parameters> [<force kernel>]
 ///
 ///         The output consists of diagnostics to make sure the
 ///         algorithm worked, and of timing statistics.
 ///
+///NOTES:   The force kernel is "exact" (default) or "rsqrt".  The latter
+///         evaluates blocks of particles in vectorized loops, compiled
+///         for the instruction set picked by prk::dispatch (PRK_ISA), and
+///         starts from the hardware reciprocal square root estimate
+///         (rsqrtps, vrsqrt14ps or vrsqrte) refined by one Newton-Raphson
+///         step in double precision; 1/r^3 is shared between the x and y
+///         components.  The estimate has 12-14 bits, so the forces keep
+///         about 24-28 bits, not full double precision.  Their error
+///         against the exact kernel and the speedup of the force
+///         evaluation alone are measured on the initial particles; if the
+///         error could push the final positions beyond the verification
+///         tolerance, the exact kernel is used instead.
+///
 ///FUNCTIONS CALLED:
 ///
 ///         Other than standard C functions, the following functions are used in
@@ -61,6 +74,14 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
+#include "prk_dispatch.h"
+
+#if defined(PRK_DISPATCH_X86)
+# include <immintrin.h>
+#elif defined(PRK_DISPATCH_ARM)
+# include <arm_neon.h>
+#endif
 
 #include "random_draw.h"
 
@@ -73,6 +94,9 @@ static const double REL_Y = 0.5;
 
 enum geometry { GEOMETRIC, SINUSOIDAL, LINEAR, PATCH, UNDEFINED };
 
+/* Number of particles whose forces are evaluated together by the rsqrt kernel */
+static const uint64_t FORCE_BLOCK = 256;
+
 typedef struct {
   uint64_t left;
   uint64_t right;
@@ -399,6 +423,151 @@ inline void computeTotalForce(const particle_t p, const uint64_t L, const double
   fy = tmp_res_y;
 }
 
+/* Reciprocal square root estimates of a block of single-precision values,
+   from the hardware approximation of each instruction set: about 12 bits
+   (SSE, AVX), 14 bits (AVX-512) or 8 bits refined once in float (NEON) */
+void rsqrtEstimate_generic(const float * RESTRICT r2, float * RESTRICT y, const uint64_t count)
+{
+  for (uint64_t i=0; i<count; i++) y[i] = 1.0f / std::sqrt(r2[i]);
+}
+
+#if defined(PRK_DISPATCH_X86)
+PRK_TARGET_SSE2 void rsqrtEstimate_sse2(const float * RESTRICT r2, float * RESTRICT y, const uint64_t count)
+{
+  uint64_t i=0;
+  for (; i+4<=count; i+=4) _mm_storeu_ps(&y[i], _mm_rsqrt_ps(_mm_loadu_ps(&r2[i])));
+  for (; i<count; i++) y[i] = 1.0f / std::sqrt(r2[i]);
+}
+
+PRK_TARGET_AVX2 void rsqrtEstimate_avx2(const float * RESTRICT r2, float * RESTRICT y, const uint64_t count)
+{
+  uint64_t i=0;
+  for (; i+8<=count; i+=8) _mm256_storeu_ps(&y[i], _mm256_rsqrt_ps(_mm256_loadu_ps(&r2[i])));
+  for (; i<count; i++) y[i] = 1.0f / std::sqrt(r2[i]);
+}
+
+PRK_TARGET_AVX512 void rsqrtEstimate_avx512(const float * RESTRICT r2, float * RESTRICT y, const uint64_t count)
+{
+  uint64_t i=0;
+  for (; i+16<=count; i+=16) _mm512_storeu_ps(&y[i], _mm512_maskz_rsqrt14_ps(0xFFFF, _mm512_loadu_ps(&r2[i])));
+  for (; i<count; i++) y[i] = 1.0f / std::sqrt(r2[i]);
+}
+#elif defined(PRK_DISPATCH_ARM)
+void rsqrtEstimate_neon(const float * RESTRICT r2, float * RESTRICT y, const uint64_t count)
+{
+  uint64_t i=0;
+  for (; i+4<=count; i+=4) {
+    const float32x4_t a = vld1q_f32(&r2[i]);
+    float32x4_t e = vrsqrteq_f32(a);
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(a, e), e));
+    vst1q_f32(&y[i], e);
+  }
+  for (; i<count; i++) y[i] = 1.0f / std::sqrt(r2[i]);
+}
+#endif
+
+typedef void (*rsqrt_estimate_t)(const float * RESTRICT, float * RESTRICT, const uint64_t);
+
+#if defined(PRK_DISPATCH_X86)
+static const prk::dispatch::table<rsqrt_estimate_t> rsqrtEstimate{
+  rsqrtEstimate_generic, rsqrtEstimate_sse2, rsqrtEstimate_avx2, rsqrtEstimate_avx512, nullptr };
+#elif defined(PRK_DISPATCH_ARM)
+static const prk::dispatch::table<rsqrt_estimate_t> rsqrtEstimate{
+  rsqrtEstimate_generic, nullptr, nullptr, nullptr, rsqrtEstimate_neon };
+#else
+static const prk::dispatch::table<rsqrt_estimate_t> rsqrtEstimate{
+  rsqrtEstimate_generic, nullptr, nullptr, nullptr, nullptr };
+#endif
+
+/* Distances of a block of particles to the corners of their cells, with
+   the squared distances in single precision for the estimates of 1/r */
+static PRK_ALWAYS_INLINE void forceDistances_body(const particle_t * RESTRICT p, const uint64_t count,
+                                                  const uint64_t L, int64_t * RESTRICT cell,
+                                                  double * RESTRICT dx, double * RESTRICT dy,
+                                                  double * RESTRICT q, float * RESTRICT r2)
+{
+  PRAGMA_SIMD
+  for (uint64_t i=0; i<count; i++) {
+    /* coordinates are non-negative, so truncation is floor */
+    const int x = (int) p[i].x;
+    const int y = (int) p[i].y;
+    const double dx0 = p[i].x - x, dx1 = 1.0 - dx0;
+    const double dy0 = p[i].y - y, dy1 = 1.0 - dy0;
+    cell[i] = x*(int64_t)(L+1) + y;
+    dx[i] = dx0;
+    dy[i] = dy0;
+    q[i]  = p[i].q;
+    r2[i]         = dx0*dx0 + dy0*dy0;
+    r2[i+count]   = dx0*dx0 + dy1*dy1;
+    r2[i+2*count] = dx1*dx1 + dy0*dy0;
+    r2[i+3*count] = dx1*dx1 + dy1*dy1;
+  }
+}
+
+PRK_MULTIVERSION(void, forceDistances,
+                 (const particle_t * RESTRICT p, const uint64_t count, const uint64_t L, int64_t * RESTRICT cell,
+                  double * RESTRICT dx, double * RESTRICT dy, double * RESTRICT q, float * RESTRICT r2),
+                 (p, count, L, cell, dx, dy, q, r2))
+
+/* 1/r^3 from r^2 and an estimate of 1/r, after one Newton-Raphson step in double */
+static PRK_ALWAYS_INLINE double rcube(const double r2, const double y0)
+{
+  const double y = y0 * (1.5 - 0.5 * r2 * y0 * y0);
+  return y * y * y;
+}
+
+/* Forces on a block of particles from the distances and the estimates of 1/r */
+static PRK_ALWAYS_INLINE void forceCharges_body(const uint64_t count, const uint64_t L,
+                                                const double * RESTRICT Qgrid, const int64_t * RESTRICT cell,
+                                                const double * RESTRICT dx, const double * RESTRICT dy,
+                                                const double * RESTRICT q, const float * RESTRICT y0,
+                                                double * RESTRICT fx, double * RESTRICT fy)
+{
+  PRAGMA_SIMD
+  for (uint64_t i=0; i<count; i++) {
+    const double dx0 = dx[i], dx1 = 1.0 - dx0;
+    const double dy0 = dy[i], dy1 = 1.0 - dy0;
+    const int64_t c = cell[i];
+
+    /* charge over distance cubed for the four corners */
+    const double s00 = Qgrid[c]     * rcube(dx0*dx0 + dy0*dy0, y0[i]);
+    const double s01 = Qgrid[c+1]   * rcube(dx0*dx0 + dy1*dy1, y0[i+count]);
+    const double s10 = Qgrid[c+L+1] * rcube(dx1*dx1 + dy0*dy0, y0[i+2*count]);
+    const double s11 = Qgrid[c+L+2] * rcube(dx1*dx1 + dy1*dy1, y0[i+3*count]);
+
+    fx[i] = q[i] * ( (s00+s01)*dx0 - (s10+s11)*dx1 );
+    fy[i] = q[i] * ( (s00+s10)*dy0 - (s01+s11)*dy1 );
+  }
+}
+
+PRK_MULTIVERSION(void, forceCharges,
+                 (const uint64_t count, const uint64_t L, const double * RESTRICT Qgrid, const int64_t * RESTRICT cell,
+                  const double * RESTRICT dx, const double * RESTRICT dy, const double * RESTRICT q,
+                  const float * RESTRICT y0, double * RESTRICT fx, double * RESTRICT fy),
+                 (count, L, Qgrid, cell, dx, dy, q, y0, fx, fy))
+
+/* Variants of the three steps of the rsqrt force kernel for one instruction set */
+typedef struct {
+  decltype(&forceDistances_generic) distances;
+  rsqrt_estimate_t                  estimate;
+  decltype(&forceCharges_generic)   charges;
+} force_kernel_t;
+
+/* Computes the total Coulomb force on a block of at most FORCE_BLOCK particles,
+   like computeTotalForce */
+void computeTotalForceRsqrt(const particle_t * RESTRICT p, const uint64_t count, const uint64_t L,
+                            const double * RESTRICT Qgrid, const force_kernel_t & kernel,
+                            double * RESTRICT fx, double * RESTRICT fy)
+{
+  int64_t cell[FORCE_BLOCK];
+  double  dx[FORCE_BLOCK], dy[FORCE_BLOCK], q[FORCE_BLOCK];
+  float   r2[4*FORCE_BLOCK], y0[4*FORCE_BLOCK];
+
+  kernel.distances(p, count, L, cell, dx, dy, q, r2);
+  kernel.estimate(r2, y0, 4*count);
+  kernel.charges(count, L, Qgrid, cell, dx, dy, q, y0, fx, fy);
+}
+
 int bad_patch(bbox_t *patch, bbox_t *patch_contain) {
   if (patch->left>=patch->right || patch->bottom>=patch->top) return(1);
   if (patch_contain) {
@@ -429,6 +598,8 @@ int main(int argc, char ** argv) {
                                  // particles-- (2*k)+1 cells per time step
   bbox_t      grid_patch,        // whole grid
               init_patch;        // subset of grid used for localized initialization
+  bool        use_rsqrt;         // force kernel
+  int         next_arg = 7;      // first argument after the init parameters
 
 
   try {
@@ -437,11 +608,12 @@ int main(int argc, char ** argv) {
                 << " <#simulation steps> <grid size> <#particles>"
                 << " <k (particle charge semi-increment)> " << std::endl;
       std::cout << "<m (vertical particle velocity)>" << std::endl;
-      std::cout << "          <init mode> <init parameters>]" << std::endl;
+      std::cout << "          <init mode> <init parameters> [<force kernel>]" << std::endl;
       std::cout << "   init mode \"GEOMETRIC\"  parameters: <attenuation factor>" << std::endl;
       std::cout << "             \"SINUSOIDAL\" parameters: none" << std::endl;
       std::cout << "             \"LINEAR\"     parameters: <negative slope> <constant offset>" << std::endl;
       std::cout << "             \"PATCH\"      parameters: <xleft> <xright>  <ybottom> <ytop>" << std::endl;
+      std::cout << "   force kernel: exact (default) or rsqrt" << std::endl;
       throw "";
     }
 
@@ -475,6 +647,7 @@ int main(int argc, char ** argv) {
       }
       particle_mode = GEOMETRIC;
       rho = std::atof(argv[7]);
+      next_arg = 8;
     }
 
     /* Initialize with a sinusoidal particle distribution (single period) */
@@ -491,6 +664,7 @@ int main(int argc, char ** argv) {
       particle_mode = LINEAR;
       alpha = std::atof(argv[7]);
       beta  = std::atof(argv[8]);
+      next_arg = 9;
       if (beta <0 || beta<alpha) {
         throw "ERROR: linear profile gives negative particle density.";
       }
@@ -506,10 +680,17 @@ int main(int argc, char ** argv) {
       init_patch.right  = std::atoi(argv[8]);
       init_patch.bottom = std::atoi(argv[9]);
       init_patch.top    = std::atoi(argv[10]);
+      next_arg = 11;
       if (bad_patch(&init_patch, &grid_patch)) {
         throw "ERROR: inconsistent initial patch.";
       }
     }
+
+    std::string force_mode = (argc>next_arg) ? std::string(argv[next_arg]) : std::string("exact");
+    if (force_mode != "exact" && force_mode != "rsqrt") {
+      throw "ERROR: force kernel must be exact or rsqrt.";
+    }
+    use_rsqrt = (force_mode == "rsqrt");
   }
   catch (const char * e) {
     std::cout << e << std::endl;
@@ -542,6 +723,14 @@ int main(int argc, char ** argv) {
   }
   std::cout << "Particle charge semi-increment = " << k << std::endl;
   std::cout << "Vertical velocity              = " << m << std::endl;
+  std::cout << "Force kernel                   = " << (use_rsqrt ? "rsqrt" : "exact") << std::endl;
+
+  auto const isa = prk::dispatch::select();
+  const force_kernel_t kernel{ PRK_DISPATCH_TABLE(forceDistances)(isa), rsqrtEstimate(isa),
+                               PRK_DISPATCH_TABLE(forceCharges)(isa) };
+  if (use_rsqrt) {
+    std::cout << "Instruction set                = " << prk::dispatch::name(isa) << std::endl;
+  }
 
   /* Initialize grid of charges and particles */
   double * Qgrid = initializeGrid(L);
@@ -570,11 +759,93 @@ int main(int argc, char ** argv) {
 
   std::cout << "Number of particles placed     = " << n << std::endl;
 
+  prk::vector<double> Fx(FORCE_BLOCK), Fy(FORCE_BLOCK);
+
+  if (use_rsqrt) {
+      /* Error of the rsqrt kernel in units of the last place of the force magnitude */
+      double max_ulp{0}, sum_ulp{0}, max_err{0};
+      for (uint64_t b=0; b<n; b+=FORCE_BLOCK) {
+          const uint64_t count = std::min(FORCE_BLOCK, n-b);
+          computeTotalForceRsqrt(&particles[b], count, L, Qgrid, kernel, Fx.data(), Fy.data());
+          for (uint64_t i=0; i<count; i++) {
+              double fx, fy;
+              computeTotalForce(particles[b+i], L, Qgrid, fx, fy);
+              const double f = std::max(std::fabs(fx), std::fabs(fy));
+              const double ulp = std::nextafter(f, HUGE_VAL) - f;
+              const double err = std::max(std::fabs(Fx[i]-fx), std::fabs(Fy[i]-fy));
+              max_err = std::max(max_err, err);
+              max_ulp = std::max(max_ulp, err/ulp);
+              sum_ulp += err/ulp;
+          }
+      }
+
+      /* Force evaluation alone, best of a few passes; the volatile store
+         keeps the forces from being optimized away */
+      double t_exact{1.e30}, t_rsqrt{1.e30};
+      volatile double sink{0};
+      for (int r=0; r<3; r++) {
+          double acc{0};
+          double t = prk::wtime();
+          for (uint64_t i=0; i<n; i++) {
+              double fx, fy;
+              computeTotalForce(particles[i], L, Qgrid, fx, fy);
+              acc += fx + fy;
+          }
+          sink = acc;
+          t_exact = std::min(t_exact, prk::wtime() - t);
+          acc = 0;
+          t = prk::wtime();
+          for (uint64_t b=0; b<n; b+=FORCE_BLOCK) {
+              const uint64_t count = std::min(FORCE_BLOCK, n-b);
+              computeTotalForceRsqrt(&particles[b], count, L, Qgrid, kernel, Fx.data(), Fy.data());
+              acc += Fx[0] + Fy[0];
+          }
+          sink = acc;
+          t_rsqrt = std::min(t_rsqrt, prk::wtime() - t);
+      }
+      (void)sink;
+
+      std::cout << "Force error (ULP): max " << max_ulp << " mean " << sum_ulp/n << std::endl;
+      std::cout << "Force speedup (rsqrt/exact): " << t_exact/t_rsqrt << std::endl;
+
+      /* A force error e moves a particle by about e*T^2/2 after T steps */
+      if (max_err * (iterations+1.) * (iterations+1.) > epsilon) {
+          std::cout << "WARNING: rsqrt force error too large for " << iterations
+                    << " steps, using the exact kernel" << std::endl;
+          use_rsqrt = false;
+      }
+  }
+
   double pic_time;
+  prk::energy::meter energy;
   {
       for (int iter=0; iter<=iterations; iter++) {
 
-          if (iter==1) pic_time = prk::wtime();
+          if (iter==1) {
+              pic_time = prk::wtime();
+              energy.start();
+          }
+
+          if (use_rsqrt) {
+              for (uint64_t b = 0; b < n; b += FORCE_BLOCK) {
+                  const uint64_t count = std::min(FORCE_BLOCK, n-b);
+                  computeTotalForceRsqrt(&particles[b], count, L, Qgrid, kernel, Fx.data(), Fy.data());
+                  for (uint64_t i = b; i < b+count; ++i) {
+                      const double MASS_INV = 1.0;
+                      const double ax = Fx[i-b] * MASS_INV;
+                      const double ay = Fy[i-b] * MASS_INV;
+
+                      /* Update particle positions, taking into account periodic boundaries */
+                      particles[i].x = std::fmod(particles[i].x + particles[i].v_x*DT + 0.5*ax*DT*DT + L, (double)L);
+                      particles[i].y = std::fmod(particles[i].y + particles[i].v_y*DT + 0.5*ay*DT*DT + L, (double)L);
+
+                      /* Update velocities */
+                      particles[i].v_x += ax * DT;
+                      particles[i].v_y += ay * DT;
+                  }
+              }
+              continue;
+          }
 
           for (uint64_t i = 0; i < n; ++i) {
               double fx = 0.0;
@@ -596,12 +867,14 @@ int main(int argc, char ** argv) {
   }
 
   pic_time = prk::wtime() - pic_time;
+  energy.stop();
 
   /* Run the verification test */
-  int correct = true;
-  for (uint64_t i=0; i<n; i++) {
-    correct &= verifyParticle(particles[i], iterations, Qgrid, L);
-  }
+  const uint64_t failures = prk::transform_reduce(particles, particles+n, uint64_t(0),
+                                                  [=](const particle_t & p) {
+                                                      return verifyParticle(p, iterations, Qgrid, L) ? 0 : 1;
+                                                  });
+  int correct = (failures == 0);
 
   if (correct) {
       std::cout << "Solution validates" << std::endl;
@@ -610,6 +883,7 @@ int main(int argc, char ** argv) {
 #endif
     double avg_time = n*iterations/pic_time;
     std::cout << "Rate (Mparticles_moved/s): " << 1.0e-6*avg_time << std::endl;
+    energy.report(iterations, pic_time, 1.0e-6 * n, "Mparticle");
   } else {
     std::cout << "Solution does not validate" << std::endl;
   }
@@ -0,0 +1,200 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef PRK_DISPATCH_H
+#define PRK_DISPATCH_H
+
+// Runtime selection of instruction-set specific kernel variants.
+//
+// A kernel body is written once as an always-inline function and
+// PRK_MULTIVERSION stamps out one wrapper per instruction set, each
+// compiled with the matching target attribute, so the compiler
+// vectorizes the same source for SSE2, AVX2, AVX-512 or NEON.
+// prk::dispatch::select() picks the best variant the CPU supports.
+// PRK_ISA={generic,sse2,avx2,avx512,neon} in the environment can be
+// used to force a lower variant, e.g. for comparison.
+
+#include <cstdlib>
+#include <string>
+#include <iostream>
+
+#if defined(__linux__) && defined(__aarch64__)
+# include <sys/auxv.h>
+# include <asm/hwcap.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+# define PRK_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+# define PRK_ALWAYS_INLINE inline
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+# define PRK_DISPATCH_X86 1
+# define PRK_TARGET_SSE2   __attribute__((target("sse2")))
+# define PRK_TARGET_AVX2   __attribute__((target("avx2,fma")))
+# define PRK_TARGET_AVX512 __attribute__((target("avx512f,avx512vl,avx512dq,avx2,fma")))
+#elif defined(__aarch64__)
+// Advanced SIMD is part of the AArch64 baseline, so no attribute is needed.
+# define PRK_DISPATCH_ARM 1
+# define PRK_TARGET_NEON
+#endif
+
+#if defined(PRK_DISPATCH_X86)
+# define PRK_MULTIVERSION(ret, name, params, args)                         \
+    ret name##_generic params { return name##_body args; }                  \
+    PRK_TARGET_SSE2   ret name##_sse2   params { return name##_body args; } \
+    PRK_TARGET_AVX2   ret name##_avx2   params { return name##_body args; } \
+    PRK_TARGET_AVX512 ret name##_avx512 params { return name##_body args; }
+# define PRK_DISPATCH_TABLE(name) \
+    prk::dispatch::table<decltype(&name##_generic)>{ name##_generic, name##_sse2, name##_avx2, name##_avx512, nullptr }
+#elif defined(PRK_DISPATCH_ARM)
+# define PRK_MULTIVERSION(ret, name, params, args)                         \
+    ret name##_generic params { return name##_body args; }                  \
+    PRK_TARGET_NEON   ret name##_neon   params { return name##_body args; }
+# define PRK_DISPATCH_TABLE(name) \
+    prk::dispatch::table<decltype(&name##_generic)>{ name##_generic, nullptr, nullptr, nullptr, name##_neon }
+#else
+# define PRK_MULTIVERSION(ret, name, params, args)                         \
+    ret name##_generic params { return name##_body args; }
+# define PRK_DISPATCH_TABLE(name) \
+    prk::dispatch::table<decltype(&name##_generic)>{ name##_generic, nullptr, nullptr, nullptr, nullptr }
+#endif
+
+namespace prk {
+namespace dispatch {
+
+    enum class isa : int { generic = 0, sse2, avx2, avx512, neon };
+
+    inline const char * name(isa x)
+    {
+        switch (x) {
+            case isa::sse2:   return "SSE2";
+            case isa::avx2:   return "AVX2";
+            case isa::avx512: return "AVX-512";
+            case isa::neon:   return "NEON";
+            default:          return "generic";
+        }
+    }
+
+    // spelling used by PRK_ISA
+    inline const char * key(isa x)
+    {
+        switch (x) {
+            case isa::sse2:   return "sse2";
+            case isa::avx2:   return "avx2";
+            case isa::avx512: return "avx512";
+            case isa::neon:   return "neon";
+            default:          return "generic";
+        }
+    }
+
+    inline bool supported(isa x)
+    {
+        switch (x) {
+#if defined(PRK_DISPATCH_X86)
+            case isa::sse2:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("sse2");
+            case isa::avx2:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+            case isa::avx512:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl")
+                    && __builtin_cpu_supports("avx512dq");
+#elif defined(PRK_DISPATCH_ARM)
+            case isa::neon:
+# if defined(__linux__) && defined(HWCAP_ASIMD)
+                return (getauxval(AT_HWCAP) & HWCAP_ASIMD);
+# else
+                return true;
+# endif
+#endif
+            case isa::generic:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    inline isa detect(void)
+    {
+        for (auto x : { isa::avx512, isa::avx2, isa::sse2, isa::neon }) {
+            if (supported(x)) return x;
+        }
+        return isa::generic;
+    }
+
+    inline isa select(void)
+    {
+        isa best = detect();
+        const char * e = std::getenv("PRK_ISA");
+        if (e == nullptr) return best;
+
+        auto s = std::string(e);
+        for (auto x : { isa::generic, isa::sse2, isa::avx2, isa::avx512, isa::neon }) {
+            if (s == key(x)) {
+                if (supported(x)) return x;
+                std::cout << "WARNING: PRK_ISA=" << s << " is not supported by this CPU (ignoring)" << std::endl;
+                return best;
+            }
+        }
+        std::cout << "WARNING: PRK_ISA=" << s << " is not recognized (ignoring)" << std::endl;
+        return best;
+    }
+
+    template <typename F>
+    struct table {
+        F generic;
+        F sse2;
+        F avx2;
+        F avx512;
+        F neon;
+
+        F operator()(isa x) const
+        {
+            F f = nullptr;
+            switch (x) {
+                case isa::sse2:   f = sse2;   break;
+                case isa::avx2:   f = avx2;   break;
+                case isa::avx512: f = avx512; break;
+                case isa::neon:   f = neon;   break;
+                default:          f = generic; break;
+            }
+            return (f != nullptr) ? f : generic;
+        }
+    };
+
+} // namespace dispatch
+} // namespace prk
+
+#endif /* PRK_DISPATCH_H */
@@ -0,0 +1,237 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef PRK_ENERGY_H
+#define PRK_ENERGY_H
+
+// Energy of a timed region from the Linux powercap interface.
+//
+// Intel and recent AMD processors expose RAPL counters as
+//   /sys/class/powercap/intel-rapl:<p>     package <p>
+//   /sys/class/powercap/intel-rapl:<p>:<s> subzones: core, uncore, dram
+// with energy_uj counting microjoules modulo max_energy_range_uj.  Older
+// AMD kernels have the amd_energy hwmon driver instead, with one
+// energy<N>_input per socket labelled Esocket<p>.
+//
+// The package and DRAM domains are summed; core and uncore are part of
+// the package and psys is a superset, so they are not.  A counter that
+// reads lower at the end of a region than at the start has wrapped once;
+// regions longer than one wrap period (minutes at full power) need calls
+// to sample() in between.  A region made of several timed intervals calls
+// skip() before and sample() after each of them.
+//
+// PRK_POWERCAP overrides /sys/class/powercap, e.g. for a bind mount in a
+// container; when it is set, only that tree is read and there is no hwmon
+// fallback.  Without readable counters (no interface, or the counters are
+// root-only) the meter is a stub: available() is false and report()
+// prints nothing.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#if defined(__linux__)
+# include <dirent.h>
+#endif
+
+namespace prk {
+namespace energy {
+
+    class meter {
+
+        private:
+            struct domain {
+                std::string name;
+                std::string counter;    // file with the microjoule counter
+                uint64_t range;         // counter wraps at this value
+                uint64_t last;
+                uint64_t total;         // microjoules since start()
+                bool dram;
+            };
+            std::vector<domain> domains_;
+
+            static bool read(const std::string & file, uint64_t & value)
+            {
+                std::ifstream f(file);
+                return static_cast<bool>(f >> value);
+            }
+
+            static std::string read_line(const std::string & file)
+            {
+                std::ifstream f(file);
+                std::string s;
+                std::getline(f, s);
+                return s;
+            }
+
+            static std::vector<std::string> list(const std::string & dir, const std::string & prefix)
+            {
+                std::vector<std::string> names;
+#if defined(__linux__)
+                DIR * d = opendir(dir.c_str());
+                if (d == nullptr) return names;
+                while (struct dirent * e = readdir(d)) {
+                    const std::string n(e->d_name);
+                    if (n.compare(0, prefix.size(), prefix) == 0) names.push_back(n);
+                }
+                closedir(d);
+                std::sort(names.begin(), names.end());
+#else
+                (void)dir; (void)prefix;
+#endif
+                return names;
+            }
+
+            void add(const std::string & name, const std::string & counter, uint64_t range, bool dram)
+            {
+                uint64_t v;
+                if (read(counter, v)) {
+                    domains_.push_back({name, counter, range, v, 0, dram});
+                }
+            }
+
+            void find_powercap(void)
+            {
+                const char * env = std::getenv("PRK_POWERCAP");
+                const std::string root = env ? env : "/sys/class/powercap";
+                for (const auto & zone : list(root, "intel-rapl:")) {
+                    const std::string dir = root + "/" + zone;
+                    const std::string name = read_line(dir + "/name");
+                    const bool dram = (name == "dram");
+                    if (name.compare(0,8,"package-") != 0 && !dram) continue;
+                    uint64_t range = 0;
+                    read(dir + "/max_energy_range_uj", range);
+                    add(name, dir + "/energy_uj", range, dram);
+                }
+            }
+
+            void find_hwmon(void)
+            {
+                const std::string root = "/sys/class/hwmon";
+                for (const auto & hw : list(root, "hwmon")) {
+                    const std::string dir = root + "/" + hw;
+                    if (read_line(dir + "/name") != "amd_energy") continue;
+                    for (const auto & label : list(dir, "energy")) {
+                        if (label.find("_label") == std::string::npos) continue;
+                        const std::string l = read_line(dir + "/" + label);
+                        if (l.compare(0,7,"Esocket") != 0) continue;
+                        const std::string input = label.substr(0, label.find("_label")) + "_input";
+                        add("package-" + l.substr(7), dir + "/" + input, 0, false);
+                    }
+                }
+            }
+
+        public:
+
+            meter(void)
+            {
+                find_powercap();
+                if (domains_.empty() && std::getenv("PRK_POWERCAP") == nullptr) find_hwmon();
+            }
+
+            bool available(void) const { return !domains_.empty(); }
+
+            // accumulate the counters since the last sample
+            void sample(void)
+            {
+                for (auto & d : domains_) {
+                    uint64_t v;
+                    if (!read(d.counter, v)) continue;
+                    if (v >= d.last) {
+                        d.total += v - d.last;
+                    } else if (d.range > 0) {
+                        d.total += (d.range - d.last) + v;
+                    }
+                    d.last = v;
+                }
+            }
+
+            // drop the energy since the last sample, e.g. untimed validation
+            void skip(void)
+            {
+                for (auto & d : domains_) {
+                    uint64_t v;
+                    if (read(d.counter, v)) d.last = v;
+                }
+            }
+
+            void start(void)
+            {
+                sample();
+                for (auto & d : domains_) d.total = 0;
+            }
+
+            void stop(void) { sample(); }
+
+            // joules between start() and stop()
+            double package(void) const
+            {
+                uint64_t uj = 0;
+                for (const auto & d : domains_) if (!d.dram) uj += d.total;
+                return 1.e-6 * uj;
+            }
+
+            double dram(void) const
+            {
+                uint64_t uj = 0;
+                for (const auto & d : domains_) if (d.dram) uj += d.total;
+                return 1.e-6 * uj;
+            }
+
+            double joules(void) const { return package() + dram(); }
+
+            // Energy per iteration, average power, and work per joule, where
+            // work is the amount done per iteration in the units of the rate,
+            // e.g. report(iterations, time, 1.e-6*nbytes, "MB").
+            void report(int iterations, double seconds, double work, const std::string & unit) const
+            {
+                if (!available() || iterations < 1 || seconds <= 0.0) return;
+                const double j = joules();
+                std::cout << "Energy (J/iter): " << j/iterations
+                          << " Power (W): " << j/seconds
+                          << " (package " << package()/seconds
+                          << ", DRAM " << dram()/seconds << ")";
+                if (j > 0.0) {
+                    std::cout << " Efficiency (" << unit << "/J): " << work*iterations/j;
+                }
+                std::cout << std::endl;
+            }
+    };
+
+} // namespace energy
+} // namespace prk
+
+#endif /* PRK_ENERGY_H */
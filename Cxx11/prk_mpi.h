@@ -4,11 +4,15 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cinttypes>
+#include <climits>
 
 #include <iostream>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <numeric> // exclusive_scan
+#include <tuple>
+#include <limits>
 #include <type_traits>
 
 #include <mpi.h>
@@ -391,6 +395,486 @@ namespace prk
 
         };
 
+        // Block decomposition of a box of global extents over a process grid.
+        // With node_aware, the ranks of each node tile a compact sub-block of
+        // the process grid, so that most halo traffic stays on the node;
+        // otherwise ranks are placed in row-major order.  Nodes are found with
+        // MPI_COMM_TYPE_SHARED, or emulated as groups of ranks_per_node
+        // consecutive ranks.  Node-aware placement needs equally-sized nodes
+        // and falls back to row-major order otherwise.
+        class decomposition {
+
+          private:
+            int ndims_, np_, me_;
+            int nodes_, ranks_per_node_;
+            bool node_aware_;
+
+            MPI_Comm comm_, graph_comm_;
+
+            std::vector<size_t> extents_;
+            std::vector<int> dims_, node_dims_, coords_;
+            std::vector<int> row_major_dims_; // the balanced grid of a naive placement
+
+            std::vector<int> node_of_;      // node of each rank
+            std::vector<int> rank_at_;      // rank at each grid position (row-major)
+
+            std::vector<std::vector<int>> all_offsets_; // halo offsets of every rank
+            std::vector<std::vector<int>> offsets_;     // graph neighbors, in graph order
+            std::vector<int> neighbors_;                // their ranks in graph_comm_
+            size_t width_, word_;
+
+            static std::vector<int> unravel(int k, const std::vector<int> & dims)
+            {
+                std::vector<int> c(dims.size());
+                for (int d=static_cast<int>(dims.size())-1; d>=0; --d) {
+                    c[d] = k % dims[d];
+                    k /= dims[d];
+                }
+                return c;
+            }
+
+            static int ravel(const std::vector<int> & c, const std::vector<int> & dims)
+            {
+                int k = 0;
+                for (size_t d=0; d<dims.size(); ++d) {
+                    k = k*dims[d] + c[d];
+                }
+                return k;
+            }
+
+            // all ordered factorizations of n into ndims factors
+            static void factorizations(int n, int ndims, std::vector<int> & f,
+                                       std::vector<std::vector<int>> & out)
+            {
+                if (static_cast<int>(f.size()) == ndims-1) {
+                    f.push_back(n);
+                    out.push_back(f);
+                    f.pop_back();
+                    return;
+                }
+                for (int k=1; k<=n; ++k) {
+                    if (n%k) continue;
+                    f.push_back(k);
+                    factorizations(n/k, ndims, f, out);
+                    f.pop_back();
+                }
+            }
+
+            size_t block_begin(const std::vector<int> & dims, int d, int c) const
+            {
+                const size_t n = extents_[d], p = dims[d];
+                return c*(n/p) + std::min(static_cast<size_t>(c), n%p);
+            }
+
+            // bytes of the halo that grid position c sends toward offset o
+            double face_bytes(const std::vector<int> & dims, const std::vector<int> & c,
+                              const std::vector<int> & o) const
+            {
+                double bytes = word_;
+                for (int d=0; d<ndims_; ++d) {
+                    bytes *= (o[d]==0) ? block_begin(dims,d,c[d]+1) - block_begin(dims,d,c[d]) : width_;
+                }
+                return bytes;
+            }
+
+            // the process grid and node sub-block with the fewest cut points
+            std::pair<std::vector<int>,std::vector<int>>
+            choose(const std::vector<std::vector<int>> & grids, const std::vector<std::vector<int>> & blocks) const
+            {
+                std::pair<std::vector<int>,std::vector<int>> best;
+                double best_inter = -1, best_total = -1;
+                for (auto & p : grids) {
+                    bool fits = true;
+                    for (int d=0; d<ndims_; ++d) fits &= (static_cast<size_t>(p[d]) <= extents_[d]);
+                    if (!fits) continue;
+                    for (auto & b : blocks) {
+                        bool divides = true;
+                        for (int d=0; d<ndims_; ++d) divides &= (p[d] % b[d] == 0);
+                        if (!divides) continue;
+                        double inter = 0, total = 0;
+                        for (int d=0; d<ndims_; ++d) {
+                            double plane = 1;
+                            for (int e=0; e<ndims_; ++e) if (e!=d) plane *= extents_[e];
+                            inter += (p[d]/b[d]-1) * plane;
+                            total += (p[d]-1) * plane;
+                        }
+                        if (best_inter < 0 || inter < best_inter || (inter == best_inter && total < best_total)) {
+                            best_inter = inter;
+                            best_total = total;
+                            best = {p, b};
+                        }
+                    }
+                }
+                return best;
+            }
+
+          public:
+            decomposition(const std::vector<size_t> & extents, bool node_aware = true,
+                          int ranks_per_node = 0, MPI_Comm comm = MPI_COMM_WORLD)
+                : graph_comm_(MPI_COMM_NULL), extents_(extents), width_(0), word_(0)
+            {
+                prk::MPI::check( MPI_Comm_dup(comm, &comm_) );
+                np_ = prk::MPI::size(comm_);
+                me_ = prk::MPI::rank(comm_);
+                ndims_ = static_cast<int>(extents_.size());
+
+                // identify each node by its lowest rank
+                int mine[2];
+                if (ranks_per_node > 0) {
+                    mine[0] = me_ - me_ % ranks_per_node;
+                    mine[1] = me_ % ranks_per_node;
+                } else {
+                    MPI_Comm node_comm;
+                    prk::MPI::check( MPI_Comm_split_type(comm_, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node_comm) );
+                    mine[0] = me_;
+                    prk::MPI::check( MPI_Bcast(&mine[0], 1, MPI_INT, 0, node_comm) );
+                    mine[1] = prk::MPI::rank(node_comm);
+                    prk::MPI::check( MPI_Comm_free(&node_comm) );
+                }
+                std::vector<int> all(2*np_);
+                prk::MPI::check( MPI_Allgather(mine, 2, MPI_INT, all.data(), 2, MPI_INT, comm_) );
+
+                std::vector<int> leaders;
+                for (int r=0; r<np_; ++r) {
+                    if (all[2*r]==r) leaders.push_back(r);
+                }
+                nodes_ = static_cast<int>(leaders.size());
+                node_of_.resize(np_);
+                std::vector<int> count(nodes_,0);
+                for (int r=0; r<np_; ++r) {
+                    node_of_[r] = std::lower_bound(leaders.begin(), leaders.end(), all[2*r]) - leaders.begin();
+                    count[node_of_[r]]++;
+                }
+                const bool uniform = std::all_of(count.begin(), count.end(), [&](int c) { return c==count[0]; });
+                ranks_per_node_ = uniform ? count[0] : 0;
+                node_aware_ = node_aware && uniform;
+
+                // Choose the process grid and node sub-block that cut the fewest
+                // inter-node halo points, then the fewest halo points overall.
+                // Each of the p[d]-1 cuts along d is a plane of the other extents.
+                // Without node sub-blocks this is the balanced row-major grid.
+                const int block_ranks = node_aware_ ? ranks_per_node_ : 1;
+                std::vector<std::vector<int>> grids, blocks, singles;
+                std::vector<int> f;
+                factorizations(np_, ndims_, f, grids);
+                factorizations(block_ranks, ndims_, f, blocks);
+                factorizations(1, ndims_, f, singles);
+                row_major_dims_ = choose(grids, singles).first;
+                std::tie(dims_, node_dims_) = choose(grids, blocks);
+                if (dims_.empty()) {
+                    if (me_ == 0) std::cerr << "cannot decompose the grid over " << np_ << " processes" << std::endl;
+                    prk::MPI::abort();
+                }
+
+                rank_at_.resize(np_);
+                if (node_aware_) {
+                    std::vector<int> node_grid(ndims_), c(ndims_);
+                    for (int d=0; d<ndims_; ++d) node_grid[d] = dims_[d] / node_dims_[d];
+                    for (int r=0; r<np_; ++r) {
+                        auto nc = unravel(node_of_[r], node_grid);
+                        auto lc = unravel(all[2*r+1], node_dims_);
+                        for (int d=0; d<ndims_; ++d) c[d] = nc[d]*node_dims_[d] + lc[d];
+                        rank_at_[ravel(c,dims_)] = r;
+                    }
+                } else {
+                    std::iota(rank_at_.begin(), rank_at_.end(), 0);
+                }
+                const int position = std::find(rank_at_.begin(), rank_at_.end(), me_) - rank_at_.begin();
+                coords_ = unravel(position, dims_);
+            }
+
+            decomposition(const decomposition &) = delete;
+            decomposition & operator=(const decomposition &) = delete;
+
+            ~decomposition(void) noexcept
+            {
+                if (graph_comm_ != MPI_COMM_NULL) {
+                    prk::MPI::check( MPI_Comm_free(&graph_comm_) );
+                }
+                prk::MPI::check( MPI_Comm_free(&comm_) );
+            }
+
+            int ndims(void) const { return ndims_; }
+            int nodes(void) const { return nodes_; }
+            int ranks_per_node(void) const { return ranks_per_node_; }
+            bool node_aware(void) const { return node_aware_; }
+
+            const std::vector<int> & dims(void) const { return dims_; }
+            const std::vector<int> & node_dims(void) const { return node_dims_; }
+            const std::vector<int> & coords(void) const { return coords_; }
+
+            // the global index range [begin,end) owned along dimension d
+            size_t begin(int d) const { return block_begin(dims_, d, coords_[d]); }
+            size_t end(int d)   const { return block_begin(dims_, d, coords_[d]+1); }
+
+            // Creates a distributed graph of the neighbors at the given offsets
+            // that exist, weighted by the bytes of a halo of the given width,
+            // and lets MPI reorder the ranks.  A reordered process moves to
+            // another grid position, so coords(), begin() and end() are only
+            // final after this call.  Neighbor collectives on graph() follow
+            // the order of neighbor_offsets().
+            MPI_Comm create_graph(const std::vector<std::vector<int>> & offsets, size_t width, size_t word)
+            {
+                width_ = width;
+                word_  = word;
+                all_offsets_ = offsets;
+                offsets_.clear();
+                std::vector<int> ranks, weights;
+                std::vector<int> c(ndims_);
+                for (auto & o : offsets) {
+                    bool inside = true;
+                    for (int d=0; d<ndims_; ++d) {
+                        c[d] = coords_[d] + o[d];
+                        inside &= (0 <= c[d] && c[d] < dims_[d]);
+                    }
+                    if (!inside) continue;
+                    offsets_.push_back(o);
+                    ranks.push_back(rank_at_[ravel(c,dims_)]);
+                    weights.push_back(static_cast<int>(std::min(face_bytes(dims_,coords_,o), static_cast<double>(INT_MAX))));
+                }
+                const int degree = static_cast<int>(ranks.size());
+                if (graph_comm_ != MPI_COMM_NULL) {
+                    prk::MPI::check( MPI_Comm_free(&graph_comm_) );
+                }
+                prk::MPI::check( MPI_Dist_graph_create_adjacent(comm_, degree, ranks.data(), weights.data(),
+                                                                degree, ranks.data(), weights.data(),
+                                                                MPI_INFO_NULL, 1 /* reorder */, &graph_comm_) );
+
+                // The vertices of the graph are the ranks of graph_comm_, so a
+                // reordered process takes the grid position and neighbors that
+                // the process of its new rank in comm_ specified.
+                std::vector<int> process(np_); // rank in comm_ of the process at each vertex
+                prk::MPI::check( MPI_Allgather(&me_, 1, MPI_INT, process.data(), 1, MPI_INT, graph_comm_) );
+                for (auto & r : rank_at_) {
+                    r = process[r];
+                }
+                const int position = std::find(rank_at_.begin(), rank_at_.end(), me_) - rank_at_.begin();
+                coords_ = unravel(position, dims_);
+                offsets_.clear();
+                for (auto & o : offsets) {
+                    bool inside = true;
+                    for (int d=0; d<ndims_; ++d) {
+                        c[d] = coords_[d] + o[d];
+                        inside &= (0 <= c[d] && c[d] < dims_[d]);
+                    }
+                    if (inside) offsets_.push_back(o);
+                }
+
+                int indegree, outdegree, weighted;
+                prk::MPI::check( MPI_Dist_graph_neighbors_count(graph_comm_, &indegree, &outdegree, &weighted) );
+                if (indegree != static_cast<int>(offsets_.size()) || outdegree != indegree) {
+                    std::cerr << "graph degree " << indegree << " does not match "
+                              << offsets_.size() << " neighbors at the grid position" << std::endl;
+                    prk::MPI::abort();
+                }
+                neighbors_.resize(outdegree);
+                std::vector<int> sources(indegree), source_weights(indegree), dest_weights(outdegree);
+                prk::MPI::check( MPI_Dist_graph_neighbors(graph_comm_, indegree, sources.data(), source_weights.data(),
+                                                          outdegree, neighbors_.data(), dest_weights.data()) );
+                return graph_comm_;
+            }
+
+            MPI_Comm graph(void) const { return graph_comm_; }
+            const std::vector<std::vector<int>> & neighbor_offsets(void) const { return offsets_; }
+            const std::vector<int> & neighbors(void) const { return neighbors_; }
+
+            // Total bytes of one halo exchange over the graph that stay on a node
+            // and that cross nodes, for this placement or for row-major order.
+            void halo_bytes(double * intra, double * inter, bool row_major = false) const
+            {
+                *intra = *inter = 0;
+                const auto & dims = row_major ? row_major_dims_ : dims_;
+                std::vector<int> c(ndims_);
+                for (int k=0; k<np_; ++k) {
+                    const auto pc = unravel(k, dims);
+                    const int r = row_major ? k : rank_at_[k];
+                    for (auto & o : all_offsets_) {
+                        bool inside = true;
+                        for (int d=0; d<ndims_; ++d) {
+                            c[d] = pc[d] + o[d];
+                            inside &= (0 <= c[d] && c[d] < dims[d]);
+                        }
+                        if (!inside) continue;
+                        const int q = row_major ? ravel(c,dims) : rank_at_[ravel(c,dims)];
+                        const double bytes = face_bytes(dims, pc, o);
+                        (node_of_[r] == node_of_[q] ? *intra : *inter) += bytes;
+                    }
+                }
+            }
+        };
+
+        // A snapshot of distributed fields in one shared file, written with
+        // collective MPI-IO and read back for a restart.  This is the C++
+        // version of common/snapshot.c, whose notes describe the file layout
+        // and the asynchronous write; the file is removed on destruction.
+        class snapshot {
+
+          private:
+            std::string name_;
+            MPI_Comm comm_;
+            MPI_Info info_;
+            MPI_Datatype filetype_;
+            MPI_File fh_;
+            MPI_Request request_;
+            bool pending_;
+            std::vector<double> buffer_;
+            double bytes_, start_, write_time_, exposed_time_;
+
+            void check_count(MPI_Status * status, const char * what)
+            {
+                int count;
+                prk::MPI::check( MPI_Get_count(status, MPI_DOUBLE, &count) );
+                if (static_cast<size_t>(count) != buffer_.size()) {
+                    std::cerr << what << " of snapshot file " << name_ << " transferred " << count
+                              << " of " << buffer_.size() << " doubles" << std::endl;
+                    prk::MPI::abort();
+                }
+            }
+
+            void open(int amode)
+            {
+                if (MPI_File_open(comm_, name_.c_str(), amode, info_, &fh_) != MPI_SUCCESS) {
+                    std::cerr << "could not open snapshot file " << name_ << std::endl;
+                    prk::MPI::abort();
+                }
+                prk::MPI::check( MPI_File_set_view(fh_, 0, MPI_DOUBLE, filetype_, "native", info_) );
+            }
+
+          public:
+            snapshot(const std::string & name, const std::vector<int> & sizes, const std::vector<int> & subsizes,
+                     const std::vector<int> & starts, int fields, int aggregators = 0, MPI_Comm comm = MPI_COMM_WORLD)
+                : name_(name), comm_(comm), pending_(false), start_(0), write_time_(0), exposed_time_(0)
+            {
+                const int ndims = static_cast<int>(sizes.size());
+                size_t count = fields;
+                bytes_ = fields * sizeof(double);
+                for (int d=0; d<ndims; ++d) {
+                    count  *= subsizes[d];
+                    bytes_ *= sizes[d];
+                }
+                buffer_.resize(count);
+
+                MPI_Datatype field;
+                MPI_Aint lb, extent;
+                prk::MPI::check( MPI_Type_create_subarray(ndims, sizes.data(), subsizes.data(), starts.data(),
+                                                          MPI_ORDER_C, MPI_DOUBLE, &field) );
+                prk::MPI::check( MPI_Type_get_extent(field, &lb, &extent) );
+                prk::MPI::check( MPI_Type_create_hvector(fields, 1, extent, field, &filetype_) );
+                prk::MPI::check( MPI_Type_commit(&filetype_) );
+                prk::MPI::check( MPI_Type_free(&field) );
+
+                prk::MPI::check( MPI_Info_create(&info_) );
+                prk::MPI::check( MPI_Info_set(info_, "collective_buffering", "true") );
+                prk::MPI::check( MPI_Info_set(info_, "romio_cb_write", "enable") );
+                prk::MPI::check( MPI_Info_set(info_, "romio_cb_read", "enable") );
+                if (aggregators > 0) {
+                    prk::MPI::check( MPI_Info_set(info_, "cb_nodes", std::to_string(aggregators).c_str()) );
+                }
+            }
+
+            snapshot(const snapshot &) = delete;
+            snapshot & operator=(const snapshot &) = delete;
+
+            ~snapshot(void) noexcept
+            {
+                wait();
+                prk::MPI::barrier(comm_);
+                if (prk::MPI::rank(comm_) == 0) {
+                    prk::MPI::check( MPI_File_delete(name_.c_str(), MPI_INFO_NULL) );
+                }
+                prk::MPI::check( MPI_Type_free(&filetype_) );
+                prk::MPI::check( MPI_Info_free(&info_) );
+            }
+
+            double * buffer(void) { return buffer_.data(); }
+            size_t size(void) const { return buffer_.size(); }
+
+            // global bytes of all fields, and the times of the last write
+            double bytes(void) const { return bytes_; }
+            double write_time(void) const { return write_time_; }
+            double exposed_time(void) const { return exposed_time_; }
+
+            // writes the buffer, or only starts to if async
+            void write(bool async)
+            {
+                const double t0 = prk::MPI::wtime();
+                start_ = t0;
+                open(MPI_MODE_CREATE | MPI_MODE_WRONLY);
+                const int count = static_cast<int>(buffer_.size());
+                MPI_Status status;
+                if (async) {
+                    prk::MPI::check( MPI_File_iwrite_all(fh_, buffer_.data(), count, MPI_DOUBLE, &request_) );
+                    pending_ = true;
+                    exposed_time_ = prk::MPI::wtime() - t0;
+                } else {
+                    prk::MPI::check( MPI_File_write_all(fh_, buffer_.data(), count, MPI_DOUBLE, &status) );
+                    check_count(&status, "write");
+                    prk::MPI::check( MPI_File_close(&fh_) );
+                    write_time_ = exposed_time_ = prk::MPI::wtime() - t0;
+                }
+            }
+
+            // progresses an asynchronous write
+            void test(void)
+            {
+                if (!pending_ || request_ == MPI_REQUEST_NULL) return;
+                const double t0 = prk::MPI::wtime();
+                int done;
+                MPI_Status status;
+                prk::MPI::check( MPI_Test(&request_, &done, &status) );
+                if (done) check_count(&status, "write");
+                exposed_time_ += prk::MPI::wtime() - t0;
+            }
+
+            // completes an asynchronous write
+            void wait(void)
+            {
+                if (!pending_) return;
+                const double t0 = prk::MPI::wtime();
+                if (request_ != MPI_REQUEST_NULL) {
+                    MPI_Status status;
+                    prk::MPI::check( MPI_Wait(&request_, &status) );
+                    check_count(&status, "write");
+                }
+                prk::MPI::check( MPI_File_close(&fh_) );
+                const double t1 = prk::MPI::wtime();
+                exposed_time_ += t1 - t0;
+                write_time_    = t1 - start_;
+                pending_       = false;
+            }
+
+            // reads the owned fields of the file into size() doubles at data,
+            // which must not be the buffer of the write
+            void read(double * data)
+            {
+                std::fill_n(data, buffer_.size(), std::numeric_limits<double>::quiet_NaN());
+                open(MPI_MODE_RDONLY);
+                MPI_Status status;
+                prk::MPI::check( MPI_File_read_all(fh_, data, static_cast<int>(buffer_.size()), MPI_DOUBLE, &status) );
+                check_count(&status, "read");
+                prk::MPI::check( MPI_File_close(&fh_) );
+            }
+
+            // writes the buffer to one local file per rank, for comparison,
+            // and returns the time of the slowest rank
+            double write_local(void)
+            {
+                const std::string name = name_ + "." + std::to_string(prk::MPI::rank(comm_));
+                prk::MPI::barrier(comm_);
+                double t = prk::MPI::wtime();
+                std::FILE * f = std::fopen(name.c_str(), "wb");
+                bool ok = (f != NULL) && std::fwrite(buffer_.data(), sizeof(double), buffer_.size(), f) == buffer_.size();
+                if (f != NULL) ok &= (std::fclose(f) == 0);
+                t = prk::MPI::wtime() - t;
+                std::remove(name.c_str());
+                if (!ok) {
+                    std::cerr << "could not write local file " << name << std::endl;
+                    prk::MPI::abort();
+                }
+                return prk::MPI::max(t, comm_);
+            }
+        };
+
     } // MPI namespace
 
 } // prk namespace
@@ -0,0 +1,76 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef PRK_STENCIL_H
+#define PRK_STENCIL_H
+
+#include <vector>
+
+namespace prk {
+namespace stencil {
+
+    // A nonzero of the star or box stencil of radius r.  Points come in
+    // pairs (di,dj,w) and (-di,-dj,-w) that share the index pair.
+    typedef struct {
+        int di, dj;         // offset of the point
+        double weight;      // constant weight
+        int pair;           // shared with the point at -(di,dj), which has -weight
+    } point_t;
+
+    // the points of the generated stencils, see generate-cxx-stencil.py
+    inline std::vector<point_t> points(bool star, int r)
+    {
+        std::vector<point_t> p;
+        auto add = [&](int di, int dj, double w) {
+            p.push_back({ di,  dj,  w, static_cast<int>(p.size()/2)});
+            p.push_back({-di, -dj, -w, static_cast<int>(p.size()/2)});
+        };
+        if (star) {
+            for (int i=1; i<=r; i++) {
+                add(0, i, 1./(2*i*r));
+                add(i, 0, 1./(2*i*r));
+            }
+        } else {
+            for (int j=1; j<=r; j++) {
+                for (int i=-j+1; i<j; i++) {
+                    add(i, j, 1./(4*j*(2*j-1)*r));
+                    add(j, i, 1./(4*j*(2*j-1)*r));
+                }
+                add(j, j, 1./(4*j*r));
+            }
+        }
+        return p;
+    }
+
+} // namespace stencil
+} // namespace prk
+
+#endif /* PRK_STENCIL_H */
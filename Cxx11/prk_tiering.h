@@ -0,0 +1,247 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef PRK_TIERING_H
+#define PRK_TIERING_H
+
+// Placement of arrays, or address ranges within them, on memory tiers.
+//
+// A tier is named by a string:
+//   dram       - default (first-touch) placement
+//   numa:<N>   - bind to NUMA node N, e.g. a CPU-less CXL or PMEM node
+//   file:<dir> - back the range with a file created in <dir>, e.g. a DAX
+//                mount, which emulates a slow tier on any machine
+//
+// Placement has to happen before the memory is first touched, and is
+// done at page granularity.  Invalid tier names throw, like the argument
+// checks in the drivers; placement failures at runtime abort.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <iostream>
+#include <vector>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#if defined(__linux__)
+# include <sys/syscall.h>
+#endif
+
+#ifndef MPOL_BIND
+# define MPOL_BIND 2
+#endif
+
+namespace prk {
+namespace tiering {
+
+    enum class kind { dram, numa, file };
+
+    class tier {
+
+        public:
+            kind type;
+            int node;
+            std::string path;
+
+            tier() : type(kind::dram), node(-1), path() {}
+
+            static tier parse(const std::string & s)
+            {
+                tier t;
+                if (s == "dram") {
+                    t.type = kind::dram;
+                } else if (s.compare(0,5,"numa:") == 0) {
+                    t.type = kind::numa;
+                    t.node = std::atoi(s.c_str()+5);
+                    if (t.node < 0) {
+                        throw "ERROR: invalid NUMA node in memory tier";
+                    }
+                } else if (s.compare(0,5,"file:") == 0) {
+                    t.type = kind::file;
+                    t.path = s.substr(5);
+                } else {
+                    throw "ERROR: memory tier must be dram, numa:<node> or file:<directory>";
+                }
+                return t;
+            }
+
+            std::string name() const
+            {
+                switch (type) {
+                    case kind::numa: return "numa:" + std::to_string(node);
+                    case kind::file: return "file:" + path;
+                    default:         return "dram";
+                }
+            }
+    };
+
+    inline size_t page_size(void)
+    {
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    template <typename T>
+    class vector {
+
+        private:
+            T * data_;
+            size_t size_;
+            size_t bytes_;
+            std::vector<int> fds_;
+
+        public:
+
+            vector(size_t n) : data_(nullptr), size_(n), bytes_(0), fds_()
+            {
+                const size_t ps = page_size();
+                bytes_ = ((n*sizeof(T) + ps - 1) / ps) * ps;
+                void * p = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (p == MAP_FAILED) {
+                    std::cout << "ERROR: mmap of " << bytes_ << " bytes failed: " << std::strerror(errno) << std::endl;
+                    std::abort();
+                }
+                data_ = static_cast<T*>(p);
+            }
+
+            ~vector()
+            {
+                munmap(data_, bytes_);
+                for (auto fd : fds_) close(fd);
+            }
+
+            vector(const vector &) = delete;
+            vector & operator=(const vector &) = delete;
+
+            // Place elements [first,first+count) on tier t.  The range is widened
+            // to whole pages, so adjacent ranges should be split on page boundaries
+            // (see split_point).
+            void place(size_t first, size_t count, const tier & t)
+            {
+                if (count == 0) return;
+                const size_t ps = page_size();
+                size_t lo = (first*sizeof(T) / ps) * ps;
+                size_t hi = (((first+count)*sizeof(T) + ps - 1) / ps) * ps;
+                if (hi > bytes_) hi = bytes_;
+                char * addr = reinterpret_cast<char*>(data_) + lo;
+                const size_t len = hi - lo;
+
+                switch (t.type) {
+                    case kind::dram:
+                        break;
+                    case kind::numa:
+                        {
+#if defined(__linux__) && defined(SYS_mbind)
+                            const int maxnode = 8*sizeof(unsigned long)*16;
+                            unsigned long mask[16] = {0};
+                            if (t.node >= maxnode) {
+                                std::cout << "ERROR: NUMA node " << t.node << " out of range" << std::endl;
+                                std::abort();
+                            }
+                            mask[t.node / (8*sizeof(unsigned long))] |= 1UL << (t.node % (8*sizeof(unsigned long)));
+                            long rc = syscall(SYS_mbind, addr, len, MPOL_BIND, mask, maxnode, 0);
+                            if (rc != 0) {
+                                std::cout << "ERROR: mbind to NUMA node " << t.node << " failed: "
+                                          << std::strerror(errno) << std::endl;
+                                std::abort();
+                            }
+#else
+                            std::cout << "ERROR: NUMA placement requires Linux" << std::endl;
+                            std::abort();
+#endif
+                        }
+                        break;
+                    case kind::file:
+                        {
+                            std::string name = t.path + "/prk-tier-XXXXXX";
+                            std::vector<char> tmpl(name.begin(), name.end());
+                            tmpl.push_back('\0');
+                            int fd = mkstemp(tmpl.data());
+                            if (fd < 0) {
+                                std::cout << "ERROR: cannot create backing file in " << t.path << ": "
+                                          << std::strerror(errno) << std::endl;
+                                std::abort();
+                            }
+                            // the mapping keeps the file alive
+                            unlink(tmpl.data());
+                            if (ftruncate(fd, len) != 0) {
+                                std::cout << "ERROR: cannot size backing file: " << std::strerror(errno) << std::endl;
+                                std::abort();
+                            }
+                            void * p = mmap(addr, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+                            if (p == MAP_FAILED) {
+                                std::cout << "ERROR: mmap of backing file failed: " << std::strerror(errno) << std::endl;
+                                std::abort();
+                            }
+                            fds_.push_back(fd);
+                        }
+                        break;
+                }
+            }
+
+            // Index of the first cold element when a fraction of the array is cold,
+            // rounded to a page boundary.
+            size_t split_point(double cold_fraction) const
+            {
+                const size_t per_page = page_size() / sizeof(T);
+                size_t hot = static_cast<size_t>((1.0-cold_fraction) * size_);
+                hot = ((hot + per_page - 1) / per_page) * per_page;
+                return (hot < size_) ? hot : size_;
+            }
+
+            // Leading elements on the hot tier, trailing elements on the cold tier.
+            void split(double cold_fraction, const tier & hot, const tier & cold)
+            {
+                const size_t s = split_point(cold_fraction);
+                place(0, s, hot);
+                place(s, size_-s, cold);
+            }
+
+            T * data() { return data_; }
+
+            size_t size() { return size_; }
+
+            T const & operator[] (size_t n) const { return data_[n]; }
+
+            T & operator[] (size_t n) { return data_[n]; }
+
+            T * begin() { return data_; }
+
+            T * end() { return data_ + size_; }
+    };
+
+} // namespace tiering
+} // namespace prk
+
+#endif /* PRK_TIERING_H */
@@ -211,20 +211,83 @@ namespace prk {
 
 #endif // __INTEL_COMPILER
 
-    template<class I, class T>
-    const T reduce(I first, I last, T init) {
-#if (defined(__cplusplus) && (__cplusplus >= 201703L)) && !defined(__GNUC__)
-        return std::reduce(first, last, init);
-#elif (defined(__cplusplus) && (__cplusplus >= 201103L))
-        return std::accumulate(first, last, init);
-#else
-        // unreachable, but preserved as reference implementation
-        T r(0);
-        for (I i=first; i!=last; ++i) {
-            r += *i;
+    namespace detail {
+
+        // terms per block of a reduction; the blocking does not depend on
+        // the number of threads, so neither does the result
+        const size_t reduce_block = 1024;
+
+        // pairwise (cascade) sum of f(i) for i in [lo,hi)
+        template <typename T, typename F>
+        T pairwise_sum(size_t lo, size_t hi, const F & f)
+        {
+            if (hi-lo <= 32) {
+                T s(0);
+                for (size_t i=lo; i<hi; ++i) {
+                    s += f(i);
+                }
+                return s;
+            }
+            const size_t mid = lo + (hi-lo)/2;
+            return pairwise_sum<T>(lo, mid, f) + pairwise_sum<T>(mid, hi, f);
         }
-        return r;
+
+        // sum of f(i) for i in [0,n): the blocks are summed in parallel,
+        // then the block sums are summed pairwise
+        template <typename T, typename F>
+        T reduce_index(size_t n, T init, const F & f)
+        {
+            const size_t nblocks = (n + reduce_block - 1) / reduce_block;
+            if (nblocks <= 1) {
+                return init + pairwise_sum<T>(0, n, f);
+            }
+
+            std::vector<T> partial(nblocks);
+            auto sum_blocks = [&](size_t b0, size_t b1) {
+                for (size_t b=b0; b<b1; ++b) {
+                    partial[b] = pairwise_sum<T>(b*reduce_block, std::min(n,(b+1)*reduce_block), f);
+                }
+            };
+#if defined(_OPENMP)
+            #pragma omp parallel for schedule(static) if (nblocks >= 64)
+            for (size_t b=0; b<nblocks; ++b) {
+                sum_blocks(b,b+1);
+            }
+#else
+            const size_t nt = std::min<size_t>(std::max(1U,std::thread::hardware_concurrency()), nblocks/1024);
+            if (nt > 1) {
+                std::vector<std::thread> pool;
+                for (size_t t=0; t<nt; ++t) {
+                    pool.emplace_back(sum_blocks, t*nblocks/nt, (t+1)*nblocks/nt);
+                }
+                for (auto & t : pool) t.join();
+            } else {
+                sum_blocks(0,nblocks);
+            }
 #endif
+            return init + pairwise_sum<T>(0, nblocks, [&](size_t b) { return partial[b]; });
+        }
+
+    } // namespace detail
+
+    // Validation reductions: parallel, pairwise (error grows with log n
+    // rather than n) and bitwise reproducible for any number of threads.
+    // The iterators must be random-access.
+    template<class I, class T>
+    const T reduce(I first, I last, T init) {
+        return detail::reduce_index(last-first, init, [&](size_t i) -> T { return first[i]; });
+    }
+
+    template<class I, class T, class F>
+    const T transform_reduce(I first, I last, T init, F op) {
+        return detail::reduce_index(last-first, init, [&](size_t i) -> T { return op(first[i]); });
+    }
+
+    // Sum of op(i) for i in [0,n), for reductions that need the index,
+    // e.g. over the interior of a grid or against a reference value.
+    template<class T, class F>
+    const T transform_reduce_index(size_t n, T init, F op) {
+        return detail::reduce_index(n, init, [&](size_t i) -> T { return op(i); });
     }
 
     template <typename T>
@@ -0,0 +1,472 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+
+//////////////////////////////////////////////////////////////////////
+///
+/// NAME:    sort
+///
+/// PURPOSE: This program tests the efficiency with which a set of 64-bit
+///          keys is sorted and histogrammed.  The keys are the stream of
+///          the Random kernel's LFSR, i.e. the indices it scatters into
+///          the table.
+///
+/// USAGE:   The program takes as input the number of times the keys are
+///          sorted, the 2log of the number of keys and optionally the
+///          number of bits per radix sort digit and of histogram bins.
+///
+///          <progname> <# iterations> <2log # keys> [<radix bits> <2log # bins>]
+///
+///          The output consists of diagnostics to make sure the
+///          algorithm worked, and of timing statistics.
+///
+/// NOTES:   The LSD radix sort makes one pass per digit.  Every thread
+///          counts the digits of its block of keys, a prefix scan over
+///          (digit, thread) gives each thread its output offsets, and
+///          the keys are scattered, which keeps the sort stable.
+///
+///          The scatter is timed in two forms: directly, one key store per
+///          key, and through write-combining software buffers, where
+///          every thread stages keys in one cache line per digit and
+///          writes a buffer out when it is full.  The first flush of each
+///          digit is shortened so that later flushes are aligned to whole
+///          cache lines of the output.  With many digits the direct
+///          scatter touches as many output lines as there are digits at
+///          once, which the buffers reduce to one resident line each.
+///
+///          The histogram counts the leading bits of every key into
+///          counters that are private to each thread, which are summed
+///          afterwards, so no atomics are needed even for 2^16 bins or
+///          more.
+///
+///          The sorted keys must be nondecreasing and have the same
+///          count, sum, xor and hashed sum as the generated keys, and
+///          the histogram must match the runs of the sorted keys.
+///
+/// HISTORY: Key generator from the Random kernel.
+///
+//////////////////////////////////////////////////////////////////////
+
+#include "prk_util.h"
+#include "prk_energy.h"
+#include "prk_openmp.h"
+
+#include <cstring>
+
+// see Random: PERIOD = (2^63-1)/7 = 7*73*127*337*92737*649657
+#define POLY               0x0000000000000007ULL
+#define PERIOD             1317624576693539401LL
+
+static inline uint64_t next_key(uint64_t ran)
+{
+    return (ran << 1) ^ (static_cast<int64_t>(ran) < 0 ? POLY : 0);
+}
+
+// Starts the random number generator at the nth step (PRK_starts).
+static uint64_t starts(int64_t n)
+{
+    uint64_t m2[64];
+
+    while (n < 0) n += PERIOD;
+    while (n > PERIOD) n -= PERIOD;
+    if (n == 0) return 0x1;
+
+    uint64_t temp = 0x1;
+    for (int i=0; i<64; i++) {
+        m2[i] = temp;
+        temp = next_key(temp);
+        temp = next_key(temp);
+    }
+
+    int i;
+    for (i=62; i>=0; i--) {
+        if ((n >> i) & 1) break;
+    }
+
+    uint64_t ran = 0x2;
+    while (i > 0) {
+        temp = 0;
+        for (int j=0; j<64; j++) {
+            if ((ran >> j) & 1) temp ^= m2[j];
+        }
+        ran = temp;
+        i -= 1;
+        if ((n >> i) & 1) ran = next_key(ran);
+    }
+    return ran;
+}
+
+typedef struct {
+    uint64_t count, sum, xor_, hash;
+} checksum_t;
+
+static inline uint64_t mix(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static checksum_t checksum(const uint64_t * keys, size_t n)
+{
+    uint64_t sum(0), xor_(0), hash(0);
+    OMP_PARALLEL()
+    {
+      OMP_FOR(reduction(+:sum) reduction(^:xor_) reduction(+:hash))
+      for (size_t i=0; i<n; i++) {
+          sum  += keys[i];
+          xor_ ^= keys[i];
+          hash += mix(keys[i]);
+      }
+    }
+    return { n, sum, xor_, hash };
+}
+
+static bool same(const checksum_t & a, const checksum_t & b)
+{
+    return a.count == b.count && a.sum == b.sum && a.xor_ == b.xor_ && a.hash == b.hash;
+}
+
+static size_t out_of_order(const uint64_t * keys, size_t n)
+{
+    size_t unsorted(0);
+    OMP_PARALLEL_FOR_REDUCE(+:unsorted)
+    for (size_t i=1; i<n; i++) {
+        if (keys[i-1] > keys[i]) unsorted++;
+    }
+    return unsorted;
+}
+
+// keys per write-combining buffer: one cache line
+static const int wc_keys = 8;
+
+typedef struct alignas(64) {
+    uint64_t key[wc_keys];
+} line_t;
+
+// Sorts keys[0:n] using tmp[0:n] as scratch; hist holds nthreads*2^bits counters.
+template <bool combine>
+static void radix_sort(uint64_t * keys, uint64_t * tmp, size_t n, int bits, std::vector<size_t> & hist)
+{
+    const size_t buckets = 1UL << bits;
+    const uint64_t mask = buckets-1;
+    const int passes = (64+bits-1)/bits;
+
+    OMP_PARALLEL()
+    {
+      const int me = omp_get_thread_num();
+      const int nt = omp_get_num_threads();
+      const size_t lo = n*me/nt;
+      const size_t hi = n*(me+1)/nt;
+      size_t * RESTRICT h = &(hist[me*buckets]);
+
+      std::vector<line_t> buffer(combine ? buckets : 0);
+      std::vector<int> fill(combine ? buckets : 0);
+      std::vector<int> limit(combine ? buckets : 0);
+
+      uint64_t * src = keys;
+      uint64_t * dst = tmp;
+
+      for (int pass=0; pass<passes; pass++) {
+
+        const int shift = pass*bits;
+
+        std::fill(h, h+buckets, 0);
+        for (size_t i=lo; i<hi; i++) {
+            h[(src[i] >> shift) & mask]++;
+        }
+        OMP_BARRIER
+
+        OMP_MASTER
+        {
+            size_t sum(0);
+            for (size_t d=0; d<buckets; d++) {
+                for (int t=0; t<nt; t++) {
+                    const size_t c = hist[t*buckets+d];
+                    hist[t*buckets+d] = sum;
+                    sum += c;
+                }
+            }
+        }
+        OMP_BARRIER
+
+        if (!combine) {
+            for (size_t i=lo; i<hi; i++) {
+                const uint64_t k = src[i];
+                dst[h[(k >> shift) & mask]++] = k;
+            }
+        } else {
+            // shorten the first flush of every digit to reach a line boundary
+            for (size_t d=0; d<buckets; d++) {
+                const size_t misalign = (reinterpret_cast<uintptr_t>(dst + h[d]) / sizeof(uint64_t)) % wc_keys;
+                fill[d] = 0;
+                limit[d] = wc_keys - misalign;
+            }
+            for (size_t i=lo; i<hi; i++) {
+                const uint64_t k = src[i];
+                const size_t d = (k >> shift) & mask;
+                buffer[d].key[fill[d]++] = k;
+                if (fill[d] == limit[d]) {
+                    if (limit[d] == wc_keys) {
+                        std::memcpy(dst + h[d], buffer[d].key, sizeof(line_t));
+                    } else {
+                        std::copy(buffer[d].key, buffer[d].key + limit[d], dst + h[d]);
+                    }
+                    h[d] += limit[d];
+                    fill[d] = 0;
+                    limit[d] = wc_keys;
+                }
+            }
+            for (size_t d=0; d<buckets; d++) {
+                std::copy(buffer[d].key, buffer[d].key + fill[d], dst + h[d]);
+            }
+        }
+        OMP_BARRIER
+
+        std::swap(src, dst);
+      }
+
+      // an odd number of passes leaves the keys in tmp
+      if (passes % 2) {
+          std::copy(src+lo, src+hi, keys+lo);
+      }
+    }
+}
+
+// Counts the leading bits of every key into privatized counters.
+static void histogram(const uint64_t * keys, size_t n, int bits,
+                      std::vector<size_t> & priv, std::vector<size_t> & counts)
+{
+    const size_t bins = 1UL << bits;
+
+    OMP_PARALLEL()
+    {
+      const int me = omp_get_thread_num();
+      const int nt = omp_get_num_threads();
+      size_t * RESTRICT c = &(priv[me*bins]);
+
+      std::fill(c, c+bins, 0);
+      OMP_FOR(nowait)
+      for (size_t i=0; i<n; i++) {
+          c[keys[i] >> (64-bits)]++;
+      }
+      OMP_BARRIER
+
+      OMP_FOR()
+      for (size_t b=0; b<bins; b++) {
+          size_t sum(0);
+          for (int t=0; t<nt; t++) sum += priv[t*bins+b];
+          counts[b] = sum;
+      }
+    }
+}
+
+int main(int argc, char * argv[])
+{
+  std::cout << "Parallel Research Kernels version " << PRKVERSION << std::endl;
+  std::cout << "C++11/OpenMP radix sort and histogram" << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  /// Read and test input parameters
+  //////////////////////////////////////////////////////////////////////
+
+  int iterations;
+  int log2n, bits, hbits;
+  try {
+      if (argc < 3) {
+        throw "Usage: <# iterations> <2log # keys> [<radix bits> <2log # bins>]";
+      }
+
+      iterations = std::atoi(argv[1]);
+      if (iterations < 1) {
+        throw "ERROR: iterations must be >= 1";
+      }
+
+      log2n = std::atoi(argv[2]);
+      if (log2n < 1 || log2n > 40) {
+        throw "ERROR: 2log # keys must be in [1,40]";
+      }
+
+      bits = (argc > 3) ? std::atoi(argv[3]) : 8;
+      if (bits < 1 || bits > 20) {
+        throw "ERROR: radix bits must be in [1,20]";
+      }
+
+      hbits = (argc > 4) ? std::atoi(argv[4]) : 16;
+      if (hbits < 1 || hbits > 28) {
+        throw "ERROR: 2log # bins must be in [1,28]";
+      }
+  }
+  catch (const char * e) {
+    std::cout << e << std::endl;
+    return 1;
+  }
+
+  const size_t n = 1UL << log2n;
+  const int nthreads = omp_get_max_threads();
+
+  std::cout << "Number of threads    = " << nthreads << std::endl;
+  std::cout << "Number of iterations = " << iterations << std::endl;
+  std::cout << "Number of keys       = " << n << std::endl;
+  std::cout << "Radix bits           = " << bits << " (" << (64+bits-1)/bits << " passes)" << std::endl;
+  std::cout << "Histogram bins       = " << (1UL << hbits) << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Allocate space and perform the computation
+  //////////////////////////////////////////////////////////////////////
+
+  prk::vector<uint64_t> input(n);
+  prk::vector<uint64_t> keys(n);
+  prk::vector<uint64_t> tmp(n);
+
+  std::vector<size_t> hist(nthreads*(1UL << bits));
+  std::vector<size_t> priv(nthreads*(1UL << hbits));
+  std::vector<size_t> counts(1UL << hbits);
+
+  OMP_PARALLEL()
+  {
+    const int me = omp_get_thread_num();
+    const int nt = omp_get_num_threads();
+    const size_t lo = n*me/nt;
+    const size_t hi = n*(me+1)/nt;
+    uint64_t ran = starts(lo);
+    for (size_t i=lo; i<hi; i++) {
+        ran = next_key(ran);
+        input[i] = ran;
+        keys[i] = 0;
+        tmp[i] = 0;
+    }
+  }
+
+  const checksum_t reference = checksum(input.data(), n);
+
+  double direct_time{0}, combine_time{0}, histogram_time{0};
+  prk::energy::meter direct_energy, combine_energy, histogram_energy;
+  direct_energy.start();
+  combine_energy.start();
+  histogram_energy.start();
+
+  // the direct scatter result is overwritten by the next sort, so it is checked here
+  size_t direct_unsorted(0);
+  checksum_t direct_sorted{};
+
+  for (int iter = 0; iter<=iterations; iter++) {
+
+    std::copy(input.data(), input.data()+n, keys.data());
+    if (iter>0) direct_energy.skip();
+    double t0 = prk::wtime();
+    radix_sort<false>(keys.data(), tmp.data(), n, bits, hist);
+    if (iter>0) {
+        direct_time += prk::wtime() - t0;
+        direct_energy.sample();
+    }
+    if (iter==iterations) {
+        direct_unsorted = out_of_order(keys.data(), n);
+        direct_sorted   = checksum(keys.data(), n);
+    }
+
+    std::copy(input.data(), input.data()+n, keys.data());
+    if (iter>0) combine_energy.skip();
+    t0 = prk::wtime();
+    radix_sort<true>(keys.data(), tmp.data(), n, bits, hist);
+    if (iter>0) {
+        combine_time += prk::wtime() - t0;
+        combine_energy.sample();
+    }
+
+    if (iter>0) histogram_energy.skip();
+    t0 = prk::wtime();
+    histogram(input.data(), n, hbits, priv, counts);
+    if (iter>0) {
+        histogram_time += prk::wtime() - t0;
+        histogram_energy.sample();
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // Analyze and output results.
+  //////////////////////////////////////////////////////////////////////
+
+  // the keys hold the result of the last write-combining sort
+  const size_t unsorted = out_of_order(keys.data(), n);
+  const checksum_t sorted = checksum(keys.data(), n);
+
+  // the sorted keys with the same leading bits form one run per bin
+  size_t wrong_bins(0), total(0);
+  {
+    size_t i(0);
+    for (size_t b=0; b<counts.size(); b++) {
+        size_t run(0);
+        while (i < n && (keys[i] >> (64-hbits)) == b) { i++; run++; }
+        if (run != counts[b]) wrong_bins++;
+        total += counts[b];
+    }
+  }
+
+  if (direct_unsorted > 0) {
+    std::cout << "ERROR: " << direct_unsorted << " keys are out of order after the direct scatter" << std::endl;
+    return 1;
+  } else if (!same(direct_sorted, reference)) {
+    std::cout << "ERROR: checksum of the direct scatter does not match the input" << std::endl;
+    return 1;
+  } else if (unsorted > 0) {
+    std::cout << "ERROR: " << unsorted << " keys are out of order after the write-combining scatter" << std::endl;
+    return 1;
+  } else if (!same(sorted, reference)) {
+    std::cout << "ERROR: checksum of the write-combining scatter does not match the input" << std::endl;
+    return 1;
+  } else if (wrong_bins > 0 || total != n) {
+    std::cout << "ERROR: " << wrong_bins << " histogram bins are wrong, total = "
+              << total << " keys" << std::endl;
+    return 1;
+  }
+
+  std::cout << "Solution validates" << std::endl;
+#ifdef VERBOSE
+  std::cout << "Key sum = " << reference.sum << " xor = " << reference.xor_ << std::endl;
+#endif
+
+  const double direct_avg    = direct_time/iterations;
+  const double combine_avg   = combine_time/iterations;
+  const double histogram_avg = histogram_time/iterations;
+  std::cout << "Direct scatter (Mkeys/s): " << 1.e-6*n/direct_avg
+            << " Avg time (s): " << direct_avg << std::endl;
+  direct_energy.report(iterations, direct_time, 1.e-6*n, "Mkey");
+  std::cout << "Histogram (Mkeys/s): " << 1.e-6*n/histogram_avg
+            << " Avg time (s): " << histogram_avg << std::endl;
+  histogram_energy.report(iterations, histogram_time, 1.e-6*n, "Mkey");
+  std::cout << "Rate (Mkeys/s): " << 1.e-6*n/combine_avg
+            << " Avg time (s): " << combine_avg << std::endl;
+  combine_energy.report(iterations, combine_time, 1.e-6*n, "Mkey");
+
+  return 0;
+}
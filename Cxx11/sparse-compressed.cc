@@ -0,0 +1,377 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+//////////////////////////////////////////////////////////////////////
+///
+/// NAME:    sparse
+///
+/// PURPOSE: This program tests the efficiency with which a sparse matrix
+///          vector multiplication is carried out
+///
+/// USAGE:   The program takes as input the 2log of the linear size of the 2D grid
+///          (equalling the 2log of the square root of the order of the sparse
+///          matrix), the radius of the difference stencil, and the number
+///          of times the matrix-vector multiplication is carried out.
+///
+///          <progname> <# iterations> <2log root-of-matrix-order> <radius>
+///
+///          The output consists of diagnostics to make sure the
+///          algorithm worked, and of timing statistics.
+///
+/// NOTES:   The product is computed twice: once with the plain CSR layout
+///          (size_t column indices) and once with compressed indices.  A
+///          compressed row stores the smallest column of the row (32 bits)
+///          and the offsets of all its columns from it in 8, 16 or 32 bits,
+///          the narrowest that fits.  Consecutive rows of the same width form
+///          a segment, so the only per-row metadata is the base column.
+///          Offsets are widened to full indices in registers inside the
+///          vectorized row loop; with SCRAMBLE the offsets are large and the
+///          rows fall back to 32 bits.  Both kernels are compiled for several
+///          instruction sets and selected at runtime (see prk_dispatch.h).
+///
+/// HISTORY: Written by Rob Van der Wijngaart, August 2009.
+///          Updated by RvdW to fix verification bug, February 2013
+///          Updated by RvdW to sort matrix elements to reflect traditional CSR storage,
+///          August 2013
+///          C++11-ification by Jeff Hammond, May 2017.
+///
+//////////////////////////////////////////////////////////////////////
+
+#include "prk_util.h"
+#include "prk_energy.h"
+#include "prk_dispatch.h"
+
+static inline size_t offset(size_t i, size_t j, size_t lsize)
+{
+    return (i+(j<<lsize));
+}
+
+/* Code below reverses bits in unsigned integer stored in a 64-bit word.
+   Bit reversal is with respect to the largest integer that is going to be
+   processed for the particular run of the code, to make sure the reversal
+   constitutes a true permutation. Hence, the final result needs to be shifted
+   to the right.
+   Example: if largest integer being processed is 0x000000ff = 255 =
+   0000...0011111111 (binary), then the unshifted reversal of 0x00000006 = 6 =
+   0000...0000000110 (binary) would be 011000000...0000 = 3*2^61, which is
+   outside the range of the original sequence 0-255. Setting shift_in_bits to
+   2log(256) = 8, the final result is shifted the the right by 64-8=56 bits,
+   so we get 000...0001100000 (binary) = 96, which is within the proper range */
+
+static inline uint64_t reverse(uint64_t x, int shift_in_bits)
+{
+  x = ((x >> 1)  & 0x5555555555555555) | ((x << 1)  & 0xaaaaaaaaaaaaaaaa);
+  x = ((x >> 2)  & 0x3333333333333333) | ((x << 2)  & 0xcccccccccccccccc);
+  x = ((x >> 4)  & 0x0f0f0f0f0f0f0f0f) | ((x << 4)  & 0xf0f0f0f0f0f0f0f0);
+  x = ((x >> 8)  & 0x00ff00ff00ff00ff) | ((x << 8)  & 0xff00ff00ff00ff00);
+  x = ((x >> 16) & 0x0000ffff0000ffff) | ((x << 16) & 0xffff0000ffff0000);
+  x = ((x >> 32) & 0x00000000ffffffff) | ((x << 32) & 0xffffffff00000000);
+  return ( x >> (8*sizeof(uint64_t)-shift_in_bits) );
+}
+
+#if SCRAMBLE
+  #define REVERSE(a,b)  reverse((a),(b))
+#else
+  #define REVERSE(a,b) (a)
+#endif
+
+// rows [first,last) whose offsets are all stored with the same width,
+// starting at element 'start' of the index stream of that width
+struct segment {
+    size_t first;
+    size_t last;
+    size_t start;
+    int    width;
+};
+
+static PRK_ALWAYS_INLINE void spmv_plain_body(const size_t nrows, const size_t stencil_size,
+                                              const double * RESTRICT matrix, const size_t * RESTRICT colIndex,
+                                              const double * RESTRICT vector, double * RESTRICT result)
+{
+  for (size_t row=0; row<nrows; row++) {
+      double temp(0);
+      PRAGMA_SIMD
+      for (size_t col=stencil_size*row; col<stencil_size*(row+1); col++) {
+          temp += matrix[col]*vector[colIndex[col]];
+      }
+      result[row] += temp;
+  }
+}
+
+PRK_MULTIVERSION(void, spmv_plain,
+                 (const size_t nrows, const size_t stencil_size, const double * RESTRICT matrix,
+                  const size_t * RESTRICT colIndex, const double * RESTRICT vector, double * RESTRICT result),
+                 (nrows, stencil_size, matrix, colIndex, vector, result))
+
+template <typename T>
+static PRK_ALWAYS_INLINE void spmv_rows(const segment & s, const size_t stencil_size,
+                                        const double * RESTRICT matrix, const uint32_t * RESTRICT base,
+                                        const T * RESTRICT delta,
+                                        const double * RESTRICT vector, double * RESTRICT result)
+{
+  const T * RESTRICT d = delta + s.start;
+  for (size_t row=s.first; row<s.last; row++, d+=stencil_size) {
+      const double * RESTRICT m = matrix + stencil_size*row;
+      const double * RESTRICT v = vector + base[row];
+      double temp(0);
+      PRAGMA_SIMD
+      for (size_t k=0; k<stencil_size; k++) {
+          temp += m[k]*v[d[k]];
+      }
+      result[row] += temp;
+  }
+}
+
+static PRK_ALWAYS_INLINE void spmv_compressed_body(const size_t nsegments, const segment * RESTRICT segments,
+                                                   const size_t stencil_size, const double * RESTRICT matrix,
+                                                   const uint32_t * RESTRICT base, const uint8_t * RESTRICT delta8,
+                                                   const uint16_t * RESTRICT delta16, const uint32_t * RESTRICT delta32,
+                                                   const double * RESTRICT vector, double * RESTRICT result)
+{
+  for (size_t s=0; s<nsegments; s++) {
+      switch (segments[s].width) {
+          case 1: spmv_rows(segments[s], stencil_size, matrix, base, delta8,  vector, result); break;
+          case 2: spmv_rows(segments[s], stencil_size, matrix, base, delta16, vector, result); break;
+          case 4: spmv_rows(segments[s], stencil_size, matrix, base, delta32, vector, result); break;
+      }
+  }
+}
+
+PRK_MULTIVERSION(void, spmv_compressed,
+                 (const size_t nsegments, const segment * RESTRICT segments, const size_t stencil_size,
+                  const double * RESTRICT matrix, const uint32_t * RESTRICT base, const uint8_t * RESTRICT delta8,
+                  const uint16_t * RESTRICT delta16, const uint32_t * RESTRICT delta32,
+                  const double * RESTRICT vector, double * RESTRICT result),
+                 (nsegments, segments, stencil_size, matrix, base, delta8, delta16, delta32, vector, result))
+
+int main(int argc, char* argv[])
+{
+  std::cout << "Parallel Research Kernels version " << PRKVERSION << std::endl;
+  std::cout << "C++11 Sparse matrix-vector multiplication (compressed indices)" << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Process and test input parameters
+  //////////////////////////////////////////////////////////////////////
+
+  int iterations, lsize;
+  PRK_UNUSED int lsize2;
+  int radius;
+  size_t stencil_size;
+  size_t size, size2, nent;
+  double sparsity;
+  try {
+      if (argc < 4) {
+        throw "Usage: <# iterations> <2log grid size> <stencil radius>";
+      }
+
+      // number of times to run the algorithm
+      iterations  = std::atoi(argv[1]);
+      if (iterations < 1) {
+        throw "ERROR: iterations must be >= 1";
+      }
+
+      // linear grid dimension
+      lsize  = std::atoi(argv[2]);
+      if (lsize < 1) {
+        throw "ERROR: grid dimension must be positive";
+      }
+      if (lsize > 15) {
+        throw "ERROR: 2log grid size must be <= 15 for 32-bit base columns";
+      }
+      lsize2 = 2*lsize;
+      size = 1L<<lsize;
+      size2 = size*size;
+
+      // stencil radius
+      radius = std::atoi(argv[3]);
+
+      if (radius < 1 || static_cast<size_t>(2*radius+1) > size) {
+        throw "ERROR: Stencil radius must be positive and smaller than the grid";
+      }
+
+      stencil_size = 4*radius+1;
+      sparsity = (4.*radius+1.)/size2;
+      nent = size2 * stencil_size;
+  }
+  catch (const char * e) {
+    std::cout << e << std::endl;
+    return 1;
+  }
+
+  std::cout << "Number of iterations = " << iterations << std::endl;
+  std::cout << "Matrix order         = " << size2 << std::endl;
+  std::cout << "Stencil diameter     = " << 2*radius+1 << std::endl;
+  std::cout << "Sparsity             = " << sparsity << std::endl;
+#if SCRAMBLE
+  std::cout << "Using scrambled indexing"  << std::endl;
+#else
+  std::cout << "Using canonical indexing"  << std::endl;
+#endif
+
+  auto const isa = prk::dispatch::select();
+  auto spmv_plain = PRK_DISPATCH_TABLE(spmv_plain)(isa);
+  auto spmv_compressed = PRK_DISPATCH_TABLE(spmv_compressed)(isa);
+  std::cout << "Instruction set      = " << prk::dispatch::name(isa) << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Allocate space and build both layouts
+  //////////////////////////////////////////////////////////////////////
+
+  prk::vector<double> matrix(nent,0.0);
+  prk::vector<size_t> colIndex(nent,0);
+  prk::vector<double> vector(size2,0.0);
+  prk::vector<double> result(size2,0.0);
+
+  for (size_t row=0; row<size2; row++) {
+    size_t i = row % size;
+    size_t j = row / size;
+    size_t elm = row*stencil_size;
+    colIndex[elm] = REVERSE(offset(i,j,lsize),lsize2);
+    for (int r=1; r<=radius; r++, elm+=4) {
+      colIndex[elm+1] = REVERSE(offset((i+r)%size,j,lsize),lsize2);
+      colIndex[elm+2] = REVERSE(offset((i-r+size)%size,j,lsize),lsize2);
+      colIndex[elm+3] = REVERSE(offset(i,(j+r)%size,lsize),lsize2);
+      colIndex[elm+4] = REVERSE(offset(i,(j-r+size)%size,lsize),lsize2);
+    }
+    std::sort(&(colIndex[row*stencil_size]), &(colIndex[(row+1)*stencil_size]));
+    for (size_t elm=row*stencil_size; elm<(row+1)*stencil_size; elm++) {
+      matrix[elm] = 1.0/(colIndex[elm]+1.);
+    }
+  }
+
+  // rows are sorted, so the first column is the base and every offset is non-negative
+  std::vector<segment> segments;
+  prk::vector<uint32_t> base(size2);
+  std::vector<uint8_t>  delta8;
+  std::vector<uint16_t> delta16;
+  std::vector<uint32_t> delta32;
+  size_t rows_of_width[5] = {0,0,0,0,0};
+  for (size_t row=0; row<size2; row++) {
+    const size_t * c = &(colIndex[row*stencil_size]);
+    base[row] = static_cast<uint32_t>(c[0]);
+    const size_t span = c[stencil_size-1] - c[0];
+    const int width = (span <= UINT8_MAX) ? 1 : (span <= UINT16_MAX) ? 2 : 4;
+    rows_of_width[width]++;
+    if (segments.empty() || segments.back().width != width) {
+      size_t start = (width==1) ? delta8.size() : (width==2) ? delta16.size() : delta32.size();
+      segments.push_back({row, row, start, width});
+    }
+    segments.back().last = row+1;
+    for (size_t k=0; k<stencil_size; k++) {
+      const size_t d = c[k] - c[0];
+      switch (width) {
+          case 1: delta8.push_back(static_cast<uint8_t>(d));   break;
+          case 2: delta16.push_back(static_cast<uint16_t>(d)); break;
+          case 4: delta32.push_back(static_cast<uint32_t>(d)); break;
+      }
+    }
+  }
+
+  const double plain_bytes = sizeof(size_t);
+  const double compressed_bytes = ( 1.0*rows_of_width[1]*stencil_size + 2.0*rows_of_width[2]*stencil_size
+                                  + 4.0*rows_of_width[4]*stencil_size
+                                  + sizeof(uint32_t)*size2 + sizeof(segment)*segments.size() ) / nent;
+
+  std::cout << "Rows with 8/16/32-bit offsets = " << rows_of_width[1] << "/"
+            << rows_of_width[2] << "/" << rows_of_width[4] << std::endl;
+  std::cout << "Number of segments   = " << segments.size() << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Perform the computation with each layout
+  //////////////////////////////////////////////////////////////////////
+
+  double reference_sum = (0.5*nent) * (iterations+1.) * (iterations+2.);
+  const double epsilon(1.e-8);
+
+  // the meter keeps the last run, which is the compressed layout
+  prk::energy::meter energy;
+
+  auto run = [&](auto spmv) {
+    std::fill(vector.begin(), vector.end(), 0.0);
+    std::fill(result.begin(), result.end(), 0.0);
+
+    double sparse_time{0};
+    for (int iter = 0; iter<=iterations; iter++) {
+
+      if (iter==1) {
+          sparse_time = prk::wtime();
+          energy.start();
+      }
+
+      for (size_t row=0; row<size2; row++) {
+          vector[row] += (row+1.);
+      }
+
+      spmv();
+
+    }
+    sparse_time = prk::wtime() - sparse_time;
+    energy.stop();
+
+    double vector_sum = prk::reduce(result.begin(), result.end(), 0.0);
+    if (prk::abs(vector_sum-reference_sum) > epsilon) {
+      std::cout << "ERROR: Vector norm = " << vector_sum
+                << " Reference vector norm = " << reference_sum << std::endl;
+      return -1.0;
+    }
+    return sparse_time/iterations;
+  };
+
+  double plain_time = run([&] {
+      spmv_plain(size2, stencil_size, matrix.data(), colIndex.data(), vector.data(), result.data());
+  });
+  double compressed_time = run([&] {
+      spmv_compressed(segments.size(), segments.data(), stencil_size, matrix.data(), base.data(),
+                      delta8.data(), delta16.data(), delta32.data(), vector.data(), result.data());
+  });
+
+  //////////////////////////////////////////////////////////////////////
+  // Analyze and output results.
+  //////////////////////////////////////////////////////////////////////
+
+  if (plain_time < 0 || compressed_time < 0) {
+    return 1;
+  } else {
+    std::cout << "Solution validates" << std::endl;
+    std::cout << "Layout      Index bytes/nnz  Rate (MFlops/s)  Avg time (s)" << std::endl;
+    std::cout << "plain       " << std::setw(15) << plain_bytes
+              << std::setw(17) << 1.0e-6 * (2.*nent)/plain_time
+              << std::setw(14) << plain_time << std::endl;
+    std::cout << "compressed  " << std::setw(15) << compressed_bytes
+              << std::setw(17) << 1.0e-6 * (2.*nent)/compressed_time
+              << std::setw(14) << compressed_time << std::endl;
+    std::cout << "Rate (MFlops/s): " << 1.0e-6 * (2.*nent)/compressed_time
+              << " Avg time (s): " << compressed_time << std::endl;
+    energy.report(iterations, compressed_time*iterations, 1.0e-6 * (2.*nent), "MFlop");
+  }
+
+  return 0;
+}
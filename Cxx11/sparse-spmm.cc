@@ -0,0 +1,510 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+//////////////////////////////////////////////////////////////////////
+///
+/// NAME:    sparse
+///
+/// PURPOSE: This program tests the efficiency with which a sparse matrix
+///          is multiplied by a block of dense vectors (SpMM) and by
+///          itself (SpGEMM).
+///
+/// USAGE:   The program takes as input the 2log of the linear size of the 2D grid
+///          (equalling the 2log of the square root of the order of the sparse
+///          matrix), the radius of the difference stencil, the number
+///          of times the products are carried out, and optionally the number
+///          of right-hand sides.
+///
+///          <progname> <# iterations> <2log root-of-matrix-order> <radius> [<# rhs>]
+///
+///          The output consists of diagnostics to make sure the
+///          algorithm worked, and of timing statistics.
+///
+/// NOTES:   The k right-hand sides are stored row-interleaved, i.e. entry v
+///          of row c is at vector[c*k+v], so every nonzero and its column
+///          index are loaded once for all k products.  The same products done
+///          as k separate SpMVs are timed for comparison.  Right-hand side v
+///          is (v+1) times the vector of the original kernel, so its result
+///          sum is (v+1) times the original reference sum.
+///
+///          SpGEMM computes C=A*A row by row (Gustavson) with an
+///          open-addressing hash table as the sparse accumulator, first to
+///          count the nonzeros of each row of C and then to compute them.
+///          It is verified by comparing C*1 with A*(A*1) and, for canonical
+///          indexing, with the nonzero count of the product of two stars.
+///
+/// HISTORY: Written by Rob Van der Wijngaart, August 2009.
+///          Updated by RvdW to fix verification bug, February 2013
+///          Updated by RvdW to sort matrix elements to reflect traditional CSR storage,
+///          August 2013
+///          C++11-ification by Jeff Hammond, May 2017.
+///
+//////////////////////////////////////////////////////////////////////
+
+#include "prk_util.h"
+#include "prk_energy.h"
+
+static inline size_t offset(size_t i, size_t j, size_t lsize)
+{
+    return (i+(j<<lsize));
+}
+
+/* Code below reverses bits in unsigned integer stored in a 64-bit word.
+   Bit reversal is with respect to the largest integer that is going to be
+   processed for the particular run of the code, to make sure the reversal
+   constitutes a true permutation. Hence, the final result needs to be shifted
+   to the right.
+   Example: if largest integer being processed is 0x000000ff = 255 =
+   0000...0011111111 (binary), then the unshifted reversal of 0x00000006 = 6 =
+   0000...0000000110 (binary) would be 011000000...0000 = 3*2^61, which is
+   outside the range of the original sequence 0-255. Setting shift_in_bits to
+   2log(256) = 8, the final result is shifted the the right by 64-8=56 bits,
+   so we get 000...0001100000 (binary) = 96, which is within the proper range */
+
+static inline uint64_t reverse(uint64_t x, int shift_in_bits)
+{
+  x = ((x >> 1)  & 0x5555555555555555) | ((x << 1)  & 0xaaaaaaaaaaaaaaaa);
+  x = ((x >> 2)  & 0x3333333333333333) | ((x << 2)  & 0xcccccccccccccccc);
+  x = ((x >> 4)  & 0x0f0f0f0f0f0f0f0f) | ((x << 4)  & 0xf0f0f0f0f0f0f0f0);
+  x = ((x >> 8)  & 0x00ff00ff00ff00ff) | ((x << 8)  & 0xff00ff00ff00ff00);
+  x = ((x >> 16) & 0x0000ffff0000ffff) | ((x << 16) & 0xffff0000ffff0000);
+  x = ((x >> 32) & 0x00000000ffffffff) | ((x << 32) & 0xffffffff00000000);
+  return ( x >> (8*sizeof(uint64_t)-shift_in_bits) );
+}
+
+#if SCRAMBLE
+  #define REVERSE(a,b)  reverse((a),(b))
+#else
+  #define REVERSE(a,b) (a)
+#endif
+
+// K is the number of right-hand sides when known at compile time; K=0 uses k.
+template <int K>
+void spmm(const size_t nrows, const size_t stencil_size, const int k,
+          const double * RESTRICT matrix, const size_t * RESTRICT colIndex,
+          const double * RESTRICT vector, double * RESTRICT result)
+{
+  const int nk = (K>0) ? K : k;
+  for (size_t row=0; row<nrows; row++) {
+      double temp[(K>0) ? K : 32] = {};
+      double * RESTRICT out = &result[row*nk];
+      if (K==0 && nk>32) {
+          // too many for the register block; accumulate in place
+          for (size_t col=stencil_size*row; col<stencil_size*(row+1); col++) {
+              const double a = matrix[col];
+              const double * RESTRICT x = &vector[colIndex[col]*nk];
+              PRAGMA_SIMD
+              for (int v=0; v<nk; v++) out[v] += a*x[v];
+          }
+          continue;
+      }
+      for (size_t col=stencil_size*row; col<stencil_size*(row+1); col++) {
+          const double a = matrix[col];
+          const double * RESTRICT x = &vector[colIndex[col]*nk];
+          PRAGMA_SIMD
+          for (int v=0; v<nk; v++) temp[v] += a*x[v];
+      }
+      PRAGMA_SIMD
+      for (int v=0; v<nk; v++) out[v] += temp[v];
+  }
+}
+
+// Sparse accumulator for one row of C: open addressing with linear probing.
+class hash_accumulator {
+
+    private:
+        static constexpr size_t empty = SIZE_MAX;
+        size_t mask_;
+        std::vector<size_t> keys_;
+        std::vector<double> values_;
+        std::vector<size_t> used_;
+
+        size_t slot(size_t key) const
+        {
+            size_t h = (key * UINT64_C(0x9E3779B97F4A7C15)) >> 17;
+            while (keys_[h & mask_] != key && keys_[h & mask_] != empty) h++;
+            return h & mask_;
+        }
+
+    public:
+
+        hash_accumulator(size_t capacity)
+        {
+            size_t n = 1;
+            while (n < 2*capacity) n <<= 1;
+            mask_ = n-1;
+            keys_.resize(n, empty);
+            values_.resize(n, 0.0);
+            used_.reserve(capacity);
+        }
+
+        void insert(size_t key)
+        {
+            size_t s = slot(key);
+            if (keys_[s] == empty) {
+                keys_[s] = key;
+                used_.push_back(s);
+            }
+        }
+
+        void add(size_t key, double value)
+        {
+            size_t s = slot(key);
+            if (keys_[s] == empty) {
+                keys_[s] = key;
+                used_.push_back(s);
+            }
+            values_[s] += value;
+        }
+
+        size_t size() const { return used_.size(); }
+
+        // write the accumulated row sorted by column and reset the table
+        void flush(size_t * cols, double * vals)
+        {
+            std::sort(used_.begin(), used_.end(), [&](size_t a, size_t b) { return keys_[a] < keys_[b]; });
+            for (size_t e=0; e<used_.size(); e++) {
+                cols[e] = keys_[used_[e]];
+                vals[e] = values_[used_[e]];
+            }
+            clear();
+        }
+
+        void clear()
+        {
+            for (auto s : used_) {
+                keys_[s] = empty;
+                values_[s] = 0.0;
+            }
+            used_.clear();
+        }
+};
+
+int main(int argc, char* argv[])
+{
+  std::cout << "Parallel Research Kernels version " << PRKVERSION << std::endl;
+  std::cout << "C++11 Sparse matrix-matrix multiplication" << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Process and test input parameters
+  //////////////////////////////////////////////////////////////////////
+
+  int iterations, lsize;
+  PRK_UNUSED int lsize2;
+  int radius, nrhs;
+  size_t stencil_size;
+  size_t size, size2, nent;
+  double sparsity;
+  try {
+      if (argc < 4) {
+        throw "Usage: <# iterations> <2log grid size> <stencil radius> [<# rhs>]";
+      }
+
+      // number of times to run the algorithm
+      iterations  = std::atoi(argv[1]);
+      if (iterations < 1) {
+        throw "ERROR: iterations must be >= 1";
+      }
+
+      // linear grid dimension
+      lsize  = std::atoi(argv[2]);
+      if (lsize < 1) {
+        throw "ERROR: grid dimension must be positive";
+      }
+      lsize2 = 2*lsize;
+      size = 1L<<lsize;
+      size2 = size*size;
+
+      // stencil radius
+      radius = std::atoi(argv[3]);
+
+      if (radius < 1 || static_cast<size_t>(2*radius+1) > size) {
+        throw "ERROR: Stencil radius must be positive and smaller than the grid";
+      }
+
+      // number of right-hand sides
+      nrhs = (argc > 4) ? std::atoi(argv[4]) : 8;
+      if (nrhs < 1) {
+        throw "ERROR: number of right-hand sides must be positive";
+      }
+
+      stencil_size = 4*radius+1;
+      sparsity = (4.*radius+1.)/size2;
+      nent = size2 * stencil_size;
+  }
+  catch (const char * e) {
+    std::cout << e << std::endl;
+    return 1;
+  }
+
+  std::cout << "Number of iterations = " << iterations << std::endl;
+  std::cout << "Matrix order         = " << size2 << std::endl;
+  std::cout << "Stencil diameter     = " << 2*radius+1 << std::endl;
+  std::cout << "Sparsity             = " << sparsity << std::endl;
+  std::cout << "Right-hand sides     = " << nrhs << std::endl;
+#if SCRAMBLE
+  std::cout << "Using scrambled indexing"  << std::endl;
+#else
+  std::cout << "Using canonical indexing"  << std::endl;
+#endif
+
+  auto kernel = spmm<0>;
+  switch (nrhs) {
+      case 1:  kernel = spmm<1>;  break;
+      case 4:  kernel = spmm<4>;  break;
+      case 8:  kernel = spmm<8>;  break;
+      case 16: kernel = spmm<16>; break;
+      case 32: kernel = spmm<32>; break;
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // Allocate space and build the matrix
+  //////////////////////////////////////////////////////////////////////
+
+  prk::vector<double> matrix(nent,0.0);
+  prk::vector<size_t> colIndex(nent,0);
+
+  for (size_t row=0; row<size2; row++) {
+    size_t i = row % size;
+    size_t j = row / size;
+    size_t elm = row*stencil_size;
+    colIndex[elm] = REVERSE(offset(i,j,lsize),lsize2);
+    for (int r=1; r<=radius; r++, elm+=4) {
+      colIndex[elm+1] = REVERSE(offset((i+r)%size,j,lsize),lsize2);
+      colIndex[elm+2] = REVERSE(offset((i-r+size)%size,j,lsize),lsize2);
+      colIndex[elm+3] = REVERSE(offset(i,(j+r)%size,lsize),lsize2);
+      colIndex[elm+4] = REVERSE(offset(i,(j-r+size)%size,lsize),lsize2);
+    }
+    std::sort(&(colIndex[row*stencil_size]), &(colIndex[(row+1)*stencil_size]));
+    for (size_t elm=row*stencil_size; elm<(row+1)*stencil_size; elm++) {
+      matrix[elm] = 1.0/(colIndex[elm]+1.);
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // Multiple right-hand sides: interleaved block vs. k separate SpMVs
+  //////////////////////////////////////////////////////////////////////
+
+  double reference_sum = (0.5*nent) * (iterations+1.) * (iterations+2.);
+  const double epsilon(1.e-8);
+  bool valid = true;
+
+  double block_time{0}, separate_time{0};
+  prk::energy::meter block_energy, separate_energy, spgemm_energy;
+  {
+    prk::vector<double> vector(size2*nrhs,0.0);
+    prk::vector<double> result(size2*nrhs,0.0);
+
+    for (int iter = 0; iter<=iterations; iter++) {
+
+      if (iter==1) {
+          block_time = prk::wtime();
+          block_energy.start();
+      }
+
+      for (size_t row=0; row<size2; row++) {
+          for (int v=0; v<nrhs; v++) {
+              vector[row*nrhs+v] += (row+1.)*(v+1.);
+          }
+      }
+
+      kernel(size2, stencil_size, nrhs, matrix.data(), colIndex.data(), vector.data(), result.data());
+
+    }
+    block_time = prk::wtime() - block_time;
+    block_energy.stop();
+
+    for (int v=0; v<nrhs; v++) {
+      double vector_sum(0);
+      for (size_t row=0; row<size2; row++) {
+          vector_sum += result[row*nrhs+v];
+      }
+      if (prk::abs(vector_sum-(v+1.)*reference_sum) > epsilon*(v+1.)) {
+        std::cout << "ERROR: Vector norm of right-hand side " << v << " = " << vector_sum
+                  << " Reference vector norm = " << (v+1.)*reference_sum << std::endl;
+        valid = false;
+      }
+    }
+  }
+  {
+    // one contiguous vector per right-hand side
+    prk::vector<double> vector(size2*nrhs,0.0);
+    prk::vector<double> result(size2*nrhs,0.0);
+
+    for (int iter = 0; iter<=iterations; iter++) {
+
+      if (iter==1) {
+          separate_time = prk::wtime();
+          separate_energy.start();
+      }
+
+      for (int v=0; v<nrhs; v++) {
+          for (size_t row=0; row<size2; row++) {
+              vector[v*size2+row] += (row+1.)*(v+1.);
+          }
+      }
+
+      for (int v=0; v<nrhs; v++) {
+          spmm<1>(size2, stencil_size, 1, matrix.data(), colIndex.data(), &vector[v*size2], &result[v*size2]);
+      }
+
+    }
+    separate_time = prk::wtime() - separate_time;
+    separate_energy.stop();
+
+    for (int v=0; v<nrhs; v++) {
+      double vector_sum(0);
+      for (size_t row=0; row<size2; row++) {
+          vector_sum += result[v*size2+row];
+      }
+      if (prk::abs(vector_sum-(v+1.)*reference_sum) > epsilon*(v+1.)) {
+        std::cout << "ERROR: Vector norm of separate right-hand side " << v << " = " << vector_sum
+                  << " Reference vector norm = " << (v+1.)*reference_sum << std::endl;
+        valid = false;
+      }
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // SpGEMM: C = A*A with a hash accumulator
+  //////////////////////////////////////////////////////////////////////
+
+  std::vector<size_t> rowPtrC(size2+1,0);
+  std::vector<size_t> colIndexC;
+  std::vector<double> matrixC;
+  double spgemm_time{0};
+  {
+    hash_accumulator acc(stencil_size*stencil_size);
+
+    for (int iter = 0; iter<=iterations; iter++) {
+
+      if (iter==1) {
+          spgemm_time = prk::wtime();
+          spgemm_energy.start();
+      }
+
+      // symbolic phase: size of each row of C
+      for (size_t row=0; row<size2; row++) {
+          for (size_t ik=stencil_size*row; ik<stencil_size*(row+1); ik++) {
+              const size_t k = colIndex[ik];
+              for (size_t kj=stencil_size*k; kj<stencil_size*(k+1); kj++) {
+                  acc.insert(colIndex[kj]);
+              }
+          }
+          rowPtrC[row+1] = rowPtrC[row] + acc.size();
+          acc.clear();
+      }
+      colIndexC.resize(rowPtrC[size2]);
+      matrixC.resize(rowPtrC[size2]);
+
+      // numeric phase
+      for (size_t row=0; row<size2; row++) {
+          for (size_t ik=stencil_size*row; ik<stencil_size*(row+1); ik++) {
+              const size_t k = colIndex[ik];
+              const double a = matrix[ik];
+              for (size_t kj=stencil_size*k; kj<stencil_size*(k+1); kj++) {
+                  acc.add(colIndex[kj], a*matrix[kj]);
+              }
+          }
+          acc.flush(&colIndexC[rowPtrC[row]], &matrixC[rowPtrC[row]]);
+      }
+
+    }
+    spgemm_time = prk::wtime() - spgemm_time;
+    spgemm_energy.stop();
+
+#if !SCRAMBLE
+    // a star of radius r times itself covers the axes out to 2r and the
+    // (2r)^2 off-axis points within r of both axes, unless the torus wraps;
+    // scrambling permutes only the columns, so A*A is not a stencil product
+    const size_t nnzC = size2 * (4*radius*radius + 8*radius + 1);
+    if (size > static_cast<size_t>(4*radius) && rowPtrC[size2] != nnzC) {
+      std::cout << "ERROR: nonzeros in A*A = " << rowPtrC[size2]
+                << " Reference = " << nnzC << std::endl;
+      valid = false;
+    }
+#endif
+
+    // C*1 must equal A*(A*1)
+    std::vector<double> y(size2,0.0), z(size2,0.0);
+    for (size_t row=0; row<size2; row++) {
+      for (size_t col=stencil_size*row; col<stencil_size*(row+1); col++) {
+        y[row] += matrix[col];
+      }
+    }
+    double error(0), norm(0);
+    for (size_t row=0; row<size2; row++) {
+      for (size_t col=stencil_size*row; col<stencil_size*(row+1); col++) {
+        z[row] += matrix[col]*y[colIndex[col]];
+      }
+      double w(0);
+      for (size_t e=rowPtrC[row]; e<rowPtrC[row+1]; e++) {
+        w += matrixC[e];
+      }
+      error += prk::abs(w-z[row]);
+      norm  += prk::abs(z[row]);
+    }
+    if (error > epsilon*norm) {
+      std::cout << "ERROR: |C*1 - A*(A*1)| = " << error
+                << " |A*(A*1)| = " << norm << std::endl;
+      valid = false;
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // Analyze and output results.
+  //////////////////////////////////////////////////////////////////////
+
+  if (!valid) {
+    return 1;
+  } else {
+    std::cout << "Solution validates" << std::endl;
+#ifdef VERBOSE
+    std::cout << "Nonzeros in A*A = " << rowPtrC[size2] << std::endl;
+#endif
+    double avgtime = block_time/iterations;
+    double flops = 2.*nent*nrhs;
+    std::cout << "SpMM      Rate (MFlops/s): " << 1.0e-6 * flops/avgtime
+              << " Avg time (s): " << avgtime << std::endl;
+    block_energy.report(iterations, block_time, 1.0e-6 * flops, "MFlop");
+    avgtime = separate_time/iterations;
+    std::cout << "k x SpMV  Rate (MFlops/s): " << 1.0e-6 * flops/avgtime
+              << " Avg time (s): " << avgtime << std::endl;
+    separate_energy.report(iterations, separate_time, 1.0e-6 * flops, "MFlop");
+    avgtime = spgemm_time/iterations;
+    flops = 2.*nent*stencil_size;
+    std::cout << "SpGEMM    Rate (MFlops/s): " << 1.0e-6 * flops/avgtime
+              << " Avg time (s): " << avgtime << std::endl;
+    spgemm_energy.report(iterations, spgemm_time, 1.0e-6 * flops, "MFlop");
+  }
+
+  return 0;
+}
@@ -61,6 +61,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 
 static inline size_t offset(size_t i, size_t j, size_t lsize)
 {
@@ -165,6 +166,7 @@ int main(int argc, char* argv[])
   std::vector<double> result(size2,0.0);
 
   double sparse_time{0};
+  prk::energy::meter energy;
 
   {
     for (size_t row=0; row<size2; row++) {
@@ -186,7 +188,10 @@ int main(int argc, char* argv[])
 
     for (int iter = 0; iter<=iterations; iter++) {
 
-      if (iter==1) sparse_time = prk::wtime();
+      if (iter==1) {
+          sparse_time = prk::wtime();
+          energy.start();
+      }
 
       for (size_t row=0; row<size2; row++) {
           vector[row] += (row+1.);
@@ -202,6 +207,7 @@ int main(int argc, char* argv[])
 
     }
     sparse_time = prk::wtime() - sparse_time;
+    energy.stop();
   }
 
   //////////////////////////////////////////////////////////////////////
@@ -210,10 +216,7 @@ int main(int argc, char* argv[])
 
   double reference_sum = (0.5*nent) * (iterations+1.) * (iterations+2.);
 
-  double vector_sum(0);
-  for (size_t row=0; row<size2; row++) {
-      vector_sum += result[row];
-  }
+  double vector_sum = prk::reduce(result.begin(), result.end(), 0.0);
 
   const double epsilon(1.e-8);
 
@@ -230,6 +233,7 @@ int main(int argc, char* argv[])
     double avgtime = sparse_time/iterations;
     std::cout << "Rate (MFlops/s): " << 1.0e-6 * (2.*nent)/avgtime
               << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, sparse_time, 1.0e-6 * (2.*nent), "MFlop");
   }
 
   return 0;
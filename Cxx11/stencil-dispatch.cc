@@ -0,0 +1,260 @@
+
+///
+/// Copyright (c) 2013, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+//////////////////////////////////////////////////////////////////////
+///
+/// NAME:    Stencil
+///
+/// PURPOSE: This program tests the efficiency with which a space-invariant,
+///          linear, symmetric filter (stencil) can be applied to a square
+///          grid or image.
+///
+/// USAGE:   The program takes as input the linear
+///          dimension of the grid, and the number of iterations on the grid
+///
+///                <progname> <iterations> <grid size>
+///
+///          The output consists of diagnostics to make sure the
+///          algorithm worked, and of timing statistics.
+///
+/// FUNCTIONS CALLED:
+///
+///          Other than standard C functions, the following functions are used in
+///          this program:
+///          wtime()
+///
+/// HISTORY: - Written by Rob Van der Wijngaart, February 2009.
+///          - RvdW: Removed unrolling pragmas for clarity;
+///            added constant to array "in" at end of each iteration to force
+///            refreshing of neighbor data in parallel versions; August 2013
+///            C++11-ification by Jeff Hammond, May 2017.
+///
+/// NOTES:   Only star stencils are supported.  The stencil is compiled for
+///          several instruction sets and the best one supported by the CPU
+///          is selected at runtime (see prk_dispatch.h).
+///
+//////////////////////////////////////////////////////////////////////
+
+#include "prk_util.h"
+#include "prk_energy.h"
+#include "prk_dispatch.h"
+
+// Same weights as the generated star stencils: +/- 1/(2*k*R) at distance k.
+template <int R>
+static PRK_ALWAYS_INLINE void star_tile(const int n, const int t,
+                                        const double * RESTRICT in, double * RESTRICT out)
+{
+    for (int it=R; it<n-R; it+=t) {
+      for (int jt=R; jt<n-R; jt+=t) {
+        const int iend = std::min(n-R,it+t);
+        const int jend = std::min(n-R,jt+t);
+        for (int i=it; i<iend; ++i) {
+          PRAGMA_SIMD
+          for (int j=jt; j<jend; ++j) {
+            double s(0);
+            for (int k=1; k<=R; ++k) {
+              const double w = 1.0/(2.0*k*R);
+              s += w * ( in[(i+k)*n+j] - in[(i-k)*n+j] + in[i*n+(j+k)] - in[i*n+(j-k)] );
+            }
+            out[i*n+j] += s;
+          }
+        }
+      }
+    }
+}
+
+static PRK_ALWAYS_INLINE void star_body(const int n, const int t, const int r,
+                                        const double * RESTRICT in, double * RESTRICT out)
+{
+    switch (r) {
+        case 1: star_tile<1>(n, t, in, out); break;
+        case 2: star_tile<2>(n, t, in, out); break;
+        case 3: star_tile<3>(n, t, in, out); break;
+        case 4: star_tile<4>(n, t, in, out); break;
+        case 5: star_tile<5>(n, t, in, out); break;
+    }
+}
+
+PRK_MULTIVERSION(void, star,
+                 (const int n, const int t, const int r, const double * RESTRICT in, double * RESTRICT out),
+                 (n, t, r, in, out))
+
+int main(int argc, char* argv[])
+{
+  std::cout << "Parallel Research Kernels version " << PRKVERSION << std::endl;
+  std::cout << "C++11 Stencil execution on 2D grid (runtime ISA dispatch)" << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Process and test input parameters
+  //////////////////////////////////////////////////////////////////////
+
+  int iterations, n, radius, tile_size;
+  bool star = true;
+  try {
+      if (argc < 3) {
+        throw "Usage: <# iterations> <array dimension> [<tile_size> <star/grid> <radius>]";
+      }
+
+      // number of times to run the algorithm
+      iterations  = std::atoi(argv[1]);
+      if (iterations < 1) {
+        throw "ERROR: iterations must be >= 1";
+      }
+
+      // linear grid dimension
+      n  = std::atoi(argv[2]);
+      if (n < 1) {
+        throw "ERROR: grid dimension must be positive";
+      } else if (n > prk::get_max_matrix_size()) {
+        throw "ERROR: grid dimension too large - overflow risk";
+      }
+
+      // default tile size for tiling of local transpose
+      tile_size = 32;
+      if (argc > 3) {
+          tile_size = std::atoi(argv[3]);
+          if (tile_size <= 0) tile_size = n;
+          if (tile_size > n) tile_size = n;
+      }
+
+      // stencil pattern
+      if (argc > 4) {
+          auto stencil = std::string(argv[4]);
+          auto grid = std::string("grid");
+          star = (stencil == grid) ? false : true;
+      }
+
+      // stencil radius
+      radius = 2;
+      if (argc > 5) {
+          radius = std::atoi(argv[5]);
+      }
+
+      if ( (radius < 1) || (2*radius+1 > n) ) {
+        throw "ERROR: Stencil radius negative or too large";
+      }
+      if (!star) {
+        throw "ERROR: only star stencils support runtime dispatch";
+      }
+      if (radius > 5) {
+        throw "ERROR: Stencil radius must be <= 5";
+      }
+  }
+  catch (const char * e) {
+    std::cout << e << std::endl;
+    return 1;
+  }
+
+  std::cout << "Number of iterations = " << iterations << std::endl;
+  std::cout << "Grid size            = " << n << std::endl;
+  std::cout << "Tile size            = " << tile_size << std::endl;
+  std::cout << "Type of stencil      = " << (star ? "star" : "grid") << std::endl;
+  std::cout << "Radius of stencil    = " << radius << std::endl;
+
+  auto const isa = prk::dispatch::select();
+  auto stencil = PRK_DISPATCH_TABLE(star)(isa);
+  std::cout << "Instruction set      = " << prk::dispatch::name(isa) << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Allocate space and perform the computation
+  //////////////////////////////////////////////////////////////////////
+
+  double stencil_time{0};
+  prk::energy::meter energy;
+
+  prk::vector<double> in(n*n);
+  prk::vector<double> out(n*n);
+
+  {
+    for (int it=0; it<n; it+=tile_size) {
+      for (int jt=0; jt<n; jt+=tile_size) {
+        for (int i=it; i<std::min(n,it+tile_size); i++) {
+          PRAGMA_SIMD
+          for (int j=jt; j<std::min(n,jt+tile_size); j++) {
+            in[i*n+j] = static_cast<double>(i+j);
+            out[i*n+j] = 0.0;
+          }
+        }
+      }
+    }
+
+    for (int iter = 0; iter<=iterations; iter++) {
+
+      if (iter==1) {
+          stencil_time = prk::wtime();
+          energy.start();
+      }
+      // Apply the stencil operator
+      stencil(n, tile_size, radius, in.data(), out.data());
+      // Add constant to solution to force refresh of neighbor data, if any
+      std::transform(in.begin(), in.end(), in.begin(), [](double c) { return c+=1.0; });
+    }
+    stencil_time = prk::wtime() - stencil_time;
+    energy.stop();
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // Analyze and output results.
+  //////////////////////////////////////////////////////////////////////
+
+  // interior of grid with respect to stencil
+  size_t active_points = static_cast<size_t>(n-2*radius)*static_cast<size_t>(n-2*radius);
+  double norm = prk::transform_reduce_index(active_points, 0.0, [&](size_t k) {
+      const size_t i = radius + k/(n-2*radius);
+      const size_t j = radius + k%(n-2*radius);
+      return prk::abs(out[i*n+j]);
+  });
+  norm /= active_points;
+
+  // verify correctness
+  const double epsilon = 1.0e-8;
+  double reference_norm = 2.*(iterations+1.);
+  if (prk::abs(norm-reference_norm) > epsilon) {
+    std::cout << "ERROR: L1 norm = " << norm
+              << " Reference L1 norm = " << reference_norm << std::endl;
+    return 1;
+  } else {
+    std::cout << "Solution validates" << std::endl;
+#ifdef VERBOSE
+    std::cout << "L1 norm = " << norm
+              << " Reference L1 norm = " << reference_norm << std::endl;
+#endif
+    const int stencil_size = star ? 4*radius+1 : (2*radius+1)*(2*radius+1);
+    size_t flops = (2L*(size_t)stencil_size+1L) * active_points;
+    auto avgtime = stencil_time/iterations;
+    std::cout << "Rate (MFlops/s): " << 1.0e-6 * static_cast<double>(flops)/avgtime
+              << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, stencil_time, 1.0e-6 * static_cast<double>(flops), "MFlop");
+  }
+
+  return 0;
+}
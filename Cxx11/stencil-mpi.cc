@@ -30,6 +30,7 @@
 /// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 /// POSSIBILITY OF SUCH DAMAGE.
 
+
 //////////////////////////////////////////////////////////////////////
 ///
 /// NAME:    Stencil
@@ -41,11 +42,34 @@
 /// USAGE:   The program takes as input the linear
 ///          dimension of the grid, and the number of iterations on the grid
 ///
-///                <progname> <iterations> <grid size>
+///                <progname> <iterations> <grid size> [<tile size> <star/grid>
+///                           <radius> [row-major|node-aware [ranks per node
+///                           [none|sync|async [aggregators]]]]]
 ///
 ///          The output consists of diagnostics to make sure the
 ///          algorithm worked, and of timing statistics.
 ///
+/// NOTES:   The grid is block-decomposed over a 2D process grid.  With
+///          node-aware placement (the default), the ranks of each node
+///          tile a compact sub-block of the process grid, which cuts the
+///          halo traffic between nodes compared to row-major placement.
+///          The halos are exchanged with one MPI_Neighbor_alltoallw over
+///          a distributed graph weighted by halo bytes, which MPI may
+///          reorder; grid stencils add the diagonal neighbors.
+///          Nodes are found with MPI_COMM_TYPE_SHARED, unless a nonzero
+///          number of ranks per node is given to emulate a multi-node job.
+///          The program reports the intra-node and inter-node halo bytes
+///          of both placements.
+///
+///          The optional snapshot mode writes both grids halfway through
+///          the run to the shared file stencil-mpi.snapshot with
+///          collective MPI-IO, either blocking (sync) or overlapped with
+///          the remaining iterations (async); aggregators sets the number
+///          of collective buffering nodes.  After the run, the program
+///          restarts from the snapshot, repeats the remaining iterations
+///          and checks that it gets the same norm.  The write rate is
+///          reported next to that of one local file per rank.
+///
 /// FUNCTIONS CALLED:
 ///
 ///          Other than standard C functions, the following functions are used in
@@ -57,26 +81,34 @@
 ///            added constant to array "in" at end of each iteration to force
 ///            refreshing of neighbor data in parallel versions; August 2013
 ///            C++11-ification by Jeff Hammond, May 2017.
+///          - Distributed over a node-aware process grid.
 ///
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
 #include "prk_mpi.h"
+#include "prk_stencil.h"
 
-// we do not use OpenMP but the OpenMP variants of stencil kernels
-// work with raw pointers, whereas the sequential versions work with
-// prk::vector...
-#include "prk_openmp.h"
-#include "stencil_openmp.hpp"
-
-void nothing(const int n, const int t, const double * RESTRICT in, double * RESTRICT out)
+// Applies the stencil to the local rows [ilo,ihi) and columns [jlo,jhi)
+// of a block with row length m, in tiles of t.
+void apply(const int ilo, const int ihi, const int jlo, const int jhi, const int m, const int t,
+           const std::vector<prk::stencil::point_t> & points, const double * RESTRICT in, double * RESTRICT out)
 {
-    std::cout << "You are trying to use a stencil that does not exist.\n";
-    std::cout << "Please generate the new stencil using the code generator\n";
-    std::cout << "and add it to the case-switch in the driver." << std::endl;
-    // n will never be zero - this is to silence compiler warnings.
-    if (n==0 || t==0) std::cout << in << out << std::endl;
-    std::abort();
+    for (int it=ilo; it<ihi; it+=t) {
+      for (int jt=jlo; jt<jhi; jt+=t) {
+        const int jend = std::min(jhi,jt+t);
+        for (int i=it; i<std::min(ihi,it+t); ++i) {
+          double * RESTRICT o = &(out[static_cast<size_t>(i)*m]);
+          for (auto & p : points) {
+            const double * RESTRICT ip = &(in[static_cast<size_t>(i+p.di)*m + p.dj]);
+            PRAGMA_SIMD
+            for (int j=jt; j<jend; ++j) {
+              o[j] += p.weight * ip[j];
+            }
+          }
+        }
+      }
+    }
 }
 
 int main(int argc, char* argv[])
@@ -99,9 +131,14 @@ int main(int argc, char* argv[])
     int iterations;
     size_t n, radius, tile_size;
     bool star = true;
+    bool node_aware = true;
+    int ranks_per_node = 0;
+    bool snapshot = false, async = false;
+    int aggregators = 0;
     try {
         if (argc < 3) {
-          throw "Usage: <# iterations> <array dimension> [<tile_size> <star/grid> <radius>]";
+          throw "Usage: <# iterations> <array dimension> [<tile_size> <star/grid> <radius> "
+                "[row-major|node-aware [ranks per node [none|sync|async [aggregators]]]]]";
         }
 
         iterations  = std::atoi(argv[1]);
@@ -141,59 +178,179 @@ int main(int argc, char* argv[])
         if ( (radius < 1) || (2*radius+1 > n) ) {
           throw "ERROR: Stencil radius negative or too large";
         }
+
+        // rank placement
+        if (argc > 6) {
+            auto placement = std::string(argv[6]);
+            if (placement == "row-major") {
+                node_aware = false;
+            } else if (placement != "node-aware") {
+                throw "ERROR: placement must be row-major or node-aware";
+            }
+        }
+
+        // emulated node size, 0 for the actual nodes
+        if (argc > 7) {
+            ranks_per_node = std::atoi(argv[7]);
+            if (ranks_per_node < 0 || (ranks_per_node > 0 && np % ranks_per_node != 0)) {
+                throw "ERROR: ranks per node must divide the number of processes";
+            }
+        }
+
+        // snapshot mode
+        if (argc > 8) {
+            auto mode = std::string(argv[8]);
+            if (mode == "sync" || mode == "async") {
+                snapshot = true;
+                async = (mode == "async");
+            } else if (mode != "none") {
+                throw "ERROR: snapshot mode must be none, sync or async";
+            }
+        }
+
+        // collective buffering nodes, 0 for the default
+        if (argc > 9) {
+            aggregators = std::atoi(argv[9]);
+            if (aggregators < 0) {
+                throw "ERROR: number of aggregators must not be negative";
+            }
+        }
     }
     catch (const char * e) {
-      std::cout << e << std::endl;
+      if (me == 0) std::cout << e << std::endl;
+      prk::MPI::abort();
+    }
+
+    prk::MPI::decomposition grid({n,n}, node_aware, ranks_per_node);
+
+    const int r = static_cast<int>(radius);
+    const auto & dims = grid.dims();
+    if (n/dims[0] < radius || n/dims[1] < radius) {
+      if (me == 0) std::cout << "ERROR: local blocks are smaller than the stencil radius" << std::endl;
       prk::MPI::abort();
     }
 
     if (me == 0) {
-      std::cout << "Number of threads    = " << np << std::endl;
+      std::cout << "Number of processes  = " << np << std::endl;
       std::cout << "Number of iterations = " << iterations << std::endl;
       std::cout << "Grid size            = " << n << std::endl;
       std::cout << "Tile size            = " << tile_size << std::endl;
       std::cout << "Type of stencil      = " << (star ? "star" : "grid") << std::endl;
       std::cout << "Radius of stencil    = " << radius << std::endl;
-    }
-
-    auto stencil = nothing;
-    if (star) {
-        switch (radius) {
-            case 1: stencil = star1; break;
-            case 2: stencil = star2; break;
-            case 3: stencil = star3; break;
-            case 4: stencil = star4; break;
-            case 5: stencil = star5; break;
-        }
-    } else {
-        switch (radius) {
-            case 1: stencil = grid1; break;
-            case 2: stencil = grid2; break;
-            case 3: stencil = grid3; break;
-            case 4: stencil = grid4; break;
-            case 5: stencil = grid5; break;
-        }
+      std::cout << "Process grid         = " << dims[0] << "x" << dims[1] << std::endl;
+      std::cout << "Nodes                = " << grid.nodes();
+      if (ranks_per_node > 0) std::cout << " (emulated)";
+      std::cout << std::endl;
+      std::cout << "Rank placement       = ";
+      if (grid.node_aware()) {
+          std::cout << "node-aware, " << grid.node_dims()[0] << "x" << grid.node_dims()[1] << " ranks per node" << std::endl;
+      } else {
+          std::cout << "row-major" << (node_aware ? " (nodes differ in size)" : "") << std::endl;
+      }
+      std::cout << "Snapshot             = " << (snapshot ? (async ? "async" : "sync") : "none");
+      if (snapshot) {
+          if (aggregators > 0) std::cout << " (" << aggregators << " aggregators)";
+          else                 std::cout << " (default aggregators)";
+      }
+      std::cout << std::endl;
     }
 
     //////////////////////////////////////////////////////////////////////
     // Allocate space and perform the computation
     //////////////////////////////////////////////////////////////////////
 
+    // star stencils need the face neighbors, grid stencils also the
+    // diagonal ones; MPI may reorder the ranks, which moves them to other blocks
+    std::vector<std::vector<int>> offsets = { {-1,0}, {1,0}, {0,-1}, {0,1} };
+    if (!star) {
+        offsets.insert(offsets.end(), { {-1,-1}, {-1,1}, {1,-1}, {1,1} });
+    }
+    MPI_Comm graph_comm = grid.create_graph(offsets, radius, sizeof(double));
+
+    // owned block [istart,iend) x [jstart,jend), stored with a halo of width r
+    const size_t istart = grid.begin(0), iend = grid.end(0);
+    const size_t jstart = grid.begin(1), jend = grid.end(1);
+    const int bi = static_cast<int>(iend-istart), bj = static_cast<int>(jend-jstart);
+    const int mi = bi+2*r, mj = bj+2*r;
+
+    // the halo that goes to (or comes from) each neighbor, in graph order
+    const auto & neighbor_offsets = grid.neighbor_offsets();
+    const int degree = static_cast<int>(neighbor_offsets.size());
+    std::vector<MPI_Datatype> send_types(degree), recv_types(degree);
+    std::vector<int> counts(degree,1);
+    std::vector<MPI_Aint> displs(degree,0);
+    for (int k=0; k<degree; ++k) {
+        const int sizes[2] = {mi,mj};
+        const int owned[2] = {bi,bj};
+        int subsizes[2], send_starts[2], recv_starts[2];
+        for (int d=0; d<2; ++d) {
+            const int o = neighbor_offsets[k][d];
+            subsizes[d]    = (o==0) ? owned[d] : r;
+            send_starts[d] = (o>0) ? owned[d] : r;
+            recv_starts[d] = (o<0) ? 0 : (o>0) ? r+owned[d] : r;
+        }
+        prk::MPI::check( MPI_Type_create_subarray(2, sizes, subsizes, send_starts, MPI_ORDER_C, MPI_DOUBLE, &send_types[k]) );
+        prk::MPI::check( MPI_Type_create_subarray(2, sizes, subsizes, recv_starts, MPI_ORDER_C, MPI_DOUBLE, &recv_types[k]) );
+        prk::MPI::check( MPI_Type_commit(&send_types[k]) );
+        prk::MPI::check( MPI_Type_commit(&recv_types[k]) );
+    }
+
+    const auto points = prk::stencil::points(star, r);
+
+    // local bounds of the owned points in the interior of the grid
+    const int ilo = static_cast<int>(std::max(istart,radius)) - static_cast<int>(istart) + r;
+    const int ihi = static_cast<int>(std::min(iend,n-radius)) - static_cast<int>(istart) + r;
+    const int jlo = static_cast<int>(std::max(jstart,radius)) - static_cast<int>(jstart) + r;
+    const int jhi = static_cast<int>(std::min(jend,n-radius)) - static_cast<int>(jstart) + r;
+
     double stencil_time{0};
 
-    double * RESTRICT in  = new double[n*n];
-    double * RESTRICT out = new double[n*n];
+    std::vector<double> in(static_cast<size_t>(mi)*mj, 0.0);
+    std::vector<double> out(static_cast<size_t>(mi)*mj, 0.0);
 
-    {
-      for (size_t it=0; it<n; it+=tile_size) {
-        for (size_t jt=0; jt<n; jt+=tile_size) {
-          for (size_t i=it; i<std::min(n,it+tile_size); i++) {
-            for (size_t j=jt; j<std::min(n,jt+tile_size); j++) {
-              in[i*n+j] = static_cast<double>(i+j);
-              out[i*n+j] = 0.0;
-            }
+    auto step = [&]() {
+        // Exchange the halos
+        prk::MPI::check( MPI_Neighbor_alltoallw(in.data(), counts.data(), displs.data(), send_types.data(),
+                                                in.data(), counts.data(), displs.data(), recv_types.data(),
+                                                graph_comm) );
+        // Apply the stencil operator
+        if (ilo < ihi && jlo < jhi) {
+            apply(ilo, ihi, jlo, jhi, mj, tile_size, points, in.data(), out.data());
+        }
+        // Add constant to solution to force refresh of neighbor data, if any
+        for (int i=r; i<r+bi; i++) {
+          for (int j=r; j<r+bj; j++) {
+            in[static_cast<size_t>(i)*mj+j] += 1.0;
           }
         }
+    };
+
+    // the snapshot holds the owned points of in and then of out
+    const int snapshot_iter = iterations/2;
+    std::unique_ptr<prk::MPI::snapshot> snap;
+    if (snapshot) {
+        snap.reset(new prk::MPI::snapshot("stencil-mpi.snapshot", {(int)n,(int)n}, {bi,bj},
+                                          {(int)istart,(int)jstart}, 2, aggregators));
+    }
+    const size_t block = static_cast<size_t>(bi)*bj;
+    auto pack = [&](double * buffer) {
+        for (int i=0; i<bi; i++) {
+          std::copy_n(&in[static_cast<size_t>(i+r)*mj+r],  bj, &buffer[static_cast<size_t>(i)*bj]);
+          std::copy_n(&out[static_cast<size_t>(i+r)*mj+r], bj, &buffer[block+static_cast<size_t>(i)*bj]);
+        }
+    };
+    auto unpack = [&](const double * buffer) {
+        for (int i=0; i<bi; i++) {
+          std::copy_n(&buffer[static_cast<size_t>(i)*bj],       bj, &in[static_cast<size_t>(i+r)*mj+r]);
+          std::copy_n(&buffer[block+static_cast<size_t>(i)*bj], bj, &out[static_cast<size_t>(i+r)*mj+r]);
+        }
+    };
+
+    {
+      for (int i=r; i<r+bi; i++) {
+        for (int j=r; j<r+bj; j++) {
+          in[static_cast<size_t>(i)*mj+j] = static_cast<double>(istart+i-r + jstart+j-r);
+        }
       }
 
       for (int iter = 0; iter<=iterations; iter++) {
@@ -203,19 +360,18 @@ int main(int argc, char* argv[])
             stencil_time = prk::MPI::wtime();
         }
 
-        // Apply the stencil operator
-        stencil(n, tile_size, in, out);
-        // Add constant to solution to force refresh of neighbor data, if any
-        for (size_t it=0; it<n; it+=tile_size) {
-          for (size_t jt=0; jt<n; jt+=tile_size) {
-            for (size_t i=it; i<std::min(n,it+tile_size); i++) {
-              for (size_t j=jt; j<std::min(n,jt+tile_size); j++) {
-                in[i*n+j] += 1.0;
-              }
+        step();
+
+        if (snapshot) {
+            if (iter == snapshot_iter) {
+                pack(snap->buffer());
+                snap->write(async);
+            } else {
+                snap->test();
             }
-          }
         }
       }
+      if (snapshot) snap->wait();
       prk::MPI::barrier();
       stencil_time = prk::MPI::wtime() - stencil_time;
     }
@@ -227,21 +383,45 @@ int main(int argc, char* argv[])
     // interior of grid with respect to stencil
     size_t active_points = static_cast<size_t>(n-2*radius)*static_cast<size_t>(n-2*radius);
     // compute L1 norm in parallel
-    double norm(0);
-    for (size_t i=radius; i<n-radius; i++) {
-      for (size_t j=radius; j<n-radius; j++) {
-        norm += prk::abs(out[i*n+j]);
-      }
+    auto l1norm = [&]() {
+        const size_t rows = std::max(ihi-ilo,0), cols = std::max(jhi-jlo,0);
+        const double norm = prk::transform_reduce_index(rows*cols, 0.0, [&](size_t k) {
+            const size_t i = ilo + k/cols;
+            const size_t j = jlo + k%cols;
+            return prk::abs(out[i*mj+j]);
+        });
+        return prk::MPI::sum(norm) / active_points;
+    };
+    double norm = l1norm();
+
+    // restart from the snapshot in cleared grids and repeat the remaining iterations
+    double restart_norm(0), local_time(0);
+    if (snapshot) {
+        local_time = snap->write_local();
+        std::fill(in.begin(), in.end(), 0.0);
+        std::fill(out.begin(), out.end(), 0.0);
+        std::vector<double> restart(snap->size());
+        snap->read(restart.data());
+        unpack(restart.data());
+        for (int iter = snapshot_iter+1; iter<=iterations; iter++) {
+            step();
+        }
+        restart_norm = l1norm();
+    }
+
+    for (int k=0; k<degree; ++k) {
+        prk::MPI::check( MPI_Type_free(&send_types[k]) );
+        prk::MPI::check( MPI_Type_free(&recv_types[k]) );
     }
-    norm = prk::MPI::sum(norm);
-    norm /= active_points;
 
     // verify correctness
     const double epsilon = 1.0e-8;
     double reference_norm = 2.*(iterations+1.);
     if (prk::abs(norm-reference_norm) > epsilon) {
-      std::cout << "ERROR: L1 norm = " << norm
-                << " Reference L1 norm = " << reference_norm << std::endl;
+      if (me == 0) {
+        std::cout << "ERROR: L1 norm = " << norm
+                  << " Reference L1 norm = " << reference_norm << std::endl;
+      }
       return 1;
     } else {
       if (me == 0) {
@@ -255,6 +435,32 @@ int main(int argc, char* argv[])
         auto avgtime = stencil_time/iterations;
         std::cout << "Rate (MFlops/s): " << 1.0e-6 * static_cast<double>(flops)/avgtime
                   << " Avg time (s): " << avgtime << std::endl;
+
+        double intra, inter, row_intra, row_inter;
+        grid.halo_bytes(&intra, &inter);
+        grid.halo_bytes(&row_intra, &row_inter, true);
+        std::cout << "Halo bytes per iteration  Intra-node  Inter-node" << std::endl;
+        std::cout << "row-major               "
+                  << std::setw(12) << row_intra << std::setw(12) << row_inter << std::endl;
+        std::cout << "this placement          "
+                  << std::setw(12) << intra << std::setw(12) << inter << std::endl;
+      }
+    }
+
+    if (snapshot) {
+      const double write_time   = prk::MPI::max(snap->write_time());
+      const double exposed_time = prk::MPI::max(snap->exposed_time());
+      if (me == 0) {
+        // the restart repeats the same operations on the same data
+        if (restart_norm != norm) {
+          std::cout << "ERROR: restart L1 norm = " << restart_norm
+                    << " L1 norm = " << norm << std::endl;
+          return 1;
+        }
+        std::cout << "Restart from iteration " << snapshot_iter << " validates" << std::endl;
+        std::cout << "Snapshot (GB/s): " << 1.e-9*snap->bytes()/write_time
+                  << " Local files (GB/s): " << 1.e-9*snap->bytes()/local_time
+                  << " Exposed time (s): " << exposed_time << std::endl;
       }
     }
 
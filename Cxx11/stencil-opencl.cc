@@ -154,12 +154,11 @@ void run(cl::Context context, int iterations, int n, int radius, bool star)
   size_t active_points = static_cast<size_t>(n-2*radius)*static_cast<size_t>(n-2*radius);
 
   // compute L1 norm in parallel
-  double norm = 0.0;
-  for (int i=radius; i<n-radius; i++) {
-    for (int j=radius; j<n-radius; j++) {
-      norm += prk::abs(static_cast<double>(h_out[i*n+j]));
-    }
-  }
+  double norm = prk::transform_reduce_index(active_points, 0.0, [&](size_t k) {
+      const size_t i = radius + k/(n-2*radius);
+      const size_t j = radius + k%(n-2*radius);
+      return prk::abs(static_cast<double>(h_out[i*n+j]));
+  });
   norm /= active_points;
 
   // verify correctness
@@ -207,13 +207,11 @@ int main(int argc, char* argv[])
   // interior of grid with respect to stencil
   size_t active_points = static_cast<size_t>(n-2*radius)*static_cast<size_t>(n-2*radius);
   // compute L1 norm in parallel
-  double norm = 0.0;
-  OMP_PARALLEL_FOR_REDUCE( +:norm )
-  for (int i=radius; i<n-radius; i++) {
-    for (int j=radius; j<n-radius; j++) {
-      norm += prk::abs(out[i*n+j]);
-    }
-  }
+  double norm = prk::transform_reduce_index(active_points, 0.0, [&](size_t k) {
+      const size_t i = radius + k/(n-2*radius);
+      const size_t j = radius + k%(n-2*radius);
+      return prk::abs(out[i*n+j]);
+  });
   norm /= active_points;
 
   // verify correctness
@@ -61,6 +61,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #ifdef _OPENMP
 #include "prk_openmp.h"
 #include "stencil_openmp.hpp"
@@ -175,6 +176,7 @@ int main(int argc, char* argv[])
   //////////////////////////////////////////////////////////////////////
 
   double stencil_time{0};
+  prk::energy::meter energy;
 
   double * RESTRICT in  = new double[n*n];
   double * RESTRICT out = new double[n*n];
@@ -199,7 +201,10 @@ int main(int argc, char* argv[])
       if (iter==1) {
           OMP_BARRIER
           OMP_MASTER
-          stencil_time = prk::wtime();
+          {
+              stencil_time = prk::wtime();
+              energy.start();
+          }
       }
 
       // Apply the stencil operator
@@ -219,7 +224,10 @@ int main(int argc, char* argv[])
     }
     OMP_BARRIER
     OMP_MASTER
-    stencil_time = prk::wtime() - stencil_time;
+    {
+        stencil_time = prk::wtime() - stencil_time;
+        energy.stop();
+    }
   }
 
   //////////////////////////////////////////////////////////////////////
@@ -229,13 +237,11 @@ int main(int argc, char* argv[])
   // interior of grid with respect to stencil
   size_t active_points = static_cast<size_t>(n-2*radius)*static_cast<size_t>(n-2*radius);
   // compute L1 norm in parallel
-  double norm = 0.0;
-  OMP_PARALLEL_FOR_REDUCE( +:norm )
-  for (int i=radius; i<n-radius; i++) {
-    for (int j=radius; j<n-radius; j++) {
-      norm += prk::abs(out[i*n+j]);
-    }
-  }
+  double norm = prk::transform_reduce_index(active_points, 0.0, [&](size_t k) {
+      const size_t i = radius + k/(n-2*radius);
+      const size_t j = radius + k%(n-2*radius);
+      return prk::abs(out[i*n+j]);
+  });
   norm /= active_points;
 
   // verify correctness
@@ -256,6 +262,7 @@ int main(int argc, char* argv[])
     auto avgtime = stencil_time/iterations;
     std::cout << "Rate (MFlops/s): " << 1.0e-6 * static_cast<double>(flops)/avgtime
               << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, stencil_time, 1.0e-6 * static_cast<double>(flops), "MFlop");
   }
 
   return 0;
@@ -0,0 +1,376 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+//////////////////////////////////////////////////////////////////////
+///
+/// NAME:    Stencil
+///
+/// PURPOSE: This program tests the efficiency with which a space-invariant,
+///          linear, symmetric filter (stencil) can be applied to a square
+///          grid or image.
+///
+/// USAGE:   The program takes as input the linear
+///          dimension of the grid, and the number of iterations on the grid
+///
+///                <progname> <iterations> <grid size> [<band rows> <radius> <directory>]
+///
+///          The output consists of diagnostics to make sure the
+///          algorithm worked, and of timing statistics.
+///
+/// NOTES:   Out-of-core version for grids that do not fit in memory.  Both
+///          grids live in files in <directory> and are streamed through
+///          memory in bands of rows.  A ring of band buffers holds the
+///          2*ceil(r/b)+1 bands of "in" that the current band needs, plus one
+///          that is being prefetched; "out" is double buffered.  Reads and
+///          writes are issued asynchronously, so I/O overlaps with compute,
+///          and the time spent waiting for them is reported as I/O wait.
+///          Only star stencils are supported.
+///
+/// HISTORY: - Written by Rob Van der Wijngaart, February 2009.
+///          - RvdW: Removed unrolling pragmas for clarity;
+///            added constant to array "in" at end of each iteration to force
+///            refreshing of neighbor data in parallel versions; August 2013
+///            C++11-ification by Jeff Hammond, May 2017.
+///
+//////////////////////////////////////////////////////////////////////
+
+#include "prk_util.h"
+#include "prk_energy.h"
+
+#include <cstring>
+#include <cerrno>
+#include <future>
+
+#include <unistd.h>
+#include <fcntl.h>
+
+// Same weights as the generated star stencils: +/- 1/(2*k*R) at distance k.
+// rows[R] is the center row, rows[R-k] and rows[R+k] are k rows above and below.
+template <int R>
+void star_row(const int n, const double * const * rows, double * RESTRICT out)
+{
+    PRAGMA_SIMD
+    for (int j=R; j<n-R; ++j) {
+      double s(0);
+      for (int k=1; k<=R; ++k) {
+        const double w = 1.0/(2.0*k*R);
+        s += w * ( rows[R+k][j] - rows[R-k][j] + rows[R][j+k] - rows[R][j-k] );
+      }
+      out[j] += s;
+    }
+}
+
+// A grid stored in a file as n rows of n doubles, accessed by bands of rows.
+class band_file {
+
+    private:
+        int fd_;
+        int n_;
+        int b_;
+
+    public:
+
+        band_file(const std::string & dir, const char * label, int n, int b) : n_(n), b_(b)
+        {
+            std::string name = dir + "/prk-stencil-" + label + "-XXXXXX";
+            std::vector<char> tmpl(name.begin(), name.end());
+            tmpl.push_back('\0');
+            fd_ = mkstemp(tmpl.data());
+            if (fd_ < 0) {
+                std::cout << "ERROR: cannot create " << name << ": " << std::strerror(errno) << std::endl;
+                std::abort();
+            }
+            // the descriptor keeps the file alive until we are done
+            unlink(tmpl.data());
+        }
+
+        ~band_file() { close(fd_); }
+
+        int rows(int k) const { return std::min(b_, n_-k*b_); }
+
+        void read(int k, double * buf) const { io(k, buf, false); }
+
+        void write(int k, const double * buf) const { io(k, const_cast<double*>(buf), true); }
+
+    private:
+
+        void io(int k, double * buf, bool write) const
+        {
+            char * p = reinterpret_cast<char*>(buf);
+            size_t bytes = static_cast<size_t>(rows(k)) * n_ * sizeof(double);
+            off_t offset = static_cast<off_t>(k) * b_ * n_ * sizeof(double);
+            while (bytes > 0) {
+                ssize_t rc = write ? pwrite(fd_, p, bytes, offset) : pread(fd_, p, bytes, offset);
+                if (rc <= 0) {
+                    if (rc < 0 && errno == EINTR) continue;
+                    std::cout << "ERROR: " << (write ? "write" : "read") << " of band " << k << " failed: "
+                              << (rc < 0 ? std::strerror(errno) : "end of file") << std::endl;
+                    std::abort();
+                }
+                p += rc;
+                offset += rc;
+                bytes -= rc;
+            }
+        }
+};
+
+int main(int argc, char* argv[])
+{
+  std::cout << "Parallel Research Kernels version " << PRKVERSION << std::endl;
+  std::cout << "C++11 out-of-core Stencil execution on 2D grid" << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Process and test input parameters
+  //////////////////////////////////////////////////////////////////////
+
+  int iterations, n, radius, band;
+  std::string dir;
+  try {
+      if (argc < 3) {
+        throw "Usage: <# iterations> <array dimension> [<band rows> <radius> <directory>]";
+      }
+
+      // number of times to run the algorithm
+      iterations  = std::atoi(argv[1]);
+      if (iterations < 1) {
+        throw "ERROR: iterations must be >= 1";
+      }
+
+      // linear grid dimension
+      n  = std::atoi(argv[2]);
+      if (n < 1) {
+        throw "ERROR: grid dimension must be positive";
+      }
+
+      // rows per band
+      band = (argc > 3) ? std::atoi(argv[3]) : 64;
+      if (band < 1) band = 1;
+      if (band > n) band = n;
+
+      // stencil radius
+      radius = (argc > 4) ? std::atoi(argv[4]) : 2;
+      if ( (radius < 1) || (2*radius+1 > n) ) {
+        throw "ERROR: Stencil radius negative or too large";
+      }
+      if (radius > 5) {
+        throw "ERROR: Stencil radius must be <= 5";
+      }
+
+      dir = (argc > 5) ? std::string(argv[5]) : std::string(".");
+  }
+  catch (const char * e) {
+    std::cout << e << std::endl;
+    return 1;
+  }
+
+  // bands on either side of the current one that the stencil reaches
+  const int halo = prk::divceil(radius,band);
+  const int nbands = prk::divceil(n,band);
+  // window of in bands plus one being prefetched
+  const int in_slots = 2*halo+2;
+  const int out_slots = 2;
+  const size_t band_words = static_cast<size_t>(band)*n;
+
+  std::cout << "Number of iterations = " << iterations << std::endl;
+  std::cout << "Grid size            = " << n << std::endl;
+  std::cout << "Type of stencil      = star" << std::endl;
+  std::cout << "Radius of stencil    = " << radius << std::endl;
+  std::cout << "Band size (rows)     = " << band << std::endl;
+  std::cout << "Number of bands      = " << nbands << std::endl;
+  std::cout << "Resident memory (MB) = " << 1.e-6 * (in_slots+out_slots)*band_words*sizeof(double) << std::endl;
+  std::cout << "Directory            = " << dir << std::endl;
+
+  auto row_kernel = star_row<2>;
+  switch (radius) {
+      case 1: row_kernel = star_row<1>; break;
+      case 2: row_kernel = star_row<2>; break;
+      case 3: row_kernel = star_row<3>; break;
+      case 4: row_kernel = star_row<4>; break;
+      case 5: row_kernel = star_row<5>; break;
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // Allocate space and perform the computation
+  //////////////////////////////////////////////////////////////////////
+
+  band_file in_file(dir, "in", n, band);
+  band_file out_file(dir, "out", n, band);
+
+  prk::vector<double> in_buf(in_slots*band_words);
+  prk::vector<double> out_buf(out_slots*band_words);
+  std::vector<std::future<void>> in_io(in_slots);
+  std::vector<std::future<void>> out_io(out_slots);
+
+  auto in_band  = [&](int k) { return &in_buf[(k%in_slots)*band_words]; };
+  auto out_band = [&](int k) { return &out_buf[(k%out_slots)*band_words]; };
+
+  double io_wait{0};
+  auto wait = [&](std::future<void> & f) {
+      if (f.valid()) {
+          double t0 = prk::wtime();
+          f.get();
+          io_wait += prk::wtime() - t0;
+      }
+  };
+
+  // initialize both files band by band
+  for (int k=0; k<nbands; k++) {
+    double * pin = in_band(0);
+    double * pout = out_band(0);
+    for (int i=0; i<in_file.rows(k); i++) {
+      for (int j=0; j<n; j++) {
+        pin[i*n+j]  = static_cast<double>(k*band+i+j);
+        pout[i*n+j] = 0.0;
+      }
+    }
+    in_file.write(k, pin);
+    out_file.write(k, pout);
+  }
+
+  double stencil_time{0};
+  double io_time{0};
+  prk::energy::meter energy;
+
+  for (int iter = 0; iter<=iterations; iter++) {
+
+    if (iter==1) {
+        stencil_time = prk::wtime();
+        io_time = io_wait;
+        energy.start();
+    }
+
+    // prime the window and the first out band
+    for (int k=0; k<=std::min(halo,nbands-1); k++) {
+        in_io[k%in_slots] = std::async(std::launch::async, [&,k] { in_file.read(k, in_band(k)); });
+    }
+    out_io[0] = std::async(std::launch::async, [&] { out_file.read(0, out_band(0)); });
+
+    for (int k=0; k<nbands; k++) {
+
+      // prefetch the next in band and the next out band into slots whose writes must finish first
+      const int kn = k+halo+1;
+      if (kn < nbands) {
+          wait(in_io[kn%in_slots]);
+          in_io[kn%in_slots] = std::async(std::launch::async, [&,kn] { in_file.read(kn, in_band(kn)); });
+      }
+      if (k+1 < nbands) {
+          wait(out_io[(k+1)%out_slots]);
+          out_io[(k+1)%out_slots] = std::async(std::launch::async, [&,k] { out_file.read(k+1, out_band(k+1)); });
+      }
+
+      // the bands the current one reaches must be resident
+      for (int kk=std::max(0,k-halo); kk<=std::min(nbands-1,k+halo); kk++) {
+          wait(in_io[kk%in_slots]);
+      }
+      wait(out_io[k%out_slots]);
+
+      // Apply the stencil operator to the interior rows of this band
+      const double * rows[2*5+1];
+      double * pout = out_band(k);
+      for (int i=std::max(radius,k*band); i<std::min(n-radius,(k+1)*band); i++) {
+          for (int d=-radius; d<=radius; d++) {
+              const int ii = i+d;
+              rows[radius+d] = in_band(ii/band) + static_cast<size_t>(ii%band)*n;
+          }
+          row_kernel(n, rows, pout + static_cast<size_t>(i-k*band)*n);
+      }
+      out_io[k%out_slots] = std::async(std::launch::async, [&,k] { out_file.write(k, out_band(k)); });
+
+      // Add constant to the in band that no later band needs, and write it back
+      const int kd = k-halo;
+      if (kd >= 0) {
+          double * pin = in_band(kd);
+          for (size_t ij=0; ij<static_cast<size_t>(in_file.rows(kd))*n; ij++) pin[ij] += 1.0;
+          in_io[kd%in_slots] = std::async(std::launch::async, [&,kd] { in_file.write(kd, in_band(kd)); });
+      }
+    }
+    // the last halo bands are released after the sweep
+    for (int kd=std::max(0,nbands-halo); kd<nbands; kd++) {
+        double * pin = in_band(kd);
+        for (size_t ij=0; ij<static_cast<size_t>(in_file.rows(kd))*n; ij++) pin[ij] += 1.0;
+        in_io[kd%in_slots] = std::async(std::launch::async, [&,kd] { in_file.write(kd, in_band(kd)); });
+    }
+    // the next sweep rereads the files
+    for (auto & f : in_io)  wait(f);
+    for (auto & f : out_io) wait(f);
+  }
+  stencil_time = prk::wtime() - stencil_time;
+  io_time = io_wait - io_time;
+  energy.stop();
+
+  //////////////////////////////////////////////////////////////////////
+  // Analyze and output results.
+  //////////////////////////////////////////////////////////////////////
+
+  // interior of grid with respect to stencil
+  size_t active_points = static_cast<size_t>(n-2*radius)*static_cast<size_t>(n-2*radius);
+  double norm = 0.0;
+  for (int k=0; k<nbands; k++) {
+    double * pout = out_band(0);
+    out_file.read(k, pout);
+    const int ilo = std::max(radius,k*band), ihi = std::min(n-radius,(k+1)*band);
+    if (ilo >= ihi) continue;
+    norm += prk::transform_reduce_index(static_cast<size_t>(ihi-ilo)*(n-2*radius), 0.0, [&](size_t p) {
+        const size_t i = ilo - k*band + p/(n-2*radius);
+        const size_t j = radius + p%(n-2*radius);
+        return prk::abs(pout[i*n+j]);
+    });
+  }
+  norm /= active_points;
+
+  // verify correctness
+  const double epsilon = 1.0e-8;
+  double reference_norm = 2.*(iterations+1.);
+  if (prk::abs(norm-reference_norm) > epsilon) {
+    std::cout << "ERROR: L1 norm = " << norm
+              << " Reference L1 norm = " << reference_norm << std::endl;
+    return 1;
+  } else {
+    std::cout << "Solution validates" << std::endl;
+#ifdef VERBOSE
+    std::cout << "L1 norm = " << norm
+              << " Reference L1 norm = " << reference_norm << std::endl;
+#endif
+    const int stencil_size = 4*radius+1;
+    size_t flops = (2L*(size_t)stencil_size+1L) * active_points;
+    // in and out are each read and written once per sweep
+    double bytes = 4.0 * n * n * sizeof(double);
+    auto avgtime = stencil_time/iterations;
+    std::cout << "Rate (MFlops/s): " << 1.0e-6 * static_cast<double>(flops)/avgtime
+              << " Avg time (s): " << avgtime << std::endl;
+    std::cout << "I/O rate (MB/s): " << 1.0e-6 * bytes/avgtime
+              << " I/O wait (s): " << io_time/iterations
+              << " (" << 100.0*io_time/stencil_time << "%)" << std::endl;
+    energy.report(iterations, stencil_time, 1.0e-6 * static_cast<double>(flops), "MFlop");
+  }
+
+  return 0;
+}
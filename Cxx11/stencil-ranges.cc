@@ -61,6 +61,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 
 #include "range/v3/view/cartesian_product.hpp"
 #include "range/v3/view/stride.hpp"
@@ -169,6 +170,7 @@ int main(int argc, char* argv[])
   //////////////////////////////////////////////////////////////////////
 
   double stencil_time{0};
+  prk::energy::meter energy;
 
   prk::vector<double> in(n*n);
   prk::vector<double> out(n*n);
@@ -183,7 +185,10 @@ int main(int argc, char* argv[])
 
   for (int iter = 0; iter<=iterations; iter++) {
 
-    if (iter==1) stencil_time = prk::wtime();
+    if (iter==1) {
+        stencil_time = prk::wtime();
+        energy.start();
+    }
 
     // Apply the stencil operator
     stencil(n, tile_size, in, out);
@@ -196,6 +201,7 @@ int main(int argc, char* argv[])
   }
 
   stencil_time = prk::wtime() - stencil_time;
+  energy.stop();
 
   //////////////////////////////////////////////////////////////////////
   // Analyze and output results.
@@ -205,13 +211,11 @@ int main(int argc, char* argv[])
   size_t active_points = static_cast<size_t>(n-2*radius)*static_cast<size_t>(n-2*radius);
 
   // compute L1 norm in parallel
-  double norm = 0.0;
-  auto inside = prk::range(radius,n-radius);
-  for (auto i : inside) {
-    for (auto j : inside) {
-      norm += prk::abs(out[i*n+j]);
-    }
-  }
+  double norm = prk::transform_reduce_index(active_points, 0.0, [&](size_t k) {
+      const size_t i = radius + k/(n-2*radius);
+      const size_t j = radius + k%(n-2*radius);
+      return prk::abs(out[i*n+j]);
+  });
   norm /= active_points;
 
   // verify correctness
@@ -232,6 +236,7 @@ int main(int argc, char* argv[])
     auto avgtime = stencil_time/iterations;
     std::cout << "Rate (MFlops/s): " << 1.0e-6 * static_cast<double>(flops)/avgtime
               << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, stencil_time, 1.0e-6 * static_cast<double>(flops), "MFlop");
   }
 
   return 0;
@@ -61,6 +61,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "stencil_stl.hpp"
 
 void nothing(const int n, const int t, std::vector<double> & in, std::vector<double> & out)
@@ -163,6 +164,7 @@ int main(int argc, char* argv[])
   //////////////////////////////////////////////////////////////////////
 
   double stencil_time{0};
+  prk::energy::meter energy;
 
   std::vector<double> in(n*n);
   std::vector<double> out(n*n);
@@ -177,7 +179,10 @@ int main(int argc, char* argv[])
   });
 
   for (int iter = 0; iter<=iterations; iter++) {
-    if (iter==1) stencil_time = prk::wtime();
+    if (iter==1) {
+        stencil_time = prk::wtime();
+        energy.start();
+    }
     // Apply the stencil operator
     stencil(n, tile_size, in, out);
     // Add constant to solution to force refresh of neighbor data, if any
@@ -185,6 +190,7 @@ int main(int argc, char* argv[])
   }
 
   stencil_time = prk::wtime() - stencil_time;
+  energy.stop();
 
   //////////////////////////////////////////////////////////////////////
   // Analyze and output results.
@@ -194,13 +200,11 @@ int main(int argc, char* argv[])
   size_t active_points = static_cast<size_t>(n-2*radius)*static_cast<size_t>(n-2*radius);
 
   // compute L1 norm in parallel
-  double norm = 0.0;
-  auto inside = prk::range(radius,n-radius);
-  for (auto i : inside) {
-    for (auto j : inside) {
-      norm += prk::abs(out[i*n+j]);
-    }
-  }
+  double norm = prk::transform_reduce_index(active_points, 0.0, [&](size_t k) {
+      const size_t i = radius + k/(n-2*radius);
+      const size_t j = radius + k%(n-2*radius);
+      return prk::abs(out[i*n+j]);
+  });
   norm /= active_points;
 
   // verify correctness
@@ -221,6 +225,7 @@ int main(int argc, char* argv[])
     auto avgtime = stencil_time/iterations;
     std::cout << "Rate (MFlops/s): " << 1.0e-6 * static_cast<double>(flops)/avgtime
               << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, stencil_time, 1.0e-6 * static_cast<double>(flops), "MFlop");
   }
 
   return 0;
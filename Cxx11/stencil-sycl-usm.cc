@@ -162,12 +162,11 @@ void run(sycl::queue & q, int iterations, size_t n, size_t block_size, bool star
   auto active_points = (n-2L*radius)*(n-2L*radius);
 
   // compute L1 norm in parallel
-  double norm(0);
-  for (int i=radius; i<n-radius; i++) {
-    for (int j=radius; j<n-radius; j++) {
-      norm += prk::abs(out[i*n+j]);
-    }
-  }
+  double norm = prk::transform_reduce_index(active_points, 0.0, [&](size_t k) {
+      const size_t i = radius + k/(n-2*radius);
+      const size_t j = radius + k%(n-2*radius);
+      return prk::abs(out[i*n+j]);
+  });
   norm /= active_points;
 
   sycl::free(out, q);
@@ -61,6 +61,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "prk_tbb.h"
 #include "stencil_tbb.hpp"
 
@@ -169,6 +170,7 @@ int main(int argc, char* argv[])
   //////////////////////////////////////////////////////////////////////
 
   double stencil_time{0};
+  prk::energy::meter energy;
 
   prk::vector<double> in(n*n);
   prk::vector<double> out(n*n);
@@ -186,7 +188,10 @@ int main(int argc, char* argv[])
 
   for (int iter = 0; iter<=iterations; iter++) {
 
-    if (iter==1) stencil_time = prk::wtime();
+    if (iter==1) {
+        stencil_time = prk::wtime();
+        energy.start();
+    }
     // Apply the stencil operator
     stencil(n, tile_size, in, out);
     // Add constant to solution to force refresh of neighbor data, if any
@@ -200,6 +205,7 @@ int main(int argc, char* argv[])
                      }, tbb_partitioner);
   }
   stencil_time = prk::wtime() - stencil_time;
+  energy.stop();
 
   //////////////////////////////////////////////////////////////////////
   // Analyze and output results.
@@ -209,27 +215,11 @@ int main(int argc, char* argv[])
   size_t active_points = static_cast<size_t>(n-2*radius)*static_cast<size_t>(n-2*radius);
 
   // compute L1 norm in parallel
-  double norm = 0.0;
-#if 0
-  // Use this if, for whatever reason, TBB reductions are not reliable.
-  for (int i=radius; i<n-radius; i++) {
-    for (int j=radius; j<n-radius; j++) {
-      norm += prk::abs(out[i*n+j]);
-    }
-  }
-#else
-  norm = tbb::parallel_reduce( range, double(0),
-                               [&](decltype(range)& r, double temp) -> double {
-                                   for (int i=r.rows().begin(); i!=r.rows().end(); ++i ) {
-                                       for (int j=r.cols().begin(); j!=r.cols().end(); ++j ) {
-                                           temp += prk::abs(out[i*n+j]);
-                                       }
-                                   }
-                                   return temp;
-                               },
-                               [] (const double x1, const double x2) { return x1+x2; },
-                               tbb_partitioner );
-#endif
+  double norm = prk::transform_reduce_index(active_points, 0.0, [&](size_t k) {
+      const size_t i = radius + k/(n-2*radius);
+      const size_t j = radius + k%(n-2*radius);
+      return prk::abs(out[i*n+j]);
+  });
   norm /= active_points;
 
   // verify correctness
@@ -250,6 +240,7 @@ int main(int argc, char* argv[])
     auto avgtime = stencil_time/iterations;
     std::cout << "Rate (MFlops/s): " << 1.0e-6 * static_cast<double>(flops)/avgtime
               << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, stencil_time, 1.0e-6 * static_cast<double>(flops), "MFlop");
   }
 
   return 0;
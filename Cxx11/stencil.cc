@@ -41,11 +41,25 @@
 /// USAGE:   The program takes as input the linear
 ///          dimension of the grid, and the number of iterations on the grid
 ///
-///                <progname> <iterations> <grid size>
+///                <progname> <iterations> <grid size> [<tile size> <star/grid> <radius>
+///                                                     <const/double/float>]
 ///
 ///          The output consists of diagnostics to make sure the
 ///          algorithm worked, and of timing statistics.
 ///
+///          With double or float coefficients, every stencil point has its
+///          own weight array over the grid (structure of arrays), stored in
+///          that precision and streamed with the input.  The weight of
+///          point k at (i,j) is the constant weight times 1+a(i,j), where a
+///          is +1/2 or -1/2 on the two halves of the grid in i (for even
+///          symmetric pairs of points) or j (for odd ones) and 0 on the
+///          middle line.  Both points of a pair share a, so the weights
+///          still sum to zero and each pair contributes its constant value
+///          times 1+a; since a averages to zero over the interior, the L1
+///          norm is unchanged.  Float weights are rounded, which changes the
+///          norm by a relative error of order 1.e-7, so that mode is
+///          validated to a relative tolerance of 1.e-6.
+///
 /// FUNCTIONS CALLED:
 ///
 ///          Other than standard C functions, the following functions are used in
@@ -61,7 +75,49 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "stencil_seq.hpp"
+#include "prk_stencil.h"
+
+// Applies the stencil with one weight array of n*n entries per point.
+template <typename T>
+void variable(const int n, const int t, const int r, const std::vector<prk::stencil::point_t> & points,
+              prk::vector<T> & w, prk::vector<double> & in, prk::vector<double> & out)
+{
+    const size_t nn = static_cast<size_t>(n)*static_cast<size_t>(n);
+    for (int it=r; it<n-r; it+=t) {
+      for (int jt=r; jt<n-r; jt+=t) {
+        const int jlo = jt, jhi = std::min(n-r,jt+t);
+        for (int i=it; i<std::min(n-r,it+t); ++i) {
+          double * RESTRICT o = &(out[static_cast<size_t>(i)*n]);
+          for (size_t k=0; k<points.size(); ++k) {
+            const T * RESTRICT wk = &(w[k*nn + static_cast<size_t>(i)*n]);
+            const double * RESTRICT ik = &(in[static_cast<size_t>(i+points[k].di)*n + points[k].dj]);
+            PRAGMA_SIMD
+            for (int j=jlo; j<jhi; ++j) {
+              o[j] += wk[j] * ik[j];
+            }
+          }
+        }
+      }
+    }
+}
+
+template <typename T>
+void init_weights(const int n, const std::vector<prk::stencil::point_t> & points, prk::vector<T> & w)
+{
+    const size_t nn = static_cast<size_t>(n)*static_cast<size_t>(n);
+    // a is odd about the middle of the interior [r,n-r), so it averages to zero
+    auto half = [=](int i) { return (2*i < n-1) ? -0.5 : (2*i > n-1) ? 0.5 : 0.0; };
+    for (size_t k=0; k<points.size(); ++k) {
+      for (int i=0; i<n; i++) {
+        for (int j=0; j<n; j++) {
+          const double a = (points[k].pair % 2 == 0) ? half(i) : half(j);
+          w[k*nn + static_cast<size_t>(i)*n + j] = static_cast<T>(points[k].weight * (1.0+a));
+        }
+      }
+    }
+}
 
 void nothing(const int n, const int t, prk::vector<double> & in, prk::vector<double> & out)
 {
@@ -84,9 +140,10 @@ int main(int argc, char* argv[])
 
   int iterations, n, radius, tile_size;
   bool star = true;
+  std::string coefficients("const");
   try {
       if (argc < 3) {
-        throw "Usage: <# iterations> <array dimension> [<tile_size> <star/grid> <radius>]";
+        throw "Usage: <# iterations> <array dimension> [<tile_size> <star/grid> <radius> <const/double/float>]";
       }
 
       // number of times to run the algorithm
@@ -127,6 +184,14 @@ int main(int argc, char* argv[])
       if ( (radius < 1) || (2*radius+1 > n) ) {
         throw "ERROR: Stencil radius negative or too large";
       }
+
+      // coefficient storage
+      if (argc > 6) {
+          coefficients = std::string(argv[6]);
+          if (coefficients != "const" && coefficients != "double" && coefficients != "float") {
+            throw "ERROR: coefficients must be const, double or float";
+          }
+      }
   }
   catch (const char * e) {
     std::cout << e << std::endl;
@@ -138,6 +203,7 @@ int main(int argc, char* argv[])
   std::cout << "Tile size            = " << tile_size << std::endl;
   std::cout << "Type of stencil      = " << (star ? "star" : "grid") << std::endl;
   std::cout << "Radius of stencil    = " << radius << std::endl;
+  std::cout << "Coefficients         = " << (coefficients == "const" ? "constant" : coefficients) << std::endl;
 
   auto stencil = nothing;
   if (star) {
@@ -163,10 +229,20 @@ int main(int argc, char* argv[])
   //////////////////////////////////////////////////////////////////////
 
   double stencil_time{0};
+  prk::energy::meter energy;
 
   prk::vector<double> in(n*n);
   prk::vector<double> out(n*n);
 
+  const bool variable_double = (coefficients == "double");
+  const bool variable_float  = (coefficients == "float");
+  const auto points = prk::stencil::points(star, radius);
+  const size_t nweights = points.size() * static_cast<size_t>(n) * static_cast<size_t>(n);
+  prk::vector<double> wd(variable_double ? nweights : 0);
+  prk::vector<float>  wf(variable_float  ? nweights : 0);
+  if (variable_double) init_weights(n, points, wd);
+  if (variable_float)  init_weights(n, points, wf);
+
   {
     for (int it=0; it<n; it+=tile_size) {
       for (int jt=0; jt<n; jt+=tile_size) {
@@ -182,13 +258,23 @@ int main(int argc, char* argv[])
 
     for (int iter = 0; iter<=iterations; iter++) {
 
-      if (iter==1) stencil_time = prk::wtime();
+      if (iter==1) {
+          stencil_time = prk::wtime();
+          energy.start();
+      }
       // Apply the stencil operator
-      stencil(n, tile_size, in, out);
+      if (variable_double) {
+          variable(n, tile_size, radius, points, wd, in, out);
+      } else if (variable_float) {
+          variable(n, tile_size, radius, points, wf, in, out);
+      } else {
+          stencil(n, tile_size, in, out);
+      }
       // Add constant to solution to force refresh of neighbor data, if any
       std::transform(in.begin(), in.end(), in.begin(), [](double c) { return c+=1.0; });
     }
     stencil_time = prk::wtime() - stencil_time;
+    energy.stop();
   }
 
   //////////////////////////////////////////////////////////////////////
@@ -197,17 +283,16 @@ int main(int argc, char* argv[])
 
   // interior of grid with respect to stencil
   size_t active_points = static_cast<size_t>(n-2*radius)*static_cast<size_t>(n-2*radius);
-  double norm = 0.0;
-  for (int i=radius; i<n-radius; i++) {
-    for (int j=radius; j<n-radius; j++) {
-      norm += prk::abs(out[i*n+j]);
-    }
-  }
+  double norm = prk::transform_reduce_index(active_points, 0.0, [&](size_t k) {
+      const size_t i = radius + k/(n-2*radius);
+      const size_t j = radius + k%(n-2*radius);
+      return prk::abs(out[i*n+j]);
+  });
   norm /= active_points;
 
   // verify correctness
-  const double epsilon = 1.0e-8;
   double reference_norm = 2.*(iterations+1.);
+  const double epsilon = variable_float ? 1.0e-6*reference_norm : 1.0e-8;
   if (prk::abs(norm-reference_norm) > epsilon) {
     std::cout << "ERROR: L1 norm = " << norm
               << " Reference L1 norm = " << reference_norm << std::endl;
@@ -223,6 +308,7 @@ int main(int argc, char* argv[])
     auto avgtime = stencil_time/iterations;
     std::cout << "Rate (MFlops/s): " << 1.0e-6 * static_cast<double>(flops)/avgtime
               << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, stencil_time, 1.0e-6 * static_cast<double>(flops), "MFlop");
   }
 
   return 0;
@@ -0,0 +1,396 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+//////////////////////////////////////////////////////////////////////
+///
+/// NAME:    tensor transpose
+///
+/// PURPOSE: This program measures the time for permuting the axes of a
+///          dense tensor, the N-dimensional generalization of the matrix
+///          transpose.
+///
+/// USAGE:   Program input is the number of iterations, the extents of the
+///          tensor as a comma-separated list and the permutation, and
+///          optionally the tile size.
+///
+///          <progname> <# iterations> <extents> <permutation> [tile size]
+///
+///          e.g. <progname> 10 64,64,64,64 0,2,1,3
+///
+///          B(j_0,...,j_{d-1}) = A(i_0,...,i_{d-1}) with j_k = i_{perm[k]},
+///          i.e. axis k of B is axis perm[k] of A.  Both are row-major.
+///
+///          The output consists of diagnostics to make sure the
+///          transpose worked and timing statistics.
+///
+/// NOTES:   A plan is made once per permutation:
+///          - axes that stay adjacent and in order are fused, so e.g.
+///            (0,2,1,3) on 4 axes becomes (1,0,2) on 3;
+///          - if the permutation is then the identity, it is a copy;
+///          - if the innermost axis is unchanged, rows are copied;
+///          - otherwise the innermost axes of A and of B are tiled together
+///            so that reads and writes are both contiguous within a tile.
+///          The remaining axes are walked in the order of B.  All tiles of
+///          all outer indices form one flat parallel loop.  The result is
+///          checked against a naive element-by-element permutation, and the
+///          bandwidth is compared with that of a copy of the same size.
+///
+/// HISTORY: Matrix transpose written by  Rob Van der Wijngaart, February 2009.
+///
+//////////////////////////////////////////////////////////////////////
+
+#include "prk_util.h"
+#include "prk_energy.h"
+#include "prk_openmp.h"
+
+#include <sstream>
+
+static const int MAX_RANK = 6;
+
+struct tensor_plan {
+    enum { COPY, ROWS, TILED } kind;
+    int    rank;                    // after fusion
+    size_t extent[MAX_RANK];        // of A's axes
+    int    perm[MAX_RANK];
+    size_t strideA[MAX_RANK];       // of A's axes, in A
+    size_t strideB[MAX_RANK];       // of A's axes, in B
+    int    inA;                     // innermost axis of A
+    int    inB;                     // A axis that is innermost in B
+    int    outer[MAX_RANK];         // other axes, outermost first in B order
+    int    nouter;
+    size_t tile;
+    size_t ntileA, ntileB;          // tiles along inA and inB
+    size_t nwork;                   // independent work items
+};
+
+static std::vector<size_t> parse_list(const char * s)
+{
+    std::vector<size_t> v;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        v.push_back(std::atol(item.c_str()));
+    }
+    return v;
+}
+
+static tensor_plan make_plan(const std::vector<size_t> & extent, const std::vector<size_t> & perm, size_t tile)
+{
+    const int rank = extent.size();
+    tensor_plan p;
+
+    // fuse A axes a and a+1 when they are adjacent in B as well
+    std::vector<int> group(rank);         // fused axis of each original axis
+    {
+        std::vector<int> posB(rank);
+        for (int k=0; k<rank; k++) posB[perm[k]] = k;
+        int g = 0;
+        for (int a=0; a<rank; a++) {
+            if (a>0 && posB[a] != posB[a-1]+1) g++;
+            group[a] = g;
+        }
+        p.rank = g+1;
+    }
+    for (int g=0; g<p.rank; g++) p.extent[g] = 1;
+    for (int a=0; a<rank; a++) p.extent[group[a]] *= extent[a];
+    {
+        int k = 0;
+        for (int b=0; b<rank; b++) {
+            if (b==0 || group[perm[b]] != group[perm[b-1]]) p.perm[k++] = group[perm[b]];
+        }
+    }
+
+    // strides
+    size_t s = 1;
+    for (int a=p.rank-1; a>=0; a--) {
+        p.strideA[a] = s;
+        s *= p.extent[a];
+    }
+    s = 1;
+    for (int k=p.rank-1; k>=0; k--) {
+        p.strideB[p.perm[k]] = s;
+        s *= p.extent[p.perm[k]];
+    }
+
+    p.inA = p.rank-1;
+    p.inB = p.perm[p.rank-1];
+    if (p.rank == 1) {
+        p.kind = tensor_plan::COPY;
+    } else if (p.inA == p.inB) {
+        p.kind = tensor_plan::ROWS;
+    } else {
+        p.kind = tensor_plan::TILED;
+    }
+
+    p.nouter = 0;
+    for (int k=0; k<p.rank; k++) {
+        const int a = p.perm[k];
+        if (a != p.inA && a != p.inB) p.outer[p.nouter++] = a;
+    }
+
+    p.tile = tile;
+    p.ntileA = (p.kind == tensor_plan::TILED) ? prk::divceil(p.extent[p.inA],tile) : 1;
+    p.ntileB = (p.kind == tensor_plan::TILED) ? prk::divceil(p.extent[p.inB],tile) : 1;
+    p.nwork = p.ntileA * p.ntileB;
+    for (int o=0; o<p.nouter; o++) p.nwork *= p.extent[p.outer[o]];
+    if (p.kind == tensor_plan::COPY) p.nwork = 1;
+
+    return p;
+}
+
+static void print_plan(const tensor_plan & p)
+{
+    std::cout << "Fused extents        = ";
+    for (int a=0; a<p.rank; a++) std::cout << (a ? "," : "") << p.extent[a];
+    std::cout << std::endl << "Fused permutation    = ";
+    for (int k=0; k<p.rank; k++) std::cout << (k ? "," : "") << p.perm[k];
+    std::cout << std::endl << "Kernel               = ";
+    switch (p.kind) {
+        case tensor_plan::COPY:  std::cout << "copy"; break;
+        case tensor_plan::ROWS:  std::cout << "row copy of length " << p.extent[p.inA]; break;
+        case tensor_plan::TILED: std::cout << "tiled axes " << p.inA << " and " << p.inB
+                                           << " with tile " << p.tile; break;
+    }
+    std::cout << std::endl << "Outer loop order     = ";
+    for (int o=0; o<p.nouter; o++) std::cout << (o ? "," : "") << p.outer[o];
+    if (p.nouter == 0) std::cout << "none";
+    std::cout << std::endl << "Work items           = " << p.nwork << std::endl;
+}
+
+// one work item: all elements of one tile pair for one outer index
+static inline void transpose_work(const tensor_plan & p, size_t w,
+                                  const double * RESTRICT A, double * RESTRICT B)
+{
+    const size_t tb = w % p.ntileB; w /= p.ntileB;
+    const size_t ta = w % p.ntileA; w /= p.ntileA;
+    size_t offA = 0, offB = 0;
+    for (int o=p.nouter-1; o>=0; o--) {
+        const int a = p.outer[o];
+        const size_t i = w % p.extent[a];
+        w /= p.extent[a];
+        offA += i*p.strideA[a];
+        offB += i*p.strideB[a];
+    }
+
+    if (p.kind == tensor_plan::ROWS) {
+        const size_t n = p.extent[p.inA];
+        PRAGMA_SIMD
+        for (size_t x=0; x<n; x++) B[offB+x] = A[offA+x];
+        return;
+    }
+
+    // x runs along B's innermost axis (stride sA in A), y along A's (stride sB in B)
+    const size_t sA = p.strideA[p.inB];
+    const size_t sB = p.strideB[p.inA];
+    const size_t y0 = ta*p.tile, yend = std::min(p.extent[p.inA], y0+p.tile);
+    const size_t x0 = tb*p.tile, xend = std::min(p.extent[p.inB], x0+p.tile);
+    for (size_t y=y0; y<yend; y++) {
+        const double * RESTRICT a = &A[offA + y];
+        double * RESTRICT b = &B[offB + y*sB];
+        PRAGMA_SIMD
+        for (size_t x=x0; x<xend; x++) {
+            b[x] = a[x*sA];
+        }
+    }
+}
+
+int main(int argc, char * argv[])
+{
+  std::cout << "Parallel Research Kernels version " << PRKVERSION << std::endl;
+  std::cout << "C++11/OpenMP Tensor transpose: B = permute(A)" << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Read and test input parameters
+  //////////////////////////////////////////////////////////////////////
+
+  int iterations;
+  std::vector<size_t> extent, perm;
+  size_t tile_size;
+  size_t length = 1;
+  try {
+      if (argc < 4) {
+        throw "Usage: <# iterations> <extents, e.g. 64,64,64> <permutation, e.g. 2,1,0> [tile size]";
+      }
+
+      // number of times to do the transpose
+      iterations  = std::atoi(argv[1]);
+      if (iterations < 1) {
+        throw "ERROR: iterations must be >= 1";
+      }
+
+      extent = parse_list(argv[2]);
+      perm   = parse_list(argv[3]);
+      if (extent.size() < 1 || extent.size() > static_cast<size_t>(MAX_RANK)) {
+        throw "ERROR: tensor must have 1 to 6 axes";
+      }
+      if (perm.size() != extent.size()) {
+        throw "ERROR: permutation and extents must have the same length";
+      }
+      std::vector<bool> seen(perm.size(), false);
+      for (auto a : perm) {
+        if (a >= perm.size() || seen[a]) {
+          throw "ERROR: not a permutation";
+        }
+        seen[a] = true;
+      }
+      for (auto n : extent) {
+        if (n < 1) {
+          throw "ERROR: extents must be positive";
+        }
+        length *= n;
+      }
+
+      tile_size = (argc>4) ? std::atol(argv[4]) : 32;
+      if (tile_size < 1) tile_size = 32;
+  }
+  catch (const char * e) {
+    std::cout << e << std::endl;
+    return 1;
+  }
+
+  std::cout << "Number of threads    = " << omp_get_max_threads() << std::endl;
+  std::cout << "Number of iterations = " << iterations << std::endl;
+  std::cout << "Extents              = " << argv[2] << std::endl;
+  std::cout << "Permutation          = " << argv[3] << std::endl;
+
+  const tensor_plan plan = make_plan(extent, perm, tile_size);
+  print_plan(plan);
+
+  //////////////////////////////////////////////////////////////////////
+  // Allocate space and perform the computation
+  //////////////////////////////////////////////////////////////////////
+
+  prk::vector<double> A(length), B(length);
+
+  double copy_time{1.e30}, trans_time{0};
+  prk::energy::meter energy;
+
+  OMP_PARALLEL()
+  {
+    OMP_FOR()
+    for (size_t i=0; i<length; i++) {
+      A[i] = static_cast<double>(i);
+      B[i] = 0.0;
+    }
+
+    // reference bandwidth: copy of the same size, best of the iterations
+    for (int iter = 0; iter<=iterations; iter++) {
+      double t0{0};
+      OMP_BARRIER
+      OMP_MASTER
+      t0 = prk::wtime();
+      OMP_FOR_SIMD
+      for (size_t i=0; i<length; i++) {
+        B[i] = A[i];
+      }
+      OMP_MASTER
+      if (iter>0) copy_time = std::min(copy_time, prk::wtime() - t0);
+    }
+
+    // the copy left B == A, which would hide elements the transpose misses
+    OMP_FOR_SIMD
+    for (size_t i=0; i<length; i++) {
+      B[i] = 0.0;
+    }
+
+    for (int iter = 0; iter<=iterations; iter++) {
+
+      if (iter==1) {
+          OMP_BARRIER
+          OMP_MASTER
+          {
+              trans_time = prk::wtime();
+              energy.start();
+          }
+      }
+
+      if (plan.kind == tensor_plan::COPY) {
+        OMP_FOR_SIMD
+        for (size_t i=0; i<length; i++) {
+          B[i] = A[i];
+        }
+      } else {
+        OMP_FOR( schedule(static) )
+        for (size_t w=0; w<plan.nwork; w++) {
+          transpose_work(plan, w, A.data(), B.data());
+        }
+      }
+    }
+    OMP_BARRIER
+    OMP_MASTER
+    {
+        trans_time = prk::wtime() - trans_time;
+        energy.stop();
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  /// Analyze and output results
+  //////////////////////////////////////////////////////////////////////
+
+  // naive reference on the original (unfused) axes
+  const int rank = extent.size();
+  std::vector<size_t> strideB(rank);
+  {
+    size_t s = 1;
+    for (int k=rank-1; k>=0; k--) {
+      strideB[perm[k]] = s;
+      s *= extent[perm[k]];
+    }
+  }
+  size_t errors = 0;
+  std::vector<size_t> idx(rank, 0);
+  for (size_t i=0; i<length; i++) {
+    size_t j = 0;
+    for (int a=0; a<rank; a++) j += idx[a]*strideB[a];
+    if (B[j] != static_cast<double>(i)) errors++;
+    for (int a=rank-1; a>=0; a--) {
+      if (++idx[a] < extent[a]) break;
+      idx[a] = 0;
+    }
+  }
+
+  if (errors == 0) {
+    std::cout << "Solution validates" << std::endl;
+    const double avgtime = trans_time/iterations;
+    const double bytes = 2.0 * sizeof(double) * length;
+    std::cout << "Rate (MB/s): " << 1.0e-6 * bytes/avgtime
+              << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, trans_time, 1.0e-6 * bytes, "MB");
+    std::cout << "Copy rate (MB/s): " << 1.0e-6 * bytes/copy_time
+              << " Fraction of copy: " << copy_time/avgtime << std::endl;
+  } else {
+    std::cout << "ERROR: " << errors << " elements of B are wrong" << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -135,15 +135,11 @@ void run(sycl::queue & q, int iterations, size_t order, size_t block_size)
   //////////////////////////////////////////////////////////////////////
 
   const double addit = (iterations+1.) * (iterations/2.);
-  double abserr(0);
-  for (size_t i=0; i<order; ++i) {
-    for (size_t j=0; j<order; ++j) {
-      const size_t ij = i*order+j;
-      const size_t ji = j*order+i;
+  const double abserr = prk::transform_reduce_index(static_cast<size_t>(order)*order, 0.0, [&](size_t ji) {
+      const size_t ij = (ji%order)*order + ji/order;
       const double reference = static_cast<double>(ij)*(1.+iterations)+addit;
-      abserr += prk::abs(h_B[ji] - reference);
-    }
-  }
+      return prk::abs(h_B[ji] - reference);
+  });
 
 #ifdef VERBOSE
   std::cout << "Sum of absolute differences: " << abserr << std::endl;
@@ -53,6 +53,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 
 // These headers are busted with NVCC and GCC 5.4.0
 // The <future> header is busted with Cray C++ 8.6.1.
@@ -133,12 +134,16 @@ int main(int argc, char * argv[])
   std::iota(A.begin(), A.end(), 0.0);
 
   double trans_time{0};
+  prk::energy::meter energy;
 
   std::vector<std::future<void>> pool;
 
   for (int iter = 0; iter<=iterations; iter++) {
 
-    if (iter==1) trans_time = prk::wtime();
+    if (iter==1) {
+        trans_time = prk::wtime();
+        energy.start();
+    }
 
     for (int ib=0; ib<order; ib+=block_size) {
       for (int jb=0; jb<order; jb+=block_size) {
@@ -160,6 +165,7 @@ int main(int argc, char * argv[])
     pool.clear();
   }
   trans_time = prk::wtime() - trans_time;
+  energy.stop();
 
   //////////////////////////////////////////////////////////////////////
   /// Analyze and output results
@@ -167,15 +173,11 @@ int main(int argc, char * argv[])
 
   // TODO: replace with std::generate, std::accumulate, or similar
   const auto addit = (iterations+1.) * (iterations/2.);
-  auto abserr = 0.0;
-  for (int j=0; j<order; j++) {
-    for (int i=0; i<order; i++) {
-      const int ij = i*order+j;
-      const int ji = j*order+i;
+  const double abserr = prk::transform_reduce_index(static_cast<size_t>(order)*order, 0.0, [&](size_t ji) {
+      const size_t ij = (ji%order)*order + ji/order;
       const double reference = static_cast<double>(ij)*(1.+iterations)+addit;
-      abserr += prk::abs(B[ji] - reference);
-    }
-  }
+      return prk::abs(B[ji] - reference);
+  });
 
 #ifdef VERBOSE
   std::cout << "Sum of absolute differences: " << abserr << std::endl;
@@ -188,6 +190,7 @@ int main(int argc, char * argv[])
     auto bytes = (size_t)order * (size_t)order * sizeof(double);
     std::cout << "Rate (MB/s): " << 1.0e-6 * (2L*bytes)/avgtime
               << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, trans_time, 1.0e-6 * (2L*bytes), "MB");
   } else {
     std::cout << "ERROR: Aggregate squared error " << abserr
               << " exceeds threshold " << epsilon << std::endl;
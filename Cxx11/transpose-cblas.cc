@@ -50,6 +50,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 
 #if defined(MKL)
 #include <mkl.h>
@@ -104,6 +105,7 @@ int main(int argc, char * argv[])
   //////////////////////////////////////////////////////////////////////
 
   double trans_time{0};
+  prk::energy::meter energy;
 
   prk::vector<double> A(order*order);
   prk::vector<double> B(order*order,0.0);
@@ -116,7 +118,10 @@ int main(int argc, char * argv[])
   {
     for (int iter = 0; iter<=iterations; iter++) {
 
-      if (iter==1) trans_time = prk::wtime();
+      if (iter==1) {
+          trans_time = prk::wtime();
+          energy.start();
+      }
 
       // T = transpose(A)
 #if defined(MKL)
@@ -137,6 +142,7 @@ int main(int argc, char * argv[])
       cblas_daxpy(order*order, 1.0, one, 0, &(A[0]), 1);
     }
     trans_time = prk::wtime() - trans_time;
+    energy.stop();
   }
 
   //////////////////////////////////////////////////////////////////////
@@ -144,16 +150,11 @@ int main(int argc, char * argv[])
   //////////////////////////////////////////////////////////////////////
 
   const auto addit = (iterations+1.) * (iterations/2.);
-  double abserr(0);
-  // TODO: replace with std::generate, std::accumulate, or similar
-  for (int j=0; j<order; j++) {
-    for (int i=0; i<order; i++) {
-      const int ij = i*order+j;
-      const int ji = j*order+i;
+  const double abserr = prk::transform_reduce_index(static_cast<size_t>(order)*order, 0.0, [&](size_t ji) {
+      const size_t ij = (ji%order)*order + ji/order;
       const double reference = static_cast<double>(ij)*(1.+iterations)+addit;
-      abserr += prk::abs(B[ji] - reference);
-    }
-  }
+      return prk::abs(B[ji] - reference);
+  });
 
 #ifdef VERBOSE
   std::cout << "Sum of absolute differences: " << abserr << std::endl;
@@ -166,6 +167,7 @@ int main(int argc, char * argv[])
     auto bytes = (size_t)order * (size_t)order * sizeof(double);
     std::cout << "Rate (MB/s): " << 1.0e-6 * (2L*bytes)/avgtime
               << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, trans_time, 1.0e-6 * (2L*bytes), "MB");
   } else {
     std::cout << "ERROR: Aggregate squared error " << abserr
               << " exceeds threshold " << epsilon << std::endl;
@@ -165,15 +165,11 @@ int main(int argc, char * argv[])
   //////////////////////////////////////////////////////////////////////
 
   const double addit = (iterations+1.) * (iterations/2.);
-  double abserr(0);
-  for (size_t j=0; j<order; j++) {
-    for (size_t i=0; i<order; i++) {
-      const size_t ij = (size_t)i*(size_t)order+(size_t)j;
-      const size_t ji = (size_t)j*(size_t)order+(size_t)i;
+  const double abserr = prk::transform_reduce_index(static_cast<size_t>(order)*order, 0.0, [&](size_t ji) {
+      const size_t ij = (ji%order)*order + ji/order;
       const double reference = static_cast<double>(ij)*(1.+iterations)+addit;
-      abserr += prk::abs(h_b[ji] - reference);
-    }
-  }
+      return prk::abs(h_b[ji] - reference);
+  });
 
   sycl::free(h_b, q);
   sycl::free(h_a, q);
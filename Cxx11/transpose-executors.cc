@@ -50,6 +50,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "prk_pstl.h"
 #include "prk_executors.h"
 
@@ -104,11 +105,15 @@ int main(int argc, char * argv[])
   auto range = prk::range(0,order);
 
   double trans_time{0};
+  prk::energy::meter energy;
   auto urange = unifex::range_stream{0, order};
 
   for (int iter = 0; iter<=iterations; iter++) {
 
-    if (iter==1) trans_time = prk::wtime();
+    if (iter==1) {
+        trans_time = prk::wtime();
+        energy.start();
+    }
 
     unifex::sync_wait(
         unifex::for_each( urange, [&] (int i) {
@@ -120,21 +125,18 @@ int main(int argc, char * argv[])
     );
   }
   trans_time = prk::wtime() - trans_time;
+  energy.stop();
 
   //////////////////////////////////////////////////////////////////////
   /// Analyze and output results
   //////////////////////////////////////////////////////////////////////
 
   const auto addit = (iterations+1.) * (iterations/2.);
-  auto abserr = 0.0;
-  for (int j=0; j<order; j++) {
-    for (int i=0; i<order; i++) {
-      const int ij = i*order+j;
-      const int ji = j*order+i;
+  const double abserr = prk::transform_reduce_index(static_cast<size_t>(order)*order, 0.0, [&](size_t ji) {
+      const size_t ij = (ji%order)*order + ji/order;
       const double reference = static_cast<double>(ij)*(1.+iterations)+addit;
-      abserr += prk::abs(B[ji] - reference);
-    }
-  }
+      return prk::abs(B[ji] - reference);
+  });
 
 #ifdef VERBOSE
   std::cout << "Sum of absolute differences: " << abserr << std::endl;
@@ -147,6 +149,7 @@ int main(int argc, char * argv[])
     auto bytes = (size_t)order * (size_t)order * sizeof(double);
     std::cout << "Rate (MB/s): " << 1.0e-6 * (2L*bytes)/avgtime
               << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, trans_time, 1.0e-6 * (2L*bytes), "MB");
   } else {
     std::cout << "ERROR: Aggregate squared error " << abserr
               << " exceeds threshold " << epsilon << std::endl;
@@ -155,15 +155,11 @@ int main(int argc, char * argv[])
   //////////////////////////////////////////////////////////////////////
 
   const auto addit = (iterations+1.) * (iterations/2.);
-  auto abserr = 0.0;
-  for (int j=0; j<order; j++) {
-    for (int i=0; i<order; i++) {
-      const int ij = i*order+j;
-      const int ji = j*order+i;
+  const double abserr = prk::transform_reduce_index(static_cast<size_t>(order)*order, 0.0, [&](size_t ji) {
+      const size_t ij = (ji%order)*order + ji/order;
       const double reference = static_cast<double>(ij)*(1.+iterations)+addit;
-      abserr += prk::abs(h_B[ji] - reference);
-    }
-  }
+      return prk::abs(h_B[ji] - reference);
+  });
 
   delete[] h_A;
   delete[] h_B;
@@ -107,15 +107,11 @@ void run(cl::Context context, int iterations, int order)
 
   // TODO: replace with std::generate, std::accumulate, or similar
   const double addit = (iterations+1.0) * (0.5*iterations);
-  double abserr = 0.0;
-  for (int j=0; j<order; j++) {
-    for (int i=0; i<order; i++) {
-      const int ij = i*order+j;
-      const int ji = j*order+i;
-      const double reference = static_cast<double>(ij)*(iterations+1)+addit;
-      abserr += prk::abs(static_cast<double>(h_b[ji]) - reference);
-    }
-  }
+  const double abserr = prk::transform_reduce_index(static_cast<size_t>(order)*order, 0.0, [&](size_t ji) {
+      const size_t ij = (ji%order)*order + ji/order;
+      const double reference = static_cast<double>(ij)*(1.+iterations)+addit;
+      return prk::abs(static_cast<double>(h_b[ji]) - reference);
+  });
   //
   //////////////////////////////////////////////////////////////////////
   /// Analyze and output results
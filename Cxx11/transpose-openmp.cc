@@ -53,6 +53,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "prk_openmp.h"
 
 int main(int argc, char * argv[])
@@ -112,6 +113,7 @@ int main(int argc, char * argv[])
   //////////////////////////////////////////////////////////////////////
 
   double trans_time{0};
+  prk::energy::meter energy;
 
   double * RESTRICT A = new double[order*order];
   double * RESTRICT B = new double[order*order];
@@ -132,7 +134,10 @@ int main(int argc, char * argv[])
       if (iter==1) {
           OMP_BARRIER
           OMP_MASTER
-          trans_time = prk::wtime();
+          {
+              trans_time = prk::wtime();
+              energy.start();
+          }
       }
 
       // transpose the  matrix
@@ -163,7 +168,10 @@ int main(int argc, char * argv[])
     }
     OMP_BARRIER
     OMP_MASTER
-    trans_time = prk::wtime() - trans_time;
+    {
+        trans_time = prk::wtime() - trans_time;
+        energy.stop();
+    }
   }
 
   //////////////////////////////////////////////////////////////////////
@@ -171,16 +179,11 @@ int main(int argc, char * argv[])
   //////////////////////////////////////////////////////////////////////
 
   const auto addit = (iterations+1.) * (iterations/2.);
-  auto abserr = 0.0;
-  OMP_PARALLEL_FOR_REDUCE( +:abserr )
-  for (int j=0; j<order; j++) {
-    for (int i=0; i<order; i++) {
-      const int ij = i*order+j;
-      const int ji = j*order+i;
+  const double abserr = prk::transform_reduce_index(static_cast<size_t>(order)*order, 0.0, [&](size_t ji) {
+      const size_t ij = (ji%order)*order + ji/order;
       const double reference = static_cast<double>(ij)*(1.+iterations)+addit;
-      abserr += prk::abs(B[ji] - reference);
-    }
-  }
+      return prk::abs(B[ji] - reference);
+  });
 
 #ifdef VERBOSE
   std::cout << "Sum of absolute differences: " << abserr << std::endl;
@@ -193,6 +196,7 @@ int main(int argc, char * argv[])
     auto bytes = (size_t)order * (size_t)order * sizeof(double);
     std::cout << "Rate (MB/s): " << 1.0e-6 * (2L*bytes)/avgtime
               << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, trans_time, 1.0e-6 * (2L*bytes), "MB");
   } else {
     std::cout << "ERROR: Aggregate squared error " << abserr
               << " exceeds threshold " << epsilon << std::endl;
@@ -54,6 +54,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 
 #include "range/v3/view/cartesian_product.hpp"
 #include "range/v3/view/stride.hpp"
@@ -110,6 +111,7 @@ int main(int argc, char * argv[])
   //////////////////////////////////////////////////////////////////////
 
   double trans_time{0};
+  prk::energy::meter energy;
 
   prk::vector<double> A(order*order);
   prk::vector<double> B(order*order,0.0);
@@ -135,7 +137,10 @@ int main(int argc, char * argv[])
 
   for (int iter = 0; iter<=iterations; iter++) {
 
-    if (iter==1) trans_time = prk::wtime();
+    if (iter==1) {
+        trans_time = prk::wtime();
+        energy.start();
+    }
 
     if (tile_size < order) {
 #if USE_FOR_EACH_RANGES
@@ -174,6 +179,7 @@ int main(int argc, char * argv[])
     }
   }
   trans_time = prk::wtime() - trans_time;
+  energy.stop();
 
   //////////////////////////////////////////////////////////////////////
   /// Analyze and output results
@@ -181,17 +187,11 @@ int main(int argc, char * argv[])
 
   // TODO: replace with std::generate, std::accumulate, or similar
   auto const addit = (iterations+1.) * (iterations/2.);
-  double abserr(0);
-  auto irange = prk::range(0,order);
-  auto jrange = prk::range(0,order);
-  for (auto i : irange) {
-    for (auto j : jrange) {
-      const int ij = i*order+j;
-      const int ji = j*order+i;
+  const double abserr = prk::transform_reduce_index(static_cast<size_t>(order)*order, 0.0, [&](size_t ji) {
+      const size_t ij = (ji%order)*order + ji/order;
       const double reference = static_cast<double>(ij)*(1.+iterations)+addit;
-      abserr += prk::abs(B[ji] - reference);
-    }
-  }
+      return prk::abs(B[ji] - reference);
+  });
 
 #ifdef VERBOSE
   std::cout << "Sum of absolute differences: " << abserr << std::endl;
@@ -204,6 +204,7 @@ int main(int argc, char * argv[])
     auto bytes = (size_t)order * (size_t)order * sizeof(double);
     std::cout << "Rate (MB/s): " << 1.0e-6 * (2L*bytes)/avgtime
               << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, trans_time, 1.0e-6 * (2L*bytes), "MB");
   } else {
     std::cout << "ERROR: Aggregate squared error " << abserr
               << " exceeds threshold " << epsilon << std::endl;
@@ -0,0 +1,313 @@
+///
+/// Copyright (c) 2020, Intel Corporation
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///
+/// * Redistributions of source code must retain the above copyright
+///       notice, this list of conditions and the following disclaimer.
+/// * Redistributions in binary form must reproduce the above
+///       copyright notice, this list of conditions and the following
+///       disclaimer in the documentation and/or other materials provided
+///       with the distribution.
+/// * Neither the name of Intel Corporation nor the names of its
+///       contributors may be used to endorse or promote products
+///       derived from this software without specific prior written
+///       permission.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+/// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+/// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+/// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+/// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+/// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+/// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+/// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+/// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+/// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+//////////////////////////////////////////////////////////////////////
+///
+/// NAME:    transpose
+///
+/// PURPOSE: This program measures the time for the transpose of a
+///          column-major stored matrix into a row-major stored matrix.
+///
+/// USAGE:   Program input is the matrix order and the number of times to
+///          repeat the operation:
+///
+///          transpose <# iterations> <matrix_size> [tile size] [vector width] [taskloop grainsize]
+///
+///          The tile size (16, 32, 64 or 128) and the vector width (2, 4 or 8)
+///          select one of the compile-time specialized micro-kernels.
+///
+///          The output consists of diagnostics to make sure the
+///          transpose worked and timing statistics.
+///
+/// NOTES:   This is the C++ counterpart of the ISPC implementation in C1z.
+///          Each tile is processed in VW x VW blocks that are transposed in
+///          registers with log2(VW) stages of two-input shuffles.  Blocks at
+///          the edge of the matrix use partial loads and stores, so any matrix
+///          order is supported.  Tiles are distributed with OpenMP taskloop.
+///
+/// HISTORY: Written by  Rob Van der Wijngaart, February 2009.
+///          Converted to C++11 by Jeff Hammond, February 2016 and May 2017.
+///
+//////////////////////////////////////////////////////////////////////
+
+#include "prk_util.h"
+#include "prk_energy.h"
+#include "prk_openmp.h"
+
+#include <cstring>   // memcpy
+#include <utility>   // index_sequence
+
+template <int VW>
+struct simd {
+    typedef double type __attribute__((vector_size(VW*sizeof(double))));
+#if !defined(__clang__) && (__GNUC__ < 12)
+    typedef long long mask __attribute__((vector_size(VW*sizeof(long long))));
+#endif
+};
+
+// In the stage that swaps the off-diagonal HxH blocks, row r (with bit H clear)
+// and row r+H are rebuilt from elements of both.
+constexpr int lo_index(int VW, int H, int c) { return (c & H) ? VW + c - H : c; }
+constexpr int hi_index(int VW, int H, int c) { return (c & H) ? VW + c : c + H; }
+
+template <int VW, int H, size_t... C>
+inline void swap_blocks(typename simd<VW>::type & a, typename simd<VW>::type & b, std::index_sequence<C...>)
+{
+#if defined(__clang__) || (__GNUC__ >= 12)
+    typename simd<VW>::type lo = __builtin_shufflevector(a, b, lo_index(VW,H,C)...);
+    typename simd<VW>::type hi = __builtin_shufflevector(a, b, hi_index(VW,H,C)...);
+#else
+    typename simd<VW>::type lo = __builtin_shuffle(a, b, typename simd<VW>::mask{ lo_index(VW,H,C)... });
+    typename simd<VW>::type hi = __builtin_shuffle(a, b, typename simd<VW>::mask{ hi_index(VW,H,C)... });
+#endif
+    a = lo;
+    b = hi;
+}
+
+template <int VW, int H = VW/2>
+inline void transpose_registers(typename simd<VW>::type r[VW])
+{
+    for (int i=0; i<VW; i++) {
+        if ((i & H) == 0) swap_blocks<VW,H>(r[i], r[i+H], std::make_index_sequence<VW>{});
+    }
+    if constexpr (H > 1) transpose_registers<VW,H/2>(r);
+}
+
+// B[i0+c][j0+r] += A[j0+r][i0+c] and A[j0+r][i0+c] += 1 for r < nr and c < nc
+template <int VW>
+inline void transpose_block(const int order, const int i0, const int j0, const int nr, const int nc,
+                            double * RESTRICT A, double * RESTRICT B)
+{
+    typedef typename simd<VW>::type v;
+    v r[VW];
+    const v one = v{} + 1.0;
+    if (nr == VW && nc == VW) {
+        for (int k=0; k<VW; k++) {
+            std::memcpy(&r[k], &A[(j0+k)*order+i0], sizeof(v));
+            v a = r[k] + one;
+            std::memcpy(&A[(j0+k)*order+i0], &a, sizeof(v));
+        }
+        transpose_registers<VW>(r);
+        for (int k=0; k<VW; k++) {
+            v b;
+            std::memcpy(&b, &B[(i0+k)*order+j0], sizeof(v));
+            b += r[k];
+            std::memcpy(&B[(i0+k)*order+j0], &b, sizeof(v));
+        }
+    } else {
+        // masked remainder
+        for (int k=0; k<VW; k++) {
+            r[k] = v{};
+            if (k < nr) {
+                std::memcpy(&r[k], &A[(j0+k)*order+i0], nc*sizeof(double));
+                v a = r[k] + one;
+                std::memcpy(&A[(j0+k)*order+i0], &a, nc*sizeof(double));
+            }
+        }
+        transpose_registers<VW>(r);
+        for (int k=0; k<nc; k++) {
+            v b{};
+            std::memcpy(&b, &B[(i0+k)*order+j0], nr*sizeof(double));
+            b += r[k];
+            std::memcpy(&B[(i0+k)*order+j0], &b, nr*sizeof(double));
+        }
+    }
+}
+
+template <int TILE, int VW>
+void transpose_tile(const int order, const int it, const int jt, double * RESTRICT A, double * RESTRICT B)
+{
+    static_assert(TILE % VW == 0, "tile size must be a multiple of the vector width");
+    const int iend = std::min(order,it+TILE);
+    const int jend = std::min(order,jt+TILE);
+    for (int i0=it; i0<iend; i0+=VW) {
+        for (int j0=jt; j0<jend; j0+=VW) {
+            transpose_block<VW>(order, i0, j0, std::min(VW,jend-j0), std::min(VW,iend-i0), A, B);
+        }
+    }
+}
+
+typedef void (*tile_kernel)(const int, const int, const int, double * RESTRICT, double * RESTRICT);
+
+template <int VW>
+tile_kernel select_tile(int tile_size)
+{
+    switch (tile_size) {
+        case 16:  return transpose_tile<16,VW>;
+        case 32:  return transpose_tile<32,VW>;
+        case 64:  return transpose_tile<64,VW>;
+        case 128: return transpose_tile<128,VW>;
+        default:  return nullptr;
+    }
+}
+
+tile_kernel select_kernel(int tile_size, int vector_width)
+{
+    switch (vector_width) {
+        case 2: return select_tile<2>(tile_size);
+        case 4: return select_tile<4>(tile_size);
+        case 8: return select_tile<8>(tile_size);
+        default: return nullptr;
+    }
+}
+
+int main(int argc, char * argv[])
+{
+  std::cout << "Parallel Research Kernels version " << PRKVERSION << std::endl;
+  std::cout << "C++11/OpenMP TASKLOOP SIMD Matrix transpose: B = A^T" << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Read and test input parameters
+  //////////////////////////////////////////////////////////////////////
+
+  int iterations, gs;
+  int order;
+  int tile_size, vector_width;
+  tile_kernel kernel;
+  try {
+      if (argc < 3) {
+        throw "Usage: <# iterations> <matrix order> [tile size] [vector width] [taskloop grainsize]";
+      }
+
+      // number of times to do the transpose
+      iterations  = std::atoi(argv[1]);
+      if (iterations < 1) {
+        throw "ERROR: iterations must be >= 1";
+      }
+
+      // order of a the matrix
+      order = std::atoi(argv[2]);
+      if (order <= 0) {
+        throw "ERROR: Matrix Order must be greater than 0";
+      } else if (order > prk::get_max_matrix_size()) {
+        throw "ERROR: matrix dimension too large - overflow risk";
+      }
+
+      tile_size = (argc>3) ? std::atoi(argv[3]) : 32;
+      vector_width = (argc>4) ? std::atoi(argv[4]) : 8;
+      kernel = select_kernel(tile_size, vector_width);
+      if (kernel == nullptr) {
+        throw "ERROR: tile size must be 16, 32, 64 or 128 and vector width 2, 4 or 8";
+      }
+
+      // taskloop grainsize (in tiles)
+      gs = (argc > 5) ? std::atoi(argv[5]) : 1;
+      if (gs < 1) {
+        throw "ERROR: grainsize";
+      }
+  }
+  catch (const char * e) {
+    std::cout << e << std::endl;
+    return 1;
+  }
+
+#ifdef _OPENMP
+  std::cout << "Number of threads    = " << omp_get_max_threads() << std::endl;
+  std::cout << "Taskloop grainsize   = " << gs << std::endl;
+#endif
+  std::cout << "Number of iterations = " << iterations << std::endl;
+  std::cout << "Matrix order         = " << order << std::endl;
+  std::cout << "Tile size            = " << tile_size << std::endl;
+  std::cout << "Vector width         = " << vector_width << std::endl;
+
+  //////////////////////////////////////////////////////////////////////
+  // Allocate space and perform the computation
+  //////////////////////////////////////////////////////////////////////
+
+  prk::vector<double> A(order*order);
+  prk::vector<double> B(order*order);
+
+  double trans_time{0};
+  prk::energy::meter energy;
+
+  OMP_PARALLEL()
+  OMP_MASTER
+  {
+    OMP_TASKLOOP( firstprivate(order) shared(A,B) )
+    for (int i=0;i<order; i++) {
+      for (int j=0;j<order;j++) {
+        A[i*order+j] = static_cast<double>(i*order+j);
+        B[i*order+j] = 0.0;
+      }
+    }
+    OMP_TASKWAIT
+
+    for (int iter = 0; iter<=iterations; iter++) {
+
+      if (iter==1) {
+          trans_time = prk::wtime();
+          energy.start();
+      }
+
+      // transpose the  matrix
+      OMP_TASKLOOP_COLLAPSE(2, firstprivate(order,kernel) shared(A,B) grainsize(gs) )
+      for (int it=0; it<order; it+=tile_size) {
+        for (int jt=0; jt<order; jt+=tile_size) {
+          kernel(order, it, jt, A.data(), B.data());
+        }
+      }
+      OMP_TASKWAIT
+    }
+    trans_time = prk::wtime() - trans_time;
+    energy.stop();
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  /// Analyze and output results
+  //////////////////////////////////////////////////////////////////////
+
+  const auto addit = (iterations+1.) * (iterations/2.);
+  const double abserr = prk::transform_reduce_index(static_cast<size_t>(order)*order, 0.0, [&](size_t ji) {
+      const size_t ij = (ji%order)*order + ji/order;
+      const double reference = static_cast<double>(ij)*(1.+iterations)+addit;
+      return prk::abs(B[ji] - reference);
+  });
+
+#ifdef VERBOSE
+  std::cout << "Sum of absolute differences: " << abserr << std::endl;
+#endif
+
+  const auto epsilon = 1.0e-8;
+  if (abserr < epsilon) {
+    std::cout << "Solution validates" << std::endl;
+    auto avgtime = trans_time/iterations;
+    auto bytes = (size_t)order * (size_t)order * sizeof(double);
+    std::cout << "Rate (MB/s): " << 1.0e-6 * (2L*bytes)/avgtime
+              << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, trans_time, 1.0e-6 * (2L*bytes), "MB");
+  } else {
+    std::cout << "ERROR: Aggregate squared error " << abserr
+              << " exceeds threshold " << epsilon << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
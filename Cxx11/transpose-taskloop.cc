@@ -53,6 +53,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "prk_openmp.h"
 
 int main(int argc, char * argv[])
@@ -118,6 +119,7 @@ int main(int argc, char * argv[])
   prk::vector<double> B(order*order);
 
   double trans_time{0};
+  prk::energy::meter energy;
 
   OMP_PARALLEL()
   OMP_MASTER
@@ -133,7 +135,10 @@ int main(int argc, char * argv[])
 
     for (int iter = 0; iter<=iterations; iter++) {
 
-      if (iter==1) trans_time = prk::wtime();
+      if (iter==1) {
+          trans_time = prk::wtime();
+          energy.start();
+      }
 
       // transpose the  matrix
       if (tile_size < order) {
@@ -160,6 +165,7 @@ int main(int argc, char * argv[])
       OMP_TASKWAIT
     }
     trans_time = prk::wtime() - trans_time;
+    energy.stop();
   }
 
   //////////////////////////////////////////////////////////////////////
@@ -167,16 +173,11 @@ int main(int argc, char * argv[])
   //////////////////////////////////////////////////////////////////////
 
   const auto addit = (iterations+1.) * (iterations/2.);
-  auto abserr = 0.0;
-  OMP_PARALLEL_FOR_REDUCE( +:abserr )
-  for (int j=0; j<order; j++) {
-    for (int i=0; i<order; i++) {
-      const size_t ij = i*order+j;
-      const size_t ji = j*order+i;
+  const double abserr = prk::transform_reduce_index(static_cast<size_t>(order)*order, 0.0, [&](size_t ji) {
+      const size_t ij = (ji%order)*order + ji/order;
       const double reference = static_cast<double>(ij)*(1.+iterations)+addit;
-      abserr += prk::abs(B[ji] - reference);
-    }
-  }
+      return prk::abs(B[ji] - reference);
+  });
 
 #ifdef VERBOSE
   std::cout << "Sum of absolute differences: " << abserr << std::endl;
@@ -189,6 +190,7 @@ int main(int argc, char * argv[])
     auto bytes = (size_t)order * (size_t)order * sizeof(double);
     std::cout << "Rate (MB/s): " << 1.0e-6 * (2L*bytes)/avgtime
               << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, trans_time, 1.0e-6 * (2L*bytes), "MB");
   } else {
     std::cout << "ERROR: Aggregate squared error " << abserr
               << " exceeds threshold " << epsilon << std::endl;
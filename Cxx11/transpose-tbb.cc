@@ -53,6 +53,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 #include "prk_tbb.h"
 
 int main(int argc, char * argv[])
@@ -111,6 +112,7 @@ int main(int argc, char * argv[])
   //////////////////////////////////////////////////////////////////////
 
   double trans_time{0};
+  prk::energy::meter energy;
 
   prk::vector<double> A(order*order);
   prk::vector<double> B(order*order);
@@ -127,7 +129,10 @@ int main(int argc, char * argv[])
                    }, tbb_partitioner);
 
   for (int iter = 0; iter<=iterations; iter++) {
-    if (iter==1) trans_time = prk::wtime();
+    if (iter==1) {
+        trans_time = prk::wtime();
+        energy.start();
+    }
     tbb::parallel_for( range, [&](decltype(range)& r) {
                        for (int i=r.rows().begin(); i!=r.rows().end(); ++i ) {
                            PRAGMA_SIMD
@@ -139,39 +144,18 @@ int main(int argc, char * argv[])
                      }, tbb_partitioner);
   }
   trans_time = prk::wtime() - trans_time;
+  energy.stop();
 
   //////////////////////////////////////////////////////////////////////
   /// Analyze and output results
   //////////////////////////////////////////////////////////////////////
 
   const auto addit = (iterations+1.) * (iterations/2.);
-  double abserr(0);
-#if 0
-  // Use this if, for whatever reason, TBB reductions are not reliable.
-  for (int j=0; j<order; j++) {
-    for (int i=0; i<order; i++) {
-      const int ij = i*order+j;
-      const int ji = j*order+i;
+  const double abserr = prk::transform_reduce_index(static_cast<size_t>(order)*order, 0.0, [&](size_t ji) {
+      const size_t ij = (ji%order)*order + ji/order;
       const double reference = static_cast<double>(ij)*(1.+iterations)+addit;
-      abserr += prk::abs(B[ji] - reference);
-    }
-  }
-#else
-  abserr = tbb::parallel_reduce( range, double(0),
-                                 [&](decltype(range)& r, double temp) -> double {
-                                     for (int i=r.rows().begin(); i!=r.rows().end(); ++i ) {
-                                         for (int j=r.cols().begin(); j!=r.cols().end(); ++j ) {
-                                             const int ij = i*order+j;
-                                             const int ji = j*order+i;
-                                             const double reference = static_cast<double>(ij)*(1.+iterations)+addit;
-                                             temp += prk::abs(B[ji] - reference);
-                                         }
-                                     }
-                                     return temp;
-                                 },
-                                 [] (const double x1, const double x2) { return x1+x2; },
-                                 tbb_partitioner );
-#endif
+      return prk::abs(B[ji] - reference);
+  });
 
 #ifdef VERBOSE
   std::cout << "Sum of absolute differences: " << abserr << std::endl;
@@ -184,6 +168,7 @@ int main(int argc, char * argv[])
     auto bytes = (size_t)order * (size_t)order * sizeof(double);
     std::cout << "Rate (MB/s): " << 1.0e-6 * (2L*bytes)/avgtime
               << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, trans_time, 1.0e-6 * (2L*bytes), "MB");
   } else {
     std::cout << "ERROR: Aggregate squared error " << abserr
               << " exceeds threshold " << epsilon << std::endl;
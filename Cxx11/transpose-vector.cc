@@ -53,6 +53,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "prk_util.h"
+#include "prk_energy.h"
 
 int main(int argc, char * argv[])
 {
@@ -102,6 +103,7 @@ int main(int argc, char * argv[])
   //////////////////////////////////////////////////////////////////////
 
   double trans_time{0};
+  prk::energy::meter energy;
 
   std::vector<double> A(order*order);
   std::vector<double> B(order*order,0.0);
@@ -112,7 +114,10 @@ int main(int argc, char * argv[])
   {
     for (int iter = 0; iter<=iterations; iter++) {
 
-      if (iter==1) trans_time = prk::wtime();
+      if (iter==1) {
+          trans_time = prk::wtime();
+          energy.start();
+      }
 
       // transpose the  matrix
       if (tile_size < order) {
@@ -136,6 +141,7 @@ int main(int argc, char * argv[])
       }
     }
     trans_time = prk::wtime() - trans_time;
+    energy.stop();
   }
 
   //////////////////////////////////////////////////////////////////////
@@ -143,16 +149,11 @@ int main(int argc, char * argv[])
   //////////////////////////////////////////////////////////////////////
 
   const auto addit = (iterations+1.) * (iterations/2.);
-  double abserr(0);
-  // TODO: replace with std::generate, std::accumulate, or similar
-  for (int j=0; j<order; j++) {
-    for (int i=0; i<order; i++) {
-      const int ij = i*order+j;
-      const int ji = j*order+i;
+  const double abserr = prk::transform_reduce_index(static_cast<size_t>(order)*order, 0.0, [&](size_t ji) {
+      const size_t ij = (ji%order)*order + ji/order;
       const double reference = static_cast<double>(ij)*(1.+iterations)+addit;
-      abserr += prk::abs(B[ji] - reference);
-    }
-  }
+      return prk::abs(B[ji] - reference);
+  });
 
 #ifdef VERBOSE
   std::cout << "Sum of absolute differences: " << abserr << std::endl;
@@ -165,6 +166,7 @@ int main(int argc, char * argv[])
     auto bytes = (size_t)order * (size_t)order * sizeof(double);
     std::cout << "Rate (MB/s): " << 1.0e-6 * (2L*bytes)/avgtime
               << " Avg time (s): " << avgtime << std::endl;
+    energy.report(iterations, trans_time, 1.0e-6 * (2L*bytes), "MB");
   } else {
     std::cout << "ERROR: Aggregate squared error " << abserr
               << " exceeds threshold " << epsilon << std::endl;
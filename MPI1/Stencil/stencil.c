@@ -41,7 +41,18 @@ PURPOSE: This program tests the efficiency with which a space-invariant,
 USAGE:   The program takes as input the linear dimension of the grid,
          and the number of iterations on the grid
 
-               <progname> <# iterations> <grid size>
+               <progname> <# iterations> <grid size> [<codec> [<error bound>]]
+
+         The optional codec (none, lossless or lossy) compresses the halo
+         messages before they are sent and decompresses them after they
+         are received, see common/halo_codec.c.  The lossy codec changes
+         every ghost value by at most the error bound (default 1.e-6), so
+         each application of the stencil changes the output by at most
+         the bound times the sum of the absolute weights, and the
+         tolerance of the L1 norm is widened by that amount per
+         iteration.  For each message size, the compression ratio, the
+         codec cost per message and the one-way time of a ping-pong
+         between ranks 0 and 1 without and with the codec are reported.
 
          The output consists of diagnostics to make sure the
          algorithm worked, and of timing statistics.
@@ -70,6 +81,7 @@ HISTORY: - Written by Rob Van der Wijngaart, November 2006.
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <halo_codec.h>
 
 #if DOUBLE
   #define DTYPE     double
@@ -136,6 +148,15 @@ int main(int argc, char ** argv) {
   int    error=0;         /* error flag                                          */
   DTYPE  weight[2*RADIUS+1][2*RADIUS+1]; /* weights of points in the stencil     */
   MPI_Request request[8];
+  MPI_Status status;
+  int    codec_mode=HALO_CODEC_NONE; /* halo compression                         */
+  double codec_bound=1.e-6;  /* error bound of lossy compression                 */
+  halo_codec_t codec[2];  /* y- and x-direction messages                         */
+  unsigned char *top_pack_out=NULL, *top_pack_in=NULL, *bottom_pack_out=NULL,
+         *bottom_pack_in=NULL, *right_pack_out=NULL, *right_pack_in=NULL,
+         *left_pack_out=NULL, *left_pack_in=NULL;
+  size_t pack_y=0, pack_x=0;  /* capacity of compressed messages                 */
+  int    bytes;           /* size of a compressed message                        */
 
   /*******************************************************************************
   ** Initialize the MPI environment
@@ -157,8 +178,8 @@ int main(int argc, char ** argv) {
     goto ENDOFTESTS;
 #endif
 
-    if (argc != 3){
-      printf("Usage: %s <# iterations> <array dimension> \n",
+    if (argc < 3 || argc > 5){
+      printf("Usage: %s <# iterations> <array dimension> [none|lossless|lossy [<error bound>]]\n",
              *argv);
       error = 1;
       goto ENDOFTESTS;
@@ -192,6 +213,19 @@ int main(int argc, char ** argv) {
       goto ENDOFTESTS;
     }
 
+    if (argc > 3 && halo_codec_parse(*++argv, &codec_mode)) {
+      printf("ERROR: codec %s is not none, lossless or lossy\n", *argv);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
+    if (argc > 4) codec_bound = atof(*++argv);
+    if (codec_bound <= 0.0) {
+      printf("ERROR: error bound %e must be positive\n", codec_bound);
+      error = 1;
+      goto ENDOFTESTS;
+    }
+
     ENDOFTESTS:;
   }
   bail_out(error);
@@ -224,10 +258,17 @@ int main(int argc, char ** argv) {
     printf("Compact representation of stencil loop body\n");
 #endif
     printf("Number of iterations   = %d\n", iterations);
+    printf("Halo compression       = %s", halo_codec_name(codec_mode));
+    if (codec_mode == HALO_CODEC_LOSSY) printf(" (error bound %e)", codec_bound);
+    printf("\n");
   }
 
   MPI_Bcast(&n,          1, MPI_INT, root, MPI_COMM_WORLD);
   MPI_Bcast(&iterations, 1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&codec_mode, 1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&codec_bound,1, MPI_DOUBLE, root, MPI_COMM_WORLD);
+  halo_codec_init(&codec[0], codec_mode, codec_bound);
+  halo_codec_init(&codec[1], codec_mode, codec_bound);
 
   /* compute amount of space required for input and solution arrays             */
 
@@ -325,6 +366,24 @@ int main(int argc, char ** argv) {
     right_buf_in   = right_buf_out +   RADIUS*height;
     left_buf_out   = right_buf_out + 2*RADIUS*height;
     left_buf_in    = right_buf_out + 3*RADIUS*height;
+
+    if (codec_mode != HALO_CODEC_NONE) {
+      pack_y = halo_codec_max_bytes(RADIUS*width,  sizeof(DTYPE));
+      pack_x = halo_codec_max_bytes(RADIUS*height, sizeof(DTYPE));
+      top_pack_out   = (unsigned char *) prk_malloc(4*(pack_y+pack_x));
+      if (!top_pack_out) {
+        printf("ERROR: Rank %d could not allocate compressed comm buffers\n", my_ID);
+        error = 1;
+      }
+      bail_out(error);
+      top_pack_in     = top_pack_out +   pack_y;
+      bottom_pack_out = top_pack_out + 2*pack_y;
+      bottom_pack_in  = top_pack_out + 3*pack_y;
+      right_pack_out  = top_pack_out + 4*pack_y;
+      right_pack_in   = right_pack_out +   pack_x;
+      left_pack_out   = right_pack_out + 2*pack_x;
+      left_pack_in    = right_pack_out + 3*pack_x;
+    }
   }
 
   for (iter = 0; iter<=iterations; iter++){
@@ -333,37 +392,67 @@ int main(int argc, char ** argv) {
     if (iter == 1) {
       MPI_Barrier(MPI_COMM_WORLD);
       local_stencil_time = wtime();
+      halo_codec_init(&codec[0], codec_mode, codec_bound);
+      halo_codec_init(&codec[1], codec_mode, codec_bound);
     }
 
     /* need to fetch ghost point data from neighbors in y-direction                 */
     if (my_IDy < Num_procsy-1) {
+      if (codec_mode == HALO_CODEC_NONE)
       MPI_Irecv(top_buf_in, RADIUS*width, MPI_DTYPE, top_nbr, 101,
                 MPI_COMM_WORLD, &(request[1]));
+      else
+      MPI_Irecv(top_pack_in, pack_y, MPI_BYTE, top_nbr, 101,
+                MPI_COMM_WORLD, &(request[1]));
       for (int kk=0,j=jend-RADIUS+1; j<=jend; j++) for (int i=istart; i<=iend; i++) {
           top_buf_out[kk++]= IN(i,j);
       }
+      if (codec_mode == HALO_CODEC_NONE)
       MPI_Isend(top_buf_out, RADIUS*width,MPI_DTYPE, top_nbr, 99,
                 MPI_COMM_WORLD, &(request[0]));
+      else {
+        bytes = halo_encode(&codec[0], top_buf_out, RADIUS*width, sizeof(DTYPE), top_pack_out);
+        MPI_Isend(top_pack_out, bytes, MPI_BYTE, top_nbr, 99,
+                  MPI_COMM_WORLD, &(request[0]));
+      }
     }
     if (my_IDy > 0) {
+      if (codec_mode == HALO_CODEC_NONE)
       MPI_Irecv(bottom_buf_in,RADIUS*width, MPI_DTYPE, bottom_nbr, 99,
                 MPI_COMM_WORLD, &(request[3]));
+      else
+      MPI_Irecv(bottom_pack_in, pack_y, MPI_BYTE, bottom_nbr, 99,
+                MPI_COMM_WORLD, &(request[3]));
       for (int kk=0,j=jstart; j<=jstart+RADIUS-1; j++) for (int i=istart; i<=iend; i++) {
           bottom_buf_out[kk++]= IN(i,j);
       }
+      if (codec_mode == HALO_CODEC_NONE)
       MPI_Isend(bottom_buf_out, RADIUS*width,MPI_DTYPE, bottom_nbr, 101,
                 MPI_COMM_WORLD, &(request[2]));
+      else {
+        bytes = halo_encode(&codec[0], bottom_buf_out, RADIUS*width, sizeof(DTYPE), bottom_pack_out);
+        MPI_Isend(bottom_pack_out, bytes, MPI_BYTE, bottom_nbr, 101,
+                  MPI_COMM_WORLD, &(request[2]));
+      }
     }
     if (my_IDy < Num_procsy-1) {
       MPI_Wait(&(request[0]), MPI_STATUS_IGNORE);
-      MPI_Wait(&(request[1]), MPI_STATUS_IGNORE);
+      MPI_Wait(&(request[1]), &status);
+      if (codec_mode != HALO_CODEC_NONE) {
+        MPI_Get_count(&status, MPI_BYTE, &bytes);
+        halo_decode(&codec[0], top_pack_in, bytes, RADIUS*width, sizeof(DTYPE), top_buf_in);
+      }
       for (int kk=0,j=jend+1; j<=jend+RADIUS; j++) for (int i=istart; i<=iend; i++) {
           IN(i,j) = top_buf_in[kk++];
       }
     }
     if (my_IDy > 0) {
       MPI_Wait(&(request[2]), MPI_STATUS_IGNORE);
-      MPI_Wait(&(request[3]), MPI_STATUS_IGNORE);
+      MPI_Wait(&(request[3]), &status);
+      if (codec_mode != HALO_CODEC_NONE) {
+        MPI_Get_count(&status, MPI_BYTE, &bytes);
+        halo_decode(&codec[0], bottom_pack_in, bytes, RADIUS*width, sizeof(DTYPE), bottom_buf_in);
+      }
       for (int kk=0,j=jstart-RADIUS; j<=jstart-1; j++) for (int i=istart; i<=iend; i++) {
           IN(i,j) = bottom_buf_in[kk++];
       }
@@ -371,33 +460,61 @@ int main(int argc, char ** argv) {
 
     /* need to fetch ghost point data from neighbors in x-direction                 */
     if (my_IDx < Num_procsx-1) {
+      if (codec_mode == HALO_CODEC_NONE)
       MPI_Irecv(right_buf_in, RADIUS*height, MPI_DTYPE, right_nbr, 1010,
                 MPI_COMM_WORLD, &(request[1+4]));
+      else
+      MPI_Irecv(right_pack_in, pack_x, MPI_BYTE, right_nbr, 1010,
+                MPI_COMM_WORLD, &(request[1+4]));
       for (int kk=0,j=jstart; j<=jend; j++) for (int i=iend-RADIUS+1; i<=iend; i++) {
           right_buf_out[kk++]= IN(i,j);
       }
+      if (codec_mode == HALO_CODEC_NONE)
       MPI_Isend(right_buf_out, RADIUS*height, MPI_DTYPE, right_nbr, 990,
               MPI_COMM_WORLD, &(request[0+4]));
+      else {
+        bytes = halo_encode(&codec[1], right_buf_out, RADIUS*height, sizeof(DTYPE), right_pack_out);
+        MPI_Isend(right_pack_out, bytes, MPI_BYTE, right_nbr, 990,
+                  MPI_COMM_WORLD, &(request[0+4]));
+      }
     }
     if (my_IDx > 0) {
+      if (codec_mode == HALO_CODEC_NONE)
       MPI_Irecv(left_buf_in, RADIUS*height, MPI_DTYPE, left_nbr, 990,
                 MPI_COMM_WORLD, &(request[3+4]));
+      else
+      MPI_Irecv(left_pack_in, pack_x, MPI_BYTE, left_nbr, 990,
+                MPI_COMM_WORLD, &(request[3+4]));
       for (int kk=0,j=jstart; j<=jend; j++) for (int i=istart; i<=istart+RADIUS-1; i++) {
           left_buf_out[kk++]= IN(i,j);
       }
+      if (codec_mode == HALO_CODEC_NONE)
       MPI_Isend(left_buf_out, RADIUS*height, MPI_DTYPE, left_nbr, 1010,
                 MPI_COMM_WORLD, &(request[2+4]));
+      else {
+        bytes = halo_encode(&codec[1], left_buf_out, RADIUS*height, sizeof(DTYPE), left_pack_out);
+        MPI_Isend(left_pack_out, bytes, MPI_BYTE, left_nbr, 1010,
+                  MPI_COMM_WORLD, &(request[2+4]));
+      }
     }
     if (my_IDx < Num_procsx-1) {
       MPI_Wait(&(request[0+4]), MPI_STATUS_IGNORE);
-      MPI_Wait(&(request[1+4]), MPI_STATUS_IGNORE);
+      MPI_Wait(&(request[1+4]), &status);
+      if (codec_mode != HALO_CODEC_NONE) {
+        MPI_Get_count(&status, MPI_BYTE, &bytes);
+        halo_decode(&codec[1], right_pack_in, bytes, RADIUS*height, sizeof(DTYPE), right_buf_in);
+      }
       for (int kk=0,j=jstart; j<=jend; j++) for (int i=iend+1; i<=iend+RADIUS; i++) {
           IN(i,j) = right_buf_in[kk++];
       }
     }
     if (my_IDx > 0) {
       MPI_Wait(&(request[2+4]), MPI_STATUS_IGNORE);
-      MPI_Wait(&(request[3+4]), MPI_STATUS_IGNORE);
+      MPI_Wait(&(request[3+4]), &status);
+      if (codec_mode != HALO_CODEC_NONE) {
+        MPI_Get_count(&status, MPI_BYTE, &bytes);
+        halo_decode(&codec[1], left_pack_in, bytes, RADIUS*height, sizeof(DTYPE), left_buf_in);
+      }
       for (int kk=0,j=jstart; j<=jend; j++) for (int i=istart-RADIUS; i<=istart-1; i++) {
           IN(i,j) = left_buf_in[kk++];
       }
@@ -448,7 +565,14 @@ int main(int argc, char ** argv) {
     else {
       reference_norm = (DTYPE) 0.0;
     }
-    if (ABS(norm-reference_norm) > EPSILON) {
+    /* each ghost value may be off by the error bound of the lossy codec */
+    DTYPE tolerance = EPSILON;
+    if (codec_mode == HALO_CODEC_LOSSY) {
+      double sum_weights = 0.0;
+      for (int ii=1; ii<=RADIUS; ii++) sum_weights += 4.0/(2.0*ii*RADIUS);
+      tolerance += (DTYPE) ((iterations+1)*sum_weights*codec_bound);
+    }
+    if (ABS(norm-reference_norm) > tolerance) {
       printf("ERROR: L1 norm = "FSTR", Reference L1 norm = "FSTR"\n",
              norm, reference_norm);
       error = 1;
@@ -472,6 +596,36 @@ int main(int argc, char ** argv) {
            1.0E-06 * flops/avgtime, avgtime);
   }
 
+  if (codec_mode != HALO_CODEC_NONE && Num_procs > 1) {
+    /* message sizes of rank 0 in y and x, exchanged with ranks Num_procsx and 1 */
+    int peer[2]  = {Num_procsx, 1};
+    int count[2] = {RADIUS*width, RADIUS*height};
+    DTYPE *sample[2] = {top_buf_out, right_buf_out};
+    int active[2] = {Num_procsy > 1, Num_procsx > 1};
+    MPI_Bcast(count, 2, MPI_INT, root, MPI_COMM_WORLD);
+    if (my_ID == root) {
+      printf("Direction  Message (B)  Ratio  Codec (us/msg)  Raw (us)  Compressed (us)  Speedup\n");
+    }
+    for (int d=0; d<2; d++) {
+      double stats[4] = {codec[d].raw_bytes, codec[d].packed_bytes,
+                         codec[d].encode_time+codec[d].decode_time, (double) codec[d].messages};
+      double total[4];
+      double t_raw = 0.0, t_packed = 0.0;
+      MPI_Reduce(stats, total, 4, MPI_DOUBLE, MPI_SUM, root, MPI_COMM_WORLD);
+      if (!active[d]) continue;
+      if (my_ID == root || my_ID == peer[d]) {
+        halo_codec_pingpong(&codec[d], (my_ID == root) ? sample[d] : NULL, count[d], sizeof(DTYPE),
+                            (my_ID == root) ? peer[d] : root, 100, MPI_COMM_WORLD, &t_raw, &t_packed);
+      }
+      if (my_ID == root) {
+        /* every message is encoded once and decoded once */
+        printf("%9s  %11zu  %5.2lf  %14.3lf  %8.3lf  %15.3lf  %7.3lf\n", d ? "x" : "y",
+               count[d]*sizeof(DTYPE), total[0]/total[1], 1.e6*total[2]/total[3],
+               1.e6*t_raw, 1.e6*t_packed, t_raw/t_packed);
+      }
+    }
+  }
+
   MPI_Finalize();
   exit(EXIT_SUCCESS);
 }
@@ -41,10 +41,29 @@ PURPOSE: This program tests the efficiency with which a square matrix
 USAGE:   Program inputs are the matrix order, the number of times to 
          repeat the operation, and the communication mode
 
-         transpose <# iterations> <matrix order> [tile size]
+         transpose <# iterations> <matrix order> [tile size [codec [error bound
+                   [none|sync|async [aggregators]]]]]
 
          An optional parameter specifies the tile size used to divide the 
          individual matrix blocks for improved cache and TLB performance. 
+
+         The optional codec (none, lossless or lossy) compresses every
+         block before it is sent, see common/halo_codec.c.  The lossy codec
+         changes each received element by at most the error bound (default
+         1.e-6), so the tolerance of the summed error is widened by the
+         bound for every element received in every iteration.  The
+         compression ratio, the codec cost per message and the one-way
+         time of a ping-pong of one block between ranks 0 and 1 without
+         and with the codec are reported.
+
+         The optional snapshot mode writes both matrices halfway through
+         the run to the shared file transpose.snapshot with collective
+         MPI-IO, see common/snapshot.c, either blocking (sync) or
+         overlapped with the remaining iterations (async); aggregators
+         sets the number of collective buffering nodes.  After the run the
+         snapshot is read back and checked against the state of the
+         matrices at that iteration, and the write rate is reported
+         next to that of one local file per rank.
   
          The output consists of diagnostics to make sure the 
          transpose worked and timing statistics.
@@ -121,6 +140,8 @@ o The original and transposed matrices are called A and B
 
 #include <par-res-kern_general.h>
 #include <par-res-kern_mpi.h>
+#include <halo_codec.h>
+#include <snapshot.h>
 
 #define A(i,j)        A_p[(i+istart)+order*(j)]
 #define B(i,j)        B_p[(i+istart)+order*(j)]
@@ -157,6 +178,18 @@ int main(int argc, char ** argv)
   double abserr,           /* absolute error                        */
          abserr_tot;       /* aggregate absolute error              */
   double epsilon = 1.e-8;  /* error tolerance                       */
+  int codec_mode=HALO_CODEC_NONE; /* block compression               */
+  double codec_bound=1.e-6;/* error bound of lossy compression      */
+  halo_codec_t codec;      /* compression state and statistics      */
+  unsigned char *Pack_out_p=NULL, *Pack_in_p=NULL; /* compressed blocks */
+  size_t Pack_size=0;      /* capacity of a compressed block        */
+  int packed_bytes;        /* size of a received compressed block   */
+  int snapshot_mode=SNAPSHOT_NONE; /* MPI-IO snapshot of A and B     */
+  int aggregators=0;       /* collective buffering nodes, 0: default */
+  int snapshot_iter;       /* iteration after which to write it     */
+  snapshot_t snap;         /* snapshot file and statistics          */
+  double * RESTRICT Restart_p; /* matrices read from the snapshot    */
+  MPI_Status status;
   double local_trans_time, /* timing parameters                     */
          trans_time,
          avgtime;
@@ -176,9 +209,9 @@ int main(int argc, char ** argv)
     printf("Parallel Research Kernels version %s\n", PRKVERSION);
     printf("MPI matrix transpose: B = A^T\n");
 
-    if (argc != 3 && argc != 4){
-      printf("Usage: %s <# iterations> <matrix order> [Tile size]\n",
-                                                               *argv);
+    if (argc < 3 || argc > 8){
+      printf("Usage: %s <# iterations> <matrix order> [Tile size [none|lossless|lossy [error bound "
+             "[none|sync|async [aggregators]]]]]\n", *argv);
       error = 1; goto ENDOFTESTS;
     }
 
@@ -200,7 +233,29 @@ int main(int argc, char ** argv)
       error = 1; goto ENDOFTESTS;
     }
 
-    if (argc == 4) Tile_order = atoi(*++argv);
+    if (argc >= 4) Tile_order = atoi(*++argv);
+
+    if (argc >= 5 && halo_codec_parse(*++argv, &codec_mode)) {
+      printf("ERROR: codec %s is not none, lossless or lossy\n", *argv);
+      error = 1; goto ENDOFTESTS;
+    }
+
+    if (argc >= 6) codec_bound = atof(*++argv);
+    if (codec_bound <= 0.0) {
+      printf("ERROR: error bound %e must be positive\n", codec_bound);
+      error = 1; goto ENDOFTESTS;
+    }
+
+    if (argc >= 7 && snapshot_parse(*++argv, &snapshot_mode)) {
+      printf("ERROR: snapshot mode %s is not none, sync or async\n", *argv);
+      error = 1; goto ENDOFTESTS;
+    }
+
+    if (argc == 8) aggregators = atoi(*++argv);
+    if (aggregators < 0) {
+      printf("ERROR: number of aggregators %d must not be negative\n", aggregators);
+      error = 1; goto ENDOFTESTS;
+    }
 
     ENDOFTESTS:;
   }
@@ -217,12 +272,26 @@ int main(int argc, char ** argv)
     printf("Non-");
 #endif
     printf("Blocking messages\n");
+    printf("Block compression    = %s", halo_codec_name(codec_mode));
+    if (codec_mode == HALO_CODEC_LOSSY) printf(" (error bound %e)", codec_bound);
+    printf("\n");
+    printf("Snapshot             = %s", snapshot_name(snapshot_mode));
+    if (snapshot_mode != SNAPSHOT_NONE) {
+      if (aggregators > 0) printf(" (%d aggregators)", aggregators);
+      else                 printf(" (default aggregators)");
+    }
+    printf("\n");
   }
 
   /*  Broadcast input data to all ranks */
   MPI_Bcast(&order,      1, MPI_LONG, root, MPI_COMM_WORLD);
   MPI_Bcast(&iterations, 1, MPI_INT,  root, MPI_COMM_WORLD);
   MPI_Bcast(&Tile_order, 1, MPI_INT,  root, MPI_COMM_WORLD);
+  MPI_Bcast(&codec_mode, 1, MPI_INT,  root, MPI_COMM_WORLD);
+  MPI_Bcast(&codec_bound,1, MPI_DOUBLE, root, MPI_COMM_WORLD);
+  MPI_Bcast(&snapshot_mode, 1, MPI_INT, root, MPI_COMM_WORLD);
+  MPI_Bcast(&aggregators,   1, MPI_INT, root, MPI_COMM_WORLD);
+  halo_codec_init(&codec, codec_mode, codec_bound);
 
   /* a non-positive tile size means no tiling of the local transpose */
   tiling = (Tile_order > 0) && (Tile_order < order);
@@ -265,6 +334,28 @@ int main(int argc, char ** argv)
     }
     bail_out(error);
     Work_out_p = Work_in_p + Block_size;
+
+    if (codec_mode != HALO_CODEC_NONE) {
+      Pack_size  = halo_codec_max_bytes(Block_size, sizeof(double));
+      Pack_out_p = (unsigned char *)prk_malloc(2*Pack_size);
+      if (Pack_out_p == NULL){
+        printf(" Error allocating space for compressed blocks on node %d\n",my_ID);
+        error = 1;
+      }
+      bail_out(error);
+      Pack_in_p = Pack_out_p + Pack_size;
+    }
+  }
+
+  /* The file holds A and then B, each in column major order, so the column block
+     of a rank is one contiguous piece of each matrix                             */
+  snapshot_iter = iterations/2;
+  if (snapshot_mode != SNAPSHOT_NONE) {
+    int sizes[2]    = {(int) order, (int) order};
+    int subsizes[2] = {(int) Block_order, (int) order};
+    int starts[2]   = {colstart, 0};
+    snapshot_init(&snap, snapshot_mode, "transpose.snapshot", 2, sizes, subsizes, starts,
+                  2, aggregators, MPI_COMM_WORLD);
   }
 
   /* Fill the original column matrix                                                */
@@ -281,6 +372,7 @@ int main(int argc, char ** argv)
     if (iter == 1) {
       MPI_Barrier(MPI_COMM_WORLD);
       local_trans_time = wtime();
+      halo_codec_init(&codec, codec_mode, codec_bound);
     }
 
     /* do the local transpose                                                     */
@@ -307,8 +399,12 @@ int main(int argc, char ** argv)
       send_to   = (my_ID - phase + Num_procs)%Num_procs;
 
 #if !SYNCHRONOUS
+      if (codec_mode == HALO_CODEC_NONE)
       MPI_Irecv(Work_in_p, Block_size, MPI_DOUBLE,
                 recv_from, phase, MPI_COMM_WORLD, &recv_req);
+      else
+      MPI_Irecv(Pack_in_p, Pack_size, MPI_BYTE,
+                recv_from, phase, MPI_COMM_WORLD, &recv_req);
 #endif
 
       istart = send_to*Block_order;
@@ -329,6 +425,7 @@ int main(int argc, char ** argv)
 	      }
       }
 
+      if (codec_mode == HALO_CODEC_NONE) {
 #if !SYNCHRONOUS
       MPI_Isend(Work_out_p, Block_size, MPI_DOUBLE, send_to,
                 phase, MPI_COMM_WORLD, &send_req);
@@ -339,6 +436,22 @@ int main(int argc, char ** argv)
                    Work_in_p, Block_size, MPI_DOUBLE,
 	           recv_from, phase, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
 #endif
+      }
+      else {
+        int bytes = halo_encode(&codec, Work_out_p, Block_size, sizeof(double), Pack_out_p);
+#if !SYNCHRONOUS
+        MPI_Isend(Pack_out_p, bytes, MPI_BYTE, send_to,
+                  phase, MPI_COMM_WORLD, &send_req);
+        MPI_Wait(&recv_req, &status);
+        MPI_Wait(&send_req, MPI_STATUS_IGNORE);
+#else
+        MPI_Sendrecv(Pack_out_p, bytes, MPI_BYTE, send_to, phase,
+                     Pack_in_p, Pack_size, MPI_BYTE,
+                     recv_from, phase, MPI_COMM_WORLD, &status);
+#endif
+        MPI_Get_count(&status, MPI_BYTE, &packed_bytes);
+        halo_decode(&codec, Pack_in_p, packed_bytes, Block_size, sizeof(double), Work_in_p);
+      }
 
       istart = recv_from*Block_order;
       /* scatter received block to transposed matrix; no need to tile */
@@ -347,8 +460,18 @@ int main(int argc, char ** argv)
           B(i,j) += Work_in(i,j);
 
     }  /* end of phase loop  */
+
+    if (snapshot_mode != SNAPSHOT_NONE) {
+      if (iter == snapshot_iter) {
+        memcpy(snapshot_buffer(&snap),               A_p, Colblock_size*sizeof(double));
+        memcpy(snapshot_buffer(&snap)+Colblock_size, B_p, Colblock_size*sizeof(double));
+        snapshot_write(&snap);
+      }
+      else snapshot_test(&snap);
+    }
   } /* end of iterations */
 
+  if (snapshot_mode != SNAPSHOT_NONE) snapshot_wait(&snap);
   local_trans_time = wtime() - local_trans_time;
   MPI_Reduce(&local_trans_time, &trans_time, 1, MPI_DOUBLE, MPI_MAX, root,
              MPI_COMM_WORLD);
@@ -362,6 +485,11 @@ int main(int argc, char ** argv)
 
   MPI_Reduce(&abserr, &abserr_tot, 1, MPI_DOUBLE, MPI_SUM, root, MPI_COMM_WORLD);
 
+  /* every element received from another rank may be off by the error bound */
+  if (codec_mode == HALO_CODEC_LOSSY) {
+    epsilon += (iterations+1.0) * codec_bound * (double) order * (double) (order-Block_order);
+  }
+
   if (my_ID == root) {
     if (abserr_tot < epsilon) {
       printf("Solution validates\n");
@@ -379,6 +507,73 @@ int main(int argc, char ** argv)
 
   bail_out(error);
 
+  if (codec_mode != HALO_CODEC_NONE && Num_procs > 1) {
+    double stats[4] = {codec.raw_bytes, codec.packed_bytes,
+                       codec.encode_time+codec.decode_time, (double) codec.messages};
+    double total[4];
+    double t_raw = 0.0, t_packed = 0.0;
+    MPI_Reduce(stats, total, 4, MPI_DOUBLE, MPI_SUM, root, MPI_COMM_WORLD);
+    if (my_ID == root || my_ID == 1) {
+      halo_codec_pingpong(&codec, (my_ID == root) ? Work_out_p : NULL, Block_size, sizeof(double),
+                          1-my_ID, 100, MPI_COMM_WORLD, &t_raw, &t_packed);
+    }
+    if (my_ID == root) {
+      /* every block is encoded once and decoded once */
+      printf("Message (B)  Ratio  Codec (us/msg)  Raw (us)  Compressed (us)  Speedup\n");
+      printf("%11ld  %5.2lf  %14.3lf  %8.3lf  %15.3lf  %7.3lf\n",
+             Block_size*(long)sizeof(double), total[0]/total[1], 1.e6*total[2]/total[3],
+             1.e6*t_raw, 1.e6*t_packed, t_raw/t_packed);
+    }
+  }
+
+  if (snapshot_mode != SNAPSHOT_NONE) {
+    double times[2] = {snap.write_time, snap.exposed_time}, max_times[2];
+    double t_local = snapshot_write_local(&snap);
+    MPI_Reduce(times, max_times, 2, MPI_DOUBLE, MPI_MAX, root, MPI_COMM_WORLD);
+
+    /* restart: read the snapshot into a separate buffer, not the one that was
+       written, and check the matrices against the state after iteration
+       snapshot_iter                                                              */
+    Restart_p = (double *)prk_malloc(2*Colblock_size*sizeof(double));
+    if (Restart_p == NULL){
+      printf(" Error allocating space for restart on node %d\n",my_ID);
+      error = 1;
+    }
+    bail_out(error);
+    snapshot_read(&snap, Restart_p);
+    memcpy(A_p, Restart_p,               Colblock_size*sizeof(double));
+    memcpy(B_p, Restart_p+Colblock_size, Colblock_size*sizeof(double));
+    prk_free(Restart_p);
+
+    abserr = 0.0;
+    istart = 0;
+    addit  = ((double)(snapshot_iter+1) * (double) (snapshot_iter))/2.0;
+    for (j=0;j<Block_order;j++) for (i=0;i<order; i++) {
+      abserr += ABS(A(i,j) - (double)(order*(j+colstart) + i + snapshot_iter+1));
+      abserr += ABS(B(i,j) - (double)((order*i + j+colstart)*(snapshot_iter+1)+addit));
+    }
+    MPI_Reduce(&abserr, &abserr_tot, 1, MPI_DOUBLE, MPI_SUM, root, MPI_COMM_WORLD);
+
+    epsilon = 1.e-8;
+    if (codec_mode == HALO_CODEC_LOSSY) {
+      epsilon += (snapshot_iter+1.0) * codec_bound * (double) order * (double) (order-Block_order);
+    }
+
+    if (my_ID == root) {
+      if (abserr_tot < epsilon) {
+        printf("Restart from iteration %d validates\n", snapshot_iter);
+        printf("Snapshot (GB/s): %lf Local files (GB/s): %lf Exposed time (s): %lf\n",
+               1.e-9*snap.bytes/max_times[0], 1.e-9*snap.bytes/t_local, max_times[1]);
+      }
+      else {
+        printf("ERROR: restart error %lf exceeds threshold %e\n", abserr_tot, epsilon);
+        error = 1;
+      }
+    }
+    bail_out(error);
+    snapshot_free(&snap);
+  }
+
   MPI_Finalize();
   exit(EXIT_SUCCESS);
 
@@ -0,0 +1,362 @@
+/*
+Copyright (c) 2015, Intel Corporation
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************
+
+Name:      halo_codec
+
+Purpose:   Compress messages of floating point words on the send path of
+           the MPI kernels, for networks that are slower than the cores.
+
+Functions: halo_codec_parse:    translate none/lossless/lossy into a mode
+           halo_codec_init:     set mode and error bound, clear statistics
+           halo_codec_max_bytes: size of a receive buffer for any message
+           halo_encode:         compress count words of 4 or 8 bytes
+           halo_decode:         restore them
+           halo_codec_pingpong: time one-way raw and compressed messages
+
+Notes:     Lossless mode replaces each word by its XOR with the previous
+           one, which zeroes the sign, exponent and leading mantissa bits
+           shared by neighboring values.  Lossy mode rounds each value to
+           the nearest multiple of twice the error bound and replaces the
+           integer multiple by its (zigzag-coded) difference with the
+           previous one, so the error of every value is at most the bound.
+           Values too large to quantize fall back to lossless mode.
+
+           Either way, the words are shuffled into byte planes (all first
+           bytes, then all second bytes, ...), so the zero bytes gather in
+           the high planes, and every plane is packed without entropy
+           coding: an all-zero plane costs one byte, other planes store a
+           mask per group of eight bytes followed by the nonzero bytes, or
+           are copied if that is not smaller.
+
+           The first byte of a message is the transform (0: XOR, 1:
+           quantized); each plane starts with its packing (0: zero, 1:
+           masked, 2: copied).  The receiver knows count and word size.
+
+History:   Written for the halo compression option of the MPI1 Stencil
+           and Transpose kernels.
+
+**********************************************************************/
+
+#include <halo_codec.h>
+
+#define PLANE_ZERO   0
+#define PLANE_MASKED 1
+#define PLANE_COPIED 2
+
+int halo_codec_parse(const char *s, int *mode) {
+  if      (!strcmp(s,"none"))     *mode = HALO_CODEC_NONE;
+  else if (!strcmp(s,"lossless")) *mode = HALO_CODEC_LOSSLESS;
+  else if (!strcmp(s,"lossy"))    *mode = HALO_CODEC_LOSSY;
+  else return 1;
+  return 0;
+}
+
+const char *halo_codec_name(int mode) {
+  switch (mode) {
+    case HALO_CODEC_LOSSLESS: return "lossless";
+    case HALO_CODEC_LOSSY:    return "lossy";
+    default:                  return "none";
+  }
+}
+
+void halo_codec_init(halo_codec_t *c, int mode, double bound) {
+  c->mode         = mode;
+  c->bound        = bound;
+  c->scratch      = NULL;
+  c->scratch_size = 0;
+  c->messages     = 0;
+  c->raw_bytes    = c->packed_bytes = 0.0;
+  c->encode_time  = c->decode_time  = 0.0;
+}
+
+void halo_codec_free(halo_codec_t *c) {
+  prk_free(c->scratch);
+  c->scratch      = NULL;
+  c->scratch_size = 0;
+}
+
+size_t halo_codec_max_bytes(size_t count, size_t word) {
+  return 1 + word*(1+count);
+}
+
+static unsigned char *scratch(halo_codec_t *c, size_t bytes) {
+  if (bytes > c->scratch_size) {
+    prk_free(c->scratch);
+    c->scratch = (unsigned char *) prk_malloc(bytes);
+    if (!c->scratch) {
+      printf("ERROR: could not allocate %zu bytes for halo codec\n", bytes);
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    c->scratch_size = bytes;
+  }
+  return c->scratch;
+}
+
+static inline uint64_t load_bits(const void *src, size_t k, size_t word) {
+  uint64_t u;
+  if (word == 8) memcpy(&u, (const char *)src + 8*k, 8);
+  else { uint32_t v; memcpy(&v, (const char *)src + 4*k, 4); u = v; }
+  return u;
+}
+
+static inline void store_bits(void *dst, size_t k, size_t word, uint64_t u) {
+  if (word == 8) memcpy((char *)dst + 8*k, &u, 8);
+  else { uint32_t v = (uint32_t) u; memcpy((char *)dst + 4*k, &v, 4); }
+}
+
+static inline double load_value(const void *src, size_t k, size_t word) {
+  return (word == 8) ? ((const double *)src)[k] : (double) ((const float *)src)[k];
+}
+
+static inline void store_value(void *dst, size_t k, size_t word, double x) {
+  if (word == 8) ((double *)dst)[k] = x;
+  else           ((float *)dst)[k]  = (float) x;
+}
+
+/* quantize and shuffle; returns 0 if a value is too large to quantize */
+static int quantize(const void *src, size_t count, size_t word, double bound,
+                    unsigned char * RESTRICT planes) {
+  const double inv   = 1.0/(2.0*bound);
+  const double limit = ldexp(1.0, 8*(int)word-3);
+  int64_t prev = 0;
+  for (size_t k=0; k<count; k++) {
+    const double y = load_value(src,k,word)*inv;
+    if (!(ABS(y) < limit)) return 0;
+    const int64_t q = (int64_t) floor(y+0.5);
+    const int64_t d = q - prev;
+    const uint64_t v = ((uint64_t) d << 1) ^ (uint64_t) (d >> 63);
+    prev = q;
+    for (size_t b=0; b<word; b++) planes[b*count+k] = (unsigned char) (v >> (8*b));
+  }
+  return 1;
+}
+
+static void xor_delta(const void *src, size_t count, size_t word,
+                      unsigned char * RESTRICT planes) {
+  uint64_t prev = 0;
+  for (size_t k=0; k<count; k++) {
+    const uint64_t u = load_bits(src,k,word);
+    const uint64_t v = u ^ prev;
+    prev = u;
+    for (size_t b=0; b<word; b++) planes[b*count+k] = (unsigned char) (v >> (8*b));
+  }
+}
+
+static void dequantize(const unsigned char * RESTRICT planes, size_t count, size_t word,
+                       double bound, void *dst) {
+  const double step = 2.0*bound;
+  int64_t q = 0;
+  for (size_t k=0; k<count; k++) {
+    uint64_t v = 0;
+    for (size_t b=0; b<word; b++) v |= (uint64_t) planes[b*count+k] << (8*b);
+    q += (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+    store_value(dst, k, word, (double) q * step);
+  }
+}
+
+static void xor_restore(const unsigned char * RESTRICT planes, size_t count, size_t word,
+                        void *dst) {
+  uint64_t u = 0;
+  for (size_t k=0; k<count; k++) {
+    uint64_t v = 0;
+    for (size_t b=0; b<word; b++) v |= (uint64_t) planes[b*count+k] << (8*b);
+    u ^= v;
+    store_bits(dst, k, word, u);
+  }
+}
+
+static size_t pack_plane(const unsigned char * RESTRICT p, size_t count,
+                         unsigned char * RESTRICT dst) {
+  size_t nonzero = 0;
+  for (size_t k=0; k<count; k++) nonzero += (p[k] != 0);
+  if (nonzero == 0) {
+    dst[0] = PLANE_ZERO;
+    return 1;
+  }
+  if (nonzero + (count+7)/8 >= count) {
+    dst[0] = PLANE_COPIED;
+    memcpy(dst+1, p, count);
+    return 1+count;
+  }
+  dst[0] = PLANE_MASKED;
+  size_t out = 1;
+  for (size_t k=0; k<count; k+=8) {
+    const size_t m = MIN(8,count-k);
+    unsigned char mask = 0;
+    size_t pos = out++;
+    for (size_t l=0; l<m; l++) {
+      if (p[k+l]) {
+        mask |= (unsigned char) (1u << l);
+        dst[out++] = p[k+l];
+      }
+    }
+    dst[pos] = mask;
+  }
+  return out;
+}
+
+static size_t unpack_plane(const unsigned char * RESTRICT src, size_t count,
+                           unsigned char * RESTRICT p) {
+  if (src[0] == PLANE_ZERO) {
+    memset(p, 0, count);
+    return 1;
+  }
+  if (src[0] == PLANE_COPIED) {
+    memcpy(p, src+1, count);
+    return 1+count;
+  }
+  size_t in = 1;
+  for (size_t k=0; k<count; k+=8) {
+    const size_t m = MIN(8,count-k);
+    const unsigned char mask = src[in++];
+    for (size_t l=0; l<m; l++) {
+      p[k+l] = ((mask >> l) & 1) ? src[in++] : 0;
+    }
+  }
+  return in;
+}
+
+size_t halo_encode(halo_codec_t *c, const void *src, size_t count, size_t word,
+                   unsigned char *dst) {
+  const double t0 = MPI_Wtime();
+  unsigned char *planes = scratch(c, count*word);
+  /* constant word sizes let the compiler specialize the transforms */
+  int quantized = 0;
+  if (c->mode == HALO_CODEC_LOSSY) {
+    quantized = (word == 8) ? quantize(src, count, 8, c->bound, planes)
+                            : quantize(src, count, 4, c->bound, planes);
+  }
+  if (!quantized) {
+    if (word == 8) xor_delta(src, count, 8, planes);
+    else           xor_delta(src, count, 4, planes);
+  }
+
+  size_t bytes = 1;
+  dst[0] = (unsigned char) quantized;
+  for (size_t b=0; b<word; b++) bytes += pack_plane(planes + b*count, count, dst+bytes);
+
+  c->encode_time  += MPI_Wtime() - t0;
+  c->messages     += 1;
+  c->raw_bytes    += (double) (count*word);
+  c->packed_bytes += (double) bytes;
+  return bytes;
+}
+
+void halo_decode(halo_codec_t *c, const unsigned char *src, size_t bytes, size_t count,
+                 size_t word, void *dst) {
+  const double t0 = MPI_Wtime();
+  unsigned char *planes = scratch(c, count*word);
+  size_t in = 1;
+  for (size_t b=0; b<word; b++) in += unpack_plane(src+in, count, planes + b*count);
+  if (in != bytes) {
+    printf("ERROR: halo message of %zu bytes decoded from %zu bytes\n", bytes, in);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
+  if (src[0]) {
+    if (word == 8) dequantize(planes, count, 8, c->bound, dst);
+    else           dequantize(planes, count, 4, c->bound, dst);
+  }
+  else {
+    if (word == 8) xor_restore(planes, count, 8, dst);
+    else           xor_restore(planes, count, 4, dst);
+  }
+  c->decode_time += MPI_Wtime() - t0;
+}
+
+/* Times reps round trips of count words between the calling rank and peer,
+   raw and through the codec, and returns the one-way times.  Both ranks
+   call it, the responder with a NULL sample; the codec statistics are left
+   unchanged.                                                              */
+void halo_codec_pingpong(halo_codec_t *c, const void *sample, size_t count, size_t word,
+                         int peer, int reps, MPI_Comm comm, double *t_raw, double *t_packed) {
+  int me;
+  MPI_Comm_rank(comm, &me);
+  const size_t max_bytes = halo_codec_max_bytes(count, word);
+  unsigned char *raw    = (unsigned char *) prk_malloc(count*word);
+  unsigned char *packed = (unsigned char *) prk_malloc(max_bytes);
+  if (!raw || !packed) {
+    printf("ERROR: could not allocate ping-pong buffers\n");
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+  halo_codec_t saved = *c;
+  const int first = me < peer;
+  MPI_Status status;
+  int bytes;
+
+  if (sample) memcpy(raw, sample, count*word);
+  else        memset(raw, 0, count*word);
+  MPI_Sendrecv(NULL, 0, MPI_BYTE, peer, 76, NULL, 0, MPI_BYTE, peer, 76, comm, MPI_STATUS_IGNORE);
+  double t0 = MPI_Wtime();
+  for (int r=0; r<reps; r++) {
+    if (first) {
+      MPI_Send(raw, (int)(count*word), MPI_BYTE, peer, 77, comm);
+      MPI_Recv(raw, (int)(count*word), MPI_BYTE, peer, 77, comm, MPI_STATUS_IGNORE);
+    }
+    else {
+      MPI_Recv(raw, (int)(count*word), MPI_BYTE, peer, 77, comm, MPI_STATUS_IGNORE);
+      MPI_Send(raw, (int)(count*word), MPI_BYTE, peer, 77, comm);
+    }
+  }
+  *t_raw = (MPI_Wtime() - t0)/(2.0*reps);
+
+  if (sample) memcpy(raw, sample, count*word);
+  else        memset(raw, 0, count*word);
+  MPI_Sendrecv(NULL, 0, MPI_BYTE, peer, 76, NULL, 0, MPI_BYTE, peer, 76, comm, MPI_STATUS_IGNORE);
+  t0 = MPI_Wtime();
+  for (int r=0; r<reps; r++) {
+    if (first) {
+      bytes = (int) halo_encode(c, raw, count, word, packed);
+      MPI_Send(packed, bytes, MPI_BYTE, peer, 78, comm);
+      MPI_Recv(packed, (int) max_bytes, MPI_BYTE, peer, 78, comm, &status);
+      MPI_Get_count(&status, MPI_BYTE, &bytes);
+      halo_decode(c, packed, (size_t) bytes, count, word, raw);
+    }
+    else {
+      MPI_Recv(packed, (int) max_bytes, MPI_BYTE, peer, 78, comm, &status);
+      MPI_Get_count(&status, MPI_BYTE, &bytes);
+      halo_decode(c, packed, (size_t) bytes, count, word, raw);
+      bytes = (int) halo_encode(c, raw, count, word, packed);
+      MPI_Send(packed, bytes, MPI_BYTE, peer, 78, comm);
+    }
+  }
+  *t_packed = (MPI_Wtime() - t0)/(2.0*reps);
+
+  /* keep the scratch buffer, restore the statistics */
+  saved.scratch      = c->scratch;
+  saved.scratch_size = c->scratch_size;
+  *c = saved;
+  prk_free(raw);
+  prk_free(packed);
+}
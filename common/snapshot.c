@@ -0,0 +1,251 @@
+/*
+Copyright (c) 2015, Intel Corporation
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************
+
+Name:      snapshot
+
+Purpose:   Write the distributed state of the MPI kernels to one shared
+           file with MPI-IO, and read it back for a restart.
+
+Functions: snapshot_parse:   translate none/sync/async into a mode
+           snapshot_init:    describe the fields and the owned subarray
+           snapshot_buffer:  where the caller packs its owned fields
+           snapshot_write:   write the buffer (sync) or start writing it
+                             (async)
+           snapshot_test:    progress an asynchronous write
+           snapshot_wait:    complete an asynchronous write
+           snapshot_read:    read the owned fields of the file, which must
+                             not be the buffer of the write
+           snapshot_write_local: write the buffer to one local file per
+                             rank, for comparison
+           snapshot_free:    remove the files and release the buffer
+
+Notes:     The file holds every field of the global array in its natural
+           order, one field after another and without a header, so it can
+           be read back with any decomposition.  Each rank sets a file
+           view of its subarray of every field and the ranks write with
+           one collective call, which lets MPI-IO aggregate the small
+           pieces into large contiguous requests (two-phase I/O).  The
+           number of aggregators is passed as the reserved cb_nodes hint.
+
+           An asynchronous write uses MPI_File_iwrite_all from the buffer,
+           so the caller may keep updating its arrays; the buffer must not
+           be repacked before snapshot_wait.  The write time is measured
+           from start to completion; the exposed time only counts the
+           calls that start, progress and complete the write.
+
+History:   Written for the snapshot option of the MPI1 Transpose kernel.
+
+**********************************************************************/
+
+#include <snapshot.h>
+
+int snapshot_parse(const char *s, int *mode) {
+  if      (!strcmp(s,"none"))  *mode = SNAPSHOT_NONE;
+  else if (!strcmp(s,"sync"))  *mode = SNAPSHOT_SYNC;
+  else if (!strcmp(s,"async")) *mode = SNAPSHOT_ASYNC;
+  else return 1;
+  return 0;
+}
+
+const char *snapshot_name(int mode) {
+  switch (mode) {
+    case SNAPSHOT_SYNC:  return "sync";
+    case SNAPSHOT_ASYNC: return "async";
+    default:             return "none";
+  }
+}
+
+void snapshot_init(snapshot_t *s, int mode, const char *name, int ndims, const int *sizes,
+                   const int *subsizes, const int *starts, int fields, int aggregators,
+                   MPI_Comm comm) {
+  MPI_Datatype field;
+  MPI_Aint     lb, extent;
+  char         value[32];
+  int          d;
+
+  s->mode    = mode;
+  s->comm    = comm;
+  s->pending = 0;
+  s->start   = s->write_time = s->exposed_time = 0.0;
+  snprintf(s->name, sizeof(s->name), "%s", name);
+
+  s->count = fields;
+  s->bytes = fields * sizeof(double);
+  for (d=0; d<ndims; d++) {
+    s->count *= subsizes[d];
+    s->bytes *= (double) sizes[d];
+  }
+  s->buffer = (double *) prk_malloc(s->count*sizeof(double));
+  if (!s->buffer && s->count > 0) {
+    printf("ERROR: could not allocate %ld doubles for snapshot\n", s->count);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
+  /* the subarray spans a whole field, so consecutive copies tile the fields */
+  MPI_Type_create_subarray(ndims, sizes, subsizes, starts, MPI_ORDER_C, MPI_DOUBLE, &field);
+  MPI_Type_get_extent(field, &lb, &extent);
+  MPI_Type_create_hvector(fields, 1, extent, field, &s->filetype);
+  MPI_Type_commit(&s->filetype);
+  MPI_Type_free(&field);
+
+  MPI_Info_create(&s->info);
+  MPI_Info_set(s->info, "collective_buffering", "true");
+  MPI_Info_set(s->info, "romio_cb_write", "enable");
+  MPI_Info_set(s->info, "romio_cb_read", "enable");
+  if (aggregators > 0) {
+    snprintf(value, sizeof(value), "%d", aggregators);
+    MPI_Info_set(s->info, "cb_nodes", value);
+  }
+}
+
+double *snapshot_buffer(snapshot_t *s) {
+  return s->buffer;
+}
+
+/* file handles return errors by default, so every MPI-IO call is checked */
+static void snapshot_check(const snapshot_t *s, int err, const char *what) {
+  char message[MPI_MAX_ERROR_STRING];
+  int  length;
+  if (err == MPI_SUCCESS) return;
+  MPI_Error_string(err, message, &length);
+  printf("ERROR: %s of snapshot file %s failed: %s\n", what, s->name, message);
+  MPI_Abort(MPI_COMM_WORLD, 1);
+}
+
+static void snapshot_check_count(const snapshot_t *s, MPI_Status *status, const char *what) {
+  int count;
+  MPI_Get_count(status, MPI_DOUBLE, &count);
+  if (count != s->count) {
+    printf("ERROR: %s of snapshot file %s transferred %d of %ld doubles\n",
+           what, s->name, count, s->count);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+}
+
+static void snapshot_open(snapshot_t *s, int amode) {
+  snapshot_check(s, MPI_File_open(s->comm, s->name, amode, s->info, &s->fh), "open");
+  snapshot_check(s, MPI_File_set_view(s->fh, 0, MPI_DOUBLE, s->filetype, "native", s->info),
+                 "set view");
+}
+
+void snapshot_write(snapshot_t *s) {
+  MPI_Status status;
+  double t0 = MPI_Wtime();
+  s->start = t0;
+  snapshot_open(s, MPI_MODE_CREATE | MPI_MODE_WRONLY);
+  if (s->mode == SNAPSHOT_ASYNC) {
+    snapshot_check(s, MPI_File_iwrite_all(s->fh, s->buffer, (int) s->count, MPI_DOUBLE, &s->request),
+                   "write");
+    s->pending      = 1;
+    s->exposed_time = MPI_Wtime() - t0;
+  }
+  else {
+    snapshot_check(s, MPI_File_write_all(s->fh, s->buffer, (int) s->count, MPI_DOUBLE, &status),
+                   "write");
+    snapshot_check_count(s, &status, "write");
+    snapshot_check(s, MPI_File_close(&s->fh), "close");
+    s->write_time = s->exposed_time = MPI_Wtime() - t0;
+  }
+}
+
+/* the status of a completed write is only returned once, by test or by wait */
+void snapshot_test(snapshot_t *s) {
+  MPI_Status status;
+  int done;
+  if (!s->pending || s->request == MPI_REQUEST_NULL) return;
+  double t0 = MPI_Wtime();
+  snapshot_check(s, MPI_Test(&s->request, &done, &status), "write");
+  if (done) snapshot_check_count(s, &status, "write");
+  s->exposed_time += MPI_Wtime() - t0;
+}
+
+void snapshot_wait(snapshot_t *s) {
+  MPI_Status status;
+  if (!s->pending) return;
+  double t0 = MPI_Wtime();
+  if (s->request != MPI_REQUEST_NULL) {
+    snapshot_check(s, MPI_Wait(&s->request, &status), "write");
+    snapshot_check_count(s, &status, "write");
+  }
+  snapshot_check(s, MPI_File_close(&s->fh), "close");
+  double t1 = MPI_Wtime();
+  s->exposed_time += t1 - t0;
+  s->write_time    = t1 - s->start;
+  s->pending       = 0;
+}
+
+/* data is filled with NaNs first, so anything the read misses fails validation */
+void snapshot_read(snapshot_t *s, double *data) {
+  MPI_Status status;
+  memset(data, 0xff, s->count*sizeof(double));
+  snapshot_open(s, MPI_MODE_RDONLY);
+  snapshot_check(s, MPI_File_read_all(s->fh, data, (int) s->count, MPI_DOUBLE, &status), "read");
+  snapshot_check_count(s, &status, "read");
+  snapshot_check(s, MPI_File_close(&s->fh), "close");
+}
+
+double snapshot_write_local(snapshot_t *s) {
+  char   name[300];
+  int    me, error = 0;
+  double t, t_max;
+  FILE  *f;
+
+  MPI_Comm_rank(s->comm, &me);
+  snprintf(name, sizeof(name), "%s.%d", s->name, me);
+  MPI_Barrier(s->comm);
+  t = MPI_Wtime();
+  f = fopen(name, "wb");
+  if (!f || fwrite(s->buffer, sizeof(double), s->count, f) != (size_t) s->count) error = 1;
+  if (f && fclose(f)) error = 1;
+  t = MPI_Wtime() - t;
+  remove(name);
+  if (error) {
+    printf("ERROR: could not write local file %s\n", name);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+  MPI_Allreduce(&t, &t_max, 1, MPI_DOUBLE, MPI_MAX, s->comm);
+  return t_max;
+}
+
+void snapshot_free(snapshot_t *s) {
+  int me;
+  snapshot_wait(s);
+  MPI_Comm_rank(s->comm, &me);
+  MPI_Barrier(s->comm);
+  if (me == 0) snapshot_check(s, MPI_File_delete(s->name, MPI_INFO_NULL), "delete");
+  MPI_Type_free(&s->filetype);
+  MPI_Info_free(&s->info);
+  prk_free(s->buffer);
+  s->buffer = NULL;
+}
@@ -0,0 +1,64 @@
+/*
+Copyright (c) 2015, Intel Corporation
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef HALO_CODEC_H
+#define HALO_CODEC_H
+
+#include "par-res-kern_general.h"
+#include <mpi.h>
+
+#define HALO_CODEC_NONE     0
+#define HALO_CODEC_LOSSLESS 1
+#define HALO_CODEC_LOSSY    2
+
+typedef struct {
+  int            mode;         /* HALO_CODEC_NONE, _LOSSLESS or _LOSSY         */
+  double         bound;        /* absolute error bound of lossy mode           */
+  unsigned char *scratch;      /* shuffled words                               */
+  size_t         scratch_size;
+  /* statistics, accumulated by encode/decode                                  */
+  long           messages;
+  double         raw_bytes, packed_bytes;
+  double         encode_time, decode_time;
+} halo_codec_t;
+
+extern int    halo_codec_parse(const char *, int *);
+extern const char *halo_codec_name(int);
+extern void   halo_codec_init(halo_codec_t *, int, double);
+extern void   halo_codec_free(halo_codec_t *);
+extern size_t halo_codec_max_bytes(size_t, size_t);
+extern size_t halo_encode(halo_codec_t *, const void *, size_t, size_t, unsigned char *);
+extern void   halo_decode(halo_codec_t *, const unsigned char *, size_t, size_t, size_t, void *);
+extern void   halo_codec_pingpong(halo_codec_t *, const void *, size_t, size_t,
+                                  int, int, MPI_Comm, double *, double *);
+
+#endif /* HALO_CODEC_H */
@@ -0,0 +1,71 @@
+/*
+Copyright (c) 2015, Intel Corporation
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions 
+are met:
+
+* Redistributions of source code must retain the above copyright 
+      notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above 
+      copyright notice, this list of conditions and the following 
+      disclaimer in the documentation and/or other materials provided 
+      with the distribution.
+* Neither the name of Intel Corporation nor the names of its 
+      contributors may be used to endorse or promote products 
+      derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "par-res-kern_general.h"
+#include <mpi.h>
+
+#define SNAPSHOT_NONE  0
+#define SNAPSHOT_SYNC  1
+#define SNAPSHOT_ASYNC 2
+
+typedef struct {
+  int          mode;           /* SNAPSHOT_NONE, _SYNC or _ASYNC               */
+  char         name[256];      /* shared file; rank-local files append .rank   */
+  MPI_Comm     comm;
+  MPI_Info     info;           /* collective buffering hints                   */
+  MPI_Datatype filetype;       /* this rank's subarray of every field          */
+  MPI_File     fh;
+  MPI_Request  request;
+  int          pending;        /* an asynchronous write is in flight           */
+  long         count;          /* local doubles of all fields                  */
+  double      *buffer;         /* fields packed one after another              */
+  double       bytes;          /* global bytes of all fields                   */
+  /* statistics of the last write                                              */
+  double       start, write_time, exposed_time;
+} snapshot_t;
+
+extern int    snapshot_parse(const char *, int *);
+extern const char *snapshot_name(int);
+extern void   snapshot_init(snapshot_t *, int, const char *, int, const int *, const int *,
+                            const int *, int, int, MPI_Comm);
+extern double *snapshot_buffer(snapshot_t *);
+extern void   snapshot_write(snapshot_t *);
+extern void   snapshot_test(snapshot_t *);
+extern void   snapshot_wait(snapshot_t *);
+extern void   snapshot_read(snapshot_t *, double *);
+extern double snapshot_write_local(snapshot_t *);
+extern void   snapshot_free(snapshot_t *);
+
+#endif /* SNAPSHOT_H */
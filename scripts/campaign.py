@@ -0,0 +1,432 @@
+#!/usr/bin/env python3
+#
+# Benchmark campaigns for the Parallel Research Kernels.
+#
+# A campaign is a JSON file that lists experiments.  Each experiment is a
+# command template that is expanded over sizes and thread (or process)
+# counts and run a number of times.  Every run is parsed for the
+# "Solution validates" and "Rate (<unit>): <value>" lines the kernels
+# print, and stored together with a fingerprint of the machine and build.
+#
+#   campaign.py run     <campaign.json> [--store results.jsonl] [--tag TAG]
+#   campaign.py compare --baseline TAG --candidate TAG [--store ...] [--alpha 0.05]
+#   campaign.py plot    [--tag TAG] [--store ...] [--outdir plots]
+#   campaign.py list    [--store ...]
+#
+# The store is JSON lines, or SQLite if its name ends in .db or .sqlite.
+# A tag names one execution of a campaign; it defaults to the campaign
+# name, the short git SHA and a time stamp.
+#
+# compare groups the runs of both tags by kernel, backend, size and thread
+# count and applies a one-sided Mann-Whitney U test to the rates: a group
+# is a regression if the candidate is slower with p < alpha and the median
+# rate dropped by more than --threshold (default 2%).  The exit code is 1
+# if there is any regression, so it can gate CI jobs.  With n1 and n2 runs
+# the smallest possible p is 1/C(n1+n2,n1), so 5 runs per side are needed
+# for alpha = 0.05 (3 runs give exactly 0.05); groups that cannot reach
+# alpha are marked and counted in a warning.
+#
+# plot draws rate versus threads for every kernel, backend and size, with
+# matplotlib if it is installed and as CSV files otherwise.
+#
+# Campaign format (see scripts/campaign/*.json):
+#
+#   { "name": "small",
+#     "reps": 5,                          # runs per point
+#     "threads": [1, 2, 4],               # default thread counts
+#     "vars": { "mpirun": "mpirun" },     # extra substitutions
+#     "env": { "OMP_PROC_BIND": "close" },
+#     "experiments": [
+#       { "kernel": "nstream", "backend": "OPENMP",
+#         "command": "OPENMP/Nstream/nstream {threads} {iters} {size} 0",
+#         "iters": 10, "sizes": [2000000] },
+#       { "kernel": "stencil", "backend": "Cxx11-openmp",
+#         "command": "Cxx11/stencil-openmp {iters} {size}",
+#         "env": { "OMP_NUM_THREADS": "{threads}" },
+#         "iters": 10, "sizes": [1000, 4000] } ] }
+#
+# "{size}" may stand for several arguments, e.g. "1000 100".  An experiment
+# can override reps, threads, env and vars.  Commands run from the root of
+# the repository.
+
+import argparse
+import datetime
+import json
+import math
+import os
+import platform
+import re
+import shlex
+import sqlite3
+import subprocess
+import sys
+import time
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), '..'))
+
+RATE_RE = re.compile(r'Rate\s*\(([^)]*)\)\s*:\s*([-+0-9.eE]+)')
+TIME_RE = re.compile(r'Avg time \(s\)\s*:\s*([-+0-9.eE]+)')
+ENERGY_RE = re.compile(r'Energy \(J/iter\)\s*:\s*([-+0-9.eE]+)')
+
+#########################################################################
+# machine and build fingerprint
+#########################################################################
+
+def _run(cmd):
+    try:
+        return subprocess.run(cmd, shell=True, cwd=ROOT, capture_output=True,
+                              text=True, timeout=30).stdout.strip()
+    except (OSError, subprocess.SubprocessError):
+        return ''
+
+def cpu_model():
+    try:
+        with open('/proc/cpuinfo') as f:
+            for line in f:
+                if line.startswith('model name'):
+                    return line.split(':', 1)[1].strip()
+    except OSError:
+        pass
+    model = _run('sysctl -n machdep.cpu.brand_string')
+    return model or platform.processor() or platform.machine()
+
+def make_defs():
+    # compilers and flags as configured in common/make.defs
+    defs = {}
+    try:
+        with open(os.path.join(ROOT, 'common', 'make.defs')) as f:
+            for line in f:
+                m = re.match(r'^\s*([A-Za-z_]+)\s*=\s*(.*?)\s*$', line)
+                if m and m.group(1) in ('CC', 'CXX', 'FC', 'MPICC', 'MPICXX',
+                                        'DEFAULT_OPT_FLAGS', 'OPENMPFLAG'):
+                    defs[m.group(1)] = m.group(2)
+    except OSError:
+        pass
+    # expand references such as ${VERSION} like make would
+    ref = re.compile(r'\$[({]([A-Za-z_]+)[)}]')
+    for k, v in defs.items():
+        defs[k] = ref.sub(lambda m: defs.get(m.group(1), os.environ.get(m.group(1), '')), v)
+    return defs
+
+def fingerprint():
+    defs = make_defs()
+    cxx = defs.get('CXX', 'c++').split()
+    sha = _run('git rev-parse HEAD')
+    dirty = _run('git status --porcelain --untracked-files=no')
+    return {
+        'host':      platform.node(),
+        'cpu':       cpu_model(),
+        'ncpu':      os.cpu_count(),
+        'os':        platform.system(),
+        'kernel':    platform.release(),
+        'compiler':  _run(shlex.join(cxx[:1] + ['--version'])).split('\n')[0] if cxx else '',
+        'make_defs': defs,
+        'git_sha':   sha + ('-dirty' if dirty else ''),
+    }
+
+#########################################################################
+# results store
+#########################################################################
+
+class Store:
+
+    def __init__(self, path):
+        self.path = path
+        self.sql = path.endswith('.db') or path.endswith('.sqlite')
+        if self.sql:
+            self.db = sqlite3.connect(path)
+            self.db.execute('CREATE TABLE IF NOT EXISTS runs (tag TEXT, time TEXT, kernel TEXT, '
+                            'backend TEXT, size TEXT, threads INTEGER, rep INTEGER, command TEXT, '
+                            'ok INTEGER, unit TEXT, rate REAL, avgtime REAL, energy REAL, '
+                            'fingerprint TEXT)')
+
+    def add(self, rec):
+        if self.sql:
+            self.db.execute('INSERT INTO runs VALUES (?,?,?,?,?,?,?,?,?,?,?,?,?,?)',
+                            (rec['tag'], rec['time'], rec['kernel'], rec['backend'], rec['size'],
+                             rec['threads'], rec['rep'], rec['command'], int(rec['ok']), rec['unit'],
+                             rec['rate'], rec['avgtime'], rec['energy'],
+                             json.dumps(rec['fingerprint'], sort_keys=True)))
+            self.db.commit()
+        else:
+            with open(self.path, 'a') as f:
+                f.write(json.dumps(rec, sort_keys=True) + '\n')
+
+    def records(self, tag=None):
+        recs = []
+        if self.sql:
+            cur = self.db.execute('SELECT * FROM runs')
+            names = [d[0] for d in cur.description]
+            for row in cur:
+                rec = dict(zip(names, row))
+                rec['ok'] = bool(rec['ok'])
+                rec['fingerprint'] = json.loads(rec['fingerprint'])
+                recs.append(rec)
+        elif os.path.exists(self.path):
+            with open(self.path) as f:
+                recs = [json.loads(line) for line in f if line.strip()]
+        return [r for r in recs if tag is None or r['tag'] == tag]
+
+#########################################################################
+# running a campaign
+#########################################################################
+
+def substitute(s, values):
+    return str(s).format(**values)
+
+def expand(campaign):
+    # yield (experiment, size, threads, rep) in run order
+    for exp in campaign['experiments']:
+        reps = exp.get('reps', campaign.get('reps', 1))
+        threads = exp.get('threads', campaign.get('threads', [1]))
+        for size in exp.get('sizes', ['']):
+            for t in threads:
+                for rep in range(reps):
+                    yield exp, size, t, rep
+
+def parse_output(out):
+    rate = RATE_RE.search(out)
+    avg = TIME_RE.search(out)
+    energy = ENERGY_RE.search(out)
+    return {
+        'ok':      'Solution validates' in out and rate is not None,
+        'unit':    rate.group(1) if rate else None,
+        'rate':    float(rate.group(2)) if rate else None,
+        'avgtime': float(avg.group(1)) if avg else None,
+        'energy':  float(energy.group(1)) if energy else None,
+    }
+
+def cmd_run(args):
+    with open(args.campaign) as f:
+        campaign = json.load(f)
+    name = campaign.get('name', os.path.splitext(os.path.basename(args.campaign))[0])
+    fp = fingerprint()
+    tag = args.tag or '%s-%s-%s' % (name, fp['git_sha'][:8],
+                                     datetime.datetime.now().strftime('%Y%m%d-%H%M%S'))
+    store = Store(args.store)
+    points = list(expand(campaign))
+    print('Campaign %s: %d runs, tag %s' % (name, len(points), tag))
+    failures = 0
+    for n, (exp, size, t, rep) in enumerate(points):
+        values = dict(campaign.get('vars', {}))
+        values.update(exp.get('vars', {}))
+        values.update({'size': size, 'threads': t, 'iters': exp.get('iters', 10)})
+        command = substitute(exp['command'], values)
+        env = dict(os.environ)
+        for k, v in list(campaign.get('env', {}).items()) + list(exp.get('env', {}).items()):
+            env[k] = substitute(v, values)
+        t0 = time.time()
+        try:
+            p = subprocess.run(command, shell=True, cwd=ROOT, env=env, capture_output=True,
+                               text=True, timeout=args.timeout)
+            out = p.stdout + p.stderr
+        except subprocess.TimeoutExpired:
+            out = 'TIMEOUT'
+        res = parse_output(out)
+        rec = {'tag': tag, 'time': datetime.datetime.now().isoformat(timespec='seconds'),
+               'kernel': exp['kernel'], 'backend': exp.get('backend', ''), 'size': str(size),
+               'threads': t, 'rep': rep, 'command': command, 'fingerprint': fp}
+        rec.update(res)
+        store.add(rec)
+        status = ('%s %s' % (res['rate'], res['unit'])) if res['ok'] else 'FAILED'
+        print('[%d/%d] %-50s %s (%.1fs)' % (n+1, len(points), command, status, time.time()-t0))
+        if not res['ok']:
+            failures += 1
+            if args.verbose:
+                print(out)
+    print('Stored %d runs in %s (%d failed)' % (len(points), args.store, failures))
+    return 1 if failures else 0
+
+#########################################################################
+# Mann-Whitney U test
+#########################################################################
+
+def ranks(values):
+    # average ranks (1-based) with ties
+    order = sorted(range(len(values)), key=lambda i: values[i])
+    r = [0.0] * len(values)
+    i = 0
+    while i < len(order):
+        j = i
+        while j+1 < len(order) and values[order[j+1]] == values[order[i]]:
+            j += 1
+        for k in range(i, j+1):
+            r[order[k]] = (i + j) / 2.0 + 1.0
+        i = j + 1
+    return r
+
+def mann_whitney_less(x, y):
+    # p-value of the one-sided test that x tends to be smaller than y
+    n1, n2 = len(x), len(y)
+    r = ranks(list(x) + list(y))
+    u = sum(r[:n1]) - n1 * (n1 + 1) / 2.0
+    ties = len(set(x) | set(y)) < n1 + n2
+    if n1 * n2 <= 400 and not ties:
+        # exact distribution of U by counting
+        count = [[[0] * (n1 * n2 + 1) for _ in range(n2 + 1)] for _ in range(n1 + 1)]
+        for j in range(n2 + 1):
+            count[0][j][0] = 1
+        for i in range(1, n1 + 1):
+            count[i][0][0] = 1
+            for j in range(1, n2 + 1):
+                for k in range(i * j + 1):
+                    c = count[i][j-1][k]
+                    if k >= j:
+                        c += count[i-1][j][k-j]
+                    count[i][j][k] = c
+        total = math.comb(n1 + n2, n1)
+        return sum(count[n1][n2][:int(u) + 1]) / total
+    # normal approximation with tie and continuity corrections
+    n = n1 + n2
+    groups = {}
+    for v in list(x) + list(y):
+        groups[v] = groups.get(v, 0) + 1
+    tie = sum(t**3 - t for t in groups.values()) / (n * (n - 1))
+    sigma = math.sqrt(n1 * n2 / 12.0 * ((n + 1) - tie))
+    if sigma == 0:
+        return 1.0
+    z = (u - n1 * n2 / 2.0 + 0.5) / sigma
+    return 0.5 * math.erfc(-z / math.sqrt(2))
+
+def min_p(n1, n2):
+    # smallest p-value the exact test can give, i.e. for complete separation
+    return 1.0 / math.comb(n1 + n2, n1)
+
+def median(v):
+    s = sorted(v)
+    m = len(s) // 2
+    return s[m] if len(s) % 2 else 0.5 * (s[m-1] + s[m])
+
+def group(recs):
+    g = {}
+    for r in recs:
+        if r['ok'] and r['rate'] is not None:
+            g.setdefault((r['kernel'], r['backend'], r['size'], r['threads']), []).append(r['rate'])
+    return g
+
+def cmd_compare(args):
+    store = Store(args.store)
+    base = group(store.records(args.baseline))
+    cand = group(store.records(args.candidate))
+    if not base or not cand:
+        print('ERROR: no successful runs for %s' % (args.baseline if not base else args.candidate))
+        return 2
+    regressions = 0
+    underpowered = 0
+    print('%-12s %-14s %-16s %7s %12s %12s %8s %8s' %
+          ('Kernel', 'Backend', 'Size', 'Threads', 'Baseline', 'Candidate', 'Change', 'p'))
+    for key in sorted(set(base) & set(cand), key=str):
+        b, c = base[key], cand[key]
+        change = median(c) / median(b) - 1.0
+        p = mann_whitney_less(c, b)
+        flag = ''
+        if min_p(len(b), len(c)) >= args.alpha:
+            flag = '  too few runs'
+            underpowered += 1
+        elif p < args.alpha and change < -args.threshold:
+            flag = '  REGRESSION'
+            regressions += 1
+        elif mann_whitney_less(b, c) < args.alpha and change > args.threshold:
+            flag = '  improvement'
+        print('%-12s %-14s %-16s %7s %12.5g %12.5g %+7.1f%% %8.3g%s' %
+              (key[0], key[1], key[2], key[3], median(b), median(c), 100 * change, p, flag))
+    missing = set(base) ^ set(cand)
+    if missing:
+        print('%d points are only in one of the two tags' % len(missing))
+    if underpowered:
+        print('WARNING: %d point(s) have too few runs to reach p < %g; '
+              'use at least 5 runs per tag' % (underpowered, args.alpha))
+    print('%d regression(s) at alpha = %g' % (regressions, args.alpha))
+    return 1 if regressions else 0
+
+#########################################################################
+# scaling plots
+#########################################################################
+
+def cmd_plot(args):
+    store = Store(args.store)
+    recs = store.records(args.tag)
+    if not recs:
+        print('ERROR: no runs found')
+        return 2
+    os.makedirs(args.outdir, exist_ok=True)
+    units = {}
+    for r in recs:
+        if r['ok']:
+            units[(r['kernel'], r['backend'])] = r['unit']
+    curves = {}
+    for (kernel, backend, size, threads), rates in group(recs).items():
+        curves.setdefault((kernel, backend, size), []).append((threads, median(rates), min(rates), max(rates)))
+    try:
+        import matplotlib
+        matplotlib.use('Agg')
+        import matplotlib.pyplot as plt
+    except ImportError:
+        plt = None
+    kernels = sorted(set(k[0] for k in curves))
+    for kernel in kernels:
+        keys = sorted(k for k in curves if k[0] == kernel)
+        name = os.path.join(args.outdir, kernel)
+        if plt is None:
+            with open(name + '.csv', 'w') as f:
+                f.write('backend,size,threads,median,min,max\n')
+                for k in keys:
+                    for t, m, lo, hi in sorted(curves[k]):
+                        f.write('%s,%s,%s,%g,%g,%g\n' % (k[1], k[2], t, m, lo, hi))
+            print('Wrote %s.csv' % name)
+            continue
+        fig, ax = plt.subplots()
+        for k in keys:
+            pts = sorted(curves[k])
+            t = [p[0] for p in pts]
+            ax.errorbar(t, [p[1] for p in pts],
+                        yerr=[[p[1]-p[2] for p in pts], [p[3]-p[1] for p in pts]],
+                        marker='o', capsize=3, label='%s %s' % (k[1], k[2]))
+        ax.set_xscale('log', base=2)
+        ax.set_xlabel('threads')
+        ax.set_ylabel('Rate (%s)' % units.get(keys[0][:2], ''))
+        ax.set_title('%s%s' % (kernel, (' [' + args.tag + ']') if args.tag else ''))
+        ax.legend(fontsize='small')
+        fig.savefig(name + '.png', dpi=120)
+        plt.close(fig)
+        print('Wrote %s.png' % name)
+    return 0
+
+def cmd_list(args):
+    store = Store(args.store)
+    tags = {}
+    for r in store.records():
+        t = tags.setdefault(r['tag'], {'runs': 0, 'failed': 0, 'sha': r['fingerprint'].get('git_sha', ''),
+                                       'cpu': r['fingerprint'].get('cpu', '')})
+        t['runs'] += 1
+        t['failed'] += 0 if r['ok'] else 1
+    for tag, t in tags.items():
+        print('%-40s %5d runs %3d failed  %s  %s' % (tag, t['runs'], t['failed'], t['sha'][:12], t['cpu']))
+    return 0
+
+def main():
+    common = argparse.ArgumentParser(add_help=False)
+    common.add_argument('--store', default='results.jsonl',
+                        help='results file (JSON lines, or SQLite if it ends in .db or .sqlite)')
+    parser = argparse.ArgumentParser(description='Run, store and compare PRK benchmark campaigns.')
+    sub = parser.add_subparsers(dest='command', required=True)
+    p = sub.add_parser('run', parents=[common], help='run a campaign')
+    p.add_argument('campaign')
+    p.add_argument('--tag')
+    p.add_argument('--timeout', type=float, default=3600)
+    p.add_argument('--verbose', action='store_true', help='print the output of failed runs')
+    p = sub.add_parser('compare', parents=[common], help='test a candidate tag for regressions against a baseline tag')
+    p.add_argument('--baseline', required=True)
+    p.add_argument('--candidate', required=True)
+    p.add_argument('--alpha', type=float, default=0.05)
+    p.add_argument('--threshold', type=float, default=0.02,
+                   help='minimum relative change of the median rate (default 0.02)')
+    p = sub.add_parser('plot', parents=[common], help='plot rate versus threads')
+    p.add_argument('--tag')
+    p.add_argument('--outdir', default='plots')
+    sub.add_parser('list', parents=[common], help='list the tags in the store')
+    args = parser.parse_args()
+    return {'run': cmd_run, 'compare': cmd_compare, 'plot': cmd_plot, 'list': cmd_list}[args.command](args)
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -337,6 +337,25 @@ case "$PRK_TARGET" in
         $PRK_TARGET_PATH/dgemm-vector            10 400 400 # untiled
         $PRK_TARGET_PATH/dgemm-vector            10 400 32
         $PRK_TARGET_PATH/sparse-vector           10 10 5
+        ${MAKE} -C $PRK_TARGET_PATH sparse-spmm
+        $PRK_TARGET_PATH/sparse-spmm             10 8 5 8
+        ${MAKE} -C $PRK_TARGET_PATH stencil
+        for c in const double float ; do
+            for s in star grid ; do
+                $PRK_TARGET_PATH/stencil             10 200 32 $s 2 $c
+            done
+        done
+        ${MAKE} -C $PRK_TARGET_PATH nstream-indexed
+        for p in identity stride block window ; do
+            for f in gather scatter both ; do
+                $PRK_TARGET_PATH/nstream-indexed   10 1048576 $p $f
+            done
+        done
+        $PRK_TARGET_PATH/nstream-indexed     10 1048576 window both 4096 16
+        ${MAKE} -C $PRK_TARGET_PATH pic
+        $PRK_TARGET_PATH/pic                     10 1000 1000000 1 2 GEOMETRIC 0.99
+        $PRK_TARGET_PATH/pic                     10 1000 1000000 1 2 GEOMETRIC 0.99 rsqrt
+        $PRK_TARGET_PATH/pic                     10 1000 1000000 1 0 PATCH 0 200 100 200 rsqrt
         #echo "Test stencil code generator"
         for s in star grid ; do
             for r in 1 2 3 4 5 ; do
@@ -344,6 +363,23 @@ case "$PRK_TARGET" in
             done
         done
 
+        # C++11 with runtime instruction-set dispatch
+        ${MAKE} -C $PRK_TARGET_PATH dispatch
+        $PRK_TARGET_PATH/nstream-dispatch        10 16777216
+        $PRK_TARGET_PATH/stencil-dispatch        10 1000
+        $PRK_TARGET_PATH/transpose-dispatch      10 1024 32
+        $PRK_TARGET_PATH/p2p-dispatch            10 1024 1024
+        $PRK_TARGET_PATH/sparse-dispatch         10 10 5
+        $PRK_TARGET_PATH/sparse-compressed       10 10 5
+        PRK_ISA=generic $PRK_TARGET_PATH/nstream-dispatch 10 16777216
+
+        # C++11 with tiered memory placement (file-backed slow tier)
+        ${MAKE} -C $PRK_TARGET_PATH tiered
+        $PRK_TARGET_PATH/nstream-tiered          10 16777216 file:/tmp 4
+        $PRK_TARGET_PATH/stencil-tiered          10 1000 file:/tmp 4
+        $PRK_TARGET_PATH/sparse-tiered           10 10 5 file:/tmp 4
+        $PRK_TARGET_PATH/stencil-outofcore       10 1000 64 2 /tmp
+
         # C++11 with CBLAS
         if [ "${TRAVIS_OS_NAME}" = "osx" ] ; then
             echo "CBLASFLAG=-DACCELERATE -framework Accelerate -flax-conversions" >> common/make.defs
@@ -365,8 +401,29 @@ case "$PRK_TARGET" in
                 echo "CC=$PRK_CC -std=c99" >> common/make.defs
                 echo "OPENMPFLAG=-fopenmp" >> common/make.defs
                 ${MAKE} -C $PRK_TARGET_PATH p2p-tasks-openmp p2p-hyperplane-openmp stencil-openmp \
-                                            transpose-openmp nstream-openmp
+                                            transpose-openmp nstream-openmp transpose-simd-taskloop \
+                                            p2p-pipelined-tasks-openmp pic-deposit-openmp cg-openmp \
+                                            cholesky-tasks-openmp tensor-transpose-openmp \
+                                            latency-openmp bfs-openmp sort-openmp multigrid-openmp
                 $PRK_TARGET_PATH/p2p-tasks-openmp                 10 1024 1024 100 100
+                $PRK_TARGET_PATH/p2p-pipelined-tasks-openmp       10 1024 1024 100 100
+                $PRK_TARGET_PATH/transpose-simd-taskloop   10 1024 32 8
+                $PRK_TARGET_PATH/transpose-simd-taskloop   10 1000 64 4
+                for d in atomic private color sort ; do
+                    $PRK_TARGET_PATH/pic-deposit-openmp   10 1000 1000000 1 2 GEOMETRIC 0.99 $d
+                done
+                $PRK_TARGET_PATH/cg-openmp                 50 10 2
+                OMP_MAX_TASK_PRIORITY=2 $PRK_TARGET_PATH/cholesky-tasks-openmp 10 1024 64 2
+                for p in 0,2,1,3 3,2,1,0 1,0,3,2 ; do
+                    $PRK_TARGET_PATH/tensor-transpose-openmp 10 48,40,32,24 $p
+                done
+                $PRK_TARGET_PATH/tensor-transpose-openmp   10 8,6,10,4,12,6 5,3,1,4,0,2 16
+                $PRK_TARGET_PATH/latency-openmp            1000000 32K,1M,64M off,1000,0 1000000
+                $PRK_TARGET_PATH/bfs-openmp                10 10 2 all
+                $PRK_TARGET_PATH/sort-openmp               10 20
+                $PRK_TARGET_PATH/sort-openmp               10 20 11 20
+                $PRK_TARGET_PATH/multigrid-openmp          10 10
+                $PRK_TARGET_PATH/multigrid-openmp          10 10 6 1 0
                 $PRK_TARGET_PATH/p2p-hyperplane-openmp     10 1024
                 $PRK_TARGET_PATH/p2p-hyperplane-openmp     10 1024 64
                 $PRK_TARGET_PATH/stencil-openmp            10 1000
@@ -477,11 +534,13 @@ case "$PRK_TARGET" in
                 export LD_LIBRARY_PATH=${TBBROOT}/lib:${LD_LIBRARY_PATH}
                 ;;
         esac
-        ${MAKE} -C $PRK_TARGET_PATH p2p-innerloop-tbb p2p-hyperplane-tbb p2p-tasks-tbb stencil-tbb transpose-tbb nstream-tbb
+        ${MAKE} -C $PRK_TARGET_PATH p2p-innerloop-tbb p2p-hyperplane-tbb p2p-tasks-tbb stencil-tbb transpose-tbb nstream-tbb \
+                                    cholesky-tasks-tbb
         $PRK_TARGET_PATH/p2p-innerloop-tbb     10 1024
         $PRK_TARGET_PATH/p2p-hyperplane-tbb    10 1024 1
         $PRK_TARGET_PATH/p2p-hyperplane-tbb    10 1024 32
         $PRK_TARGET_PATH/p2p-tasks-tbb                10 1024 1024 32 32
+        $PRK_TARGET_PATH/cholesky-tasks-tbb    10 1024 64 2
         $PRK_TARGET_PATH/stencil-tbb           10 1000
         $PRK_TARGET_PATH/transpose-tbb         10 1024 32
         $PRK_TARGET_PATH/nstream-tbb           10 16777216 32
@@ -871,6 +930,11 @@ case "$PRK_TARGET" in
         $PRK_RUN $PRK_TARGET_PATH/Synch_p2p/p2p       10 1024 1024
         $PRK_RUN $PRK_TARGET_PATH/Stencil/stencil     10 1000
         $PRK_RUN $PRK_TARGET_PATH/Transpose/transpose 10 1024 32
+        $PRK_RUN $PRK_TARGET_PATH/Stencil/stencil     10 1000 lossless
+        $PRK_RUN $PRK_TARGET_PATH/Stencil/stencil     10 1000 lossy 1e-6
+        $PRK_RUN $PRK_TARGET_PATH/Transpose/transpose 10 1024 32 lossless
+        $PRK_RUN $PRK_TARGET_PATH/Transpose/transpose 10 1024 32 none 1e-6 sync
+        $PRK_RUN $PRK_TARGET_PATH/Transpose/transpose 10 1024 32 none 1e-6 async 2
         $PRK_RUN $PRK_TARGET_PATH/Reduce/reduce       10 16777216
         $PRK_RUN $PRK_TARGET_PATH/Nstream/nstream     10 16777216 32
         $PRK_RUN $PRK_TARGET_PATH/Sparse/sparse       10 10 5